@@ -10,6 +10,8 @@
 #include "cinder/framegraph/LUTNode.hpp"
 #include "cinder/framegraph/ColorGradeNode.hpp"
 #include "cinder/framegraph/VecNode.hpp"
+#include "cinder/framegraph/ProxyScale.hpp"
+#include "cinder/framegraph/DeferredUpdates.hpp"
 
 using namespace ci;
 using namespace ci::app;
@@ -23,7 +25,6 @@ public:
     ColorApp();
 
     void setup() override;
-    void resize() override;
     void mouseDrag( MouseEvent event ) override;
     void mouseDown( MouseEvent event ) override;
     void update() override;
@@ -42,6 +43,7 @@ private:
     TextureONode                    mOut, mLUTOut;
     LUTNode                         mLUT;
     ColorGradeNode                  mGrader;
+    StageGraph                      mStages;
 
     int							    mSplitX;
 
@@ -66,9 +68,7 @@ ColorApp::ColorApp() :
 #else
     mSrc( loadImage( getOpenFilePath( fs::path(), {"jpg", "png"} ) ) ),
 #endif
-    mLUTImage( loadImage( getAssetPath( "luts/K_TONE_Kodachrome.png" ) ) ),
-    mLUT( getWindowSize() ),
-    mGrader( getWindowSize() )
+    mLUTImage( loadImage( getAssetPath( "luts/K_TONE_Kodachrome.png" ) ) )
 {
     /***************************************************************************
      * Create node graph
@@ -85,6 +85,12 @@ ColorApp::ColorApp() :
     src >>                      mLUT >>                                 mLUTOut;
     mLUTImage >>                mLUT.in< 1 >();
 
+    mStages.link( mGrader, mOut ).link( mLUT, mLUTOut );
+    mStages.negotiateFormats();
+
+    // parameters changed by the interface between frames are applied together
+    DeferredUpdates::instance().setPerFrame( true );
+
     mGrade.exposure >>          mGrader.in< ColorGradeNode::exposure >();
     mGrade.lgg >>               mGrader.in< ColorGradeNode::LGG >();
     mGrade.temperature >>       mGrader.in< ColorGradeNode::temperature >();
@@ -118,64 +124,57 @@ void ColorApp::setup()
     mParams = params::InterfaceGl::create( getWindow(), "Color Grading", toPixels( ivec2( 200, 400 ) ) );
 
     mParams->addParam( "Exposure", &mGrade.exposure.get() )
-            .updateFn([&]() { mGrade.exposure.update(); })
+            .updateFn([&]() { mGrade.exposure.update(); ProxyScale::instance().interact(); })
             .min( -2.f ).max( 2.f )
             .step( 0.05f )
             ;
     mParams->addParam( "Lift", &mGrade.lgg.x() )
-            .updateFn([&]() { mGrade.lgg.update(); })
+            .updateFn([&]() { mGrade.lgg.requestUpdate(); ProxyScale::instance().interact(); })
             .min( -2.f ).max( 2.f )
             .step( 0.05f )
             ;
     mParams->addParam( "Gamma", &mGrade.lgg.y() )
-            .updateFn([&]() { mGrade.lgg.update(); })
+            .updateFn([&]() { mGrade.lgg.requestUpdate(); ProxyScale::instance().interact(); })
             .min( -2.f ).max( 2.f )
             .step( 0.05f )
             ;
     mParams->addParam( "Gain", &mGrade.lgg.z() )
-            .updateFn([&]() { mGrade.lgg.update(); })
+            .updateFn([&]() { mGrade.lgg.requestUpdate(); ProxyScale::instance().interact(); })
             .min( -2.f ).max( 2.f )
             .step( 0.05f )
             ;
     mParams->addParam( "Temperature", &mGrade.temperature.get() )
-            .updateFn([&]() { mGrade.temperature.update(); })
+            .updateFn([&]() { mGrade.temperature.update(); ProxyScale::instance().interact(); })
             .min( 1000 ).max( 40000 )
             .step( 100 )
             ;
     mParams->addParam( "Contrast", &mGrade.contrast.get() )
-            .updateFn([&]() { mGrade.contrast.update(); })
+            .updateFn([&]() { mGrade.contrast.update(); ProxyScale::instance().interact(); })
             .min( -2.f ).max( 2.f )
             .step( 0.05f )
             ;
     mParams->addParam( "Midtone Contrast", &mGrade.midtone_contrast.get() )
-            .updateFn([&]() { mGrade.midtone_contrast.update(); })
+            .updateFn([&]() { mGrade.midtone_contrast.update(); ProxyScale::instance().interact(); })
             .min( -2.f ).max( 2.f )
             .step( 0.05f )
             ;
     mParams->addParam( "Hue", &mGrade.hsv.x() )
-            .updateFn([&]() { mGrade.hsv.update(); })
+            .updateFn([&]() { mGrade.hsv.requestUpdate(); ProxyScale::instance().interact(); })
             .min( -2.f ).max( 2.f )
             .step( 0.05f )
             ;
     mParams->addParam( "Saturation", &mGrade.hsv.y() )
-            .updateFn([&]() { mGrade.hsv.update(); })
+            .updateFn([&]() { mGrade.hsv.requestUpdate(); ProxyScale::instance().interact(); })
             .min( -2.f ).max( 2.f )
             .step( 0.05f )
             ;
     mParams->addParam( "Value", &mGrade.hsv.z() )
-            .updateFn([&]() { mGrade.hsv.update(); })
+            .updateFn([&]() { mGrade.hsv.requestUpdate(); ProxyScale::instance().interact(); })
             .min( -2.f ).max( 2.f )
             .step( 0.05f )
             ;
 }
 
-void ColorApp::resize()
-{
-    auto size = getWindowSize();
-    mLUT.resize( size );
-    mGrader.resize( size );
-}
-
 void ColorApp::mouseDrag( MouseEvent event )
 {
     if ( event.isLeftDown() ) {
@@ -190,8 +189,19 @@ void ColorApp::mouseDown( MouseEvent event )
 
 void ColorApp::update()
 {
+    ProxyScale::instance().update();
+
+    // each side of the split only renders what it shows
+    float split = glm::clamp( mSplitX / (float)getWindowWidth(), 0.f, 1.f );
+    mOut.setRegionOfInterest( Rectf( 0.f, 0.f, split, 1.f ) );
+    mLUTOut.setRegionOfInterest( Rectf( split, 0.f, 1.f, 1.f ) );
+    mStages.propagateRegions();
+
     mSrc.update();
     mLUTImage.update();
+
+    // render each node once with this frame's source and parameter changes
+    DeferredUpdates::instance().flush();
 }
 
 void ColorApp::draw()
@@ -7,6 +7,7 @@
 #include "libnodes/operators.h"
 #include "cinder/framegraph/Types.hpp"
 #include "cinder/framegraph/FullScreenQuadRenderer.hpp"
+#include "cinder/framegraph/TextureStream.hpp"
 
 namespace cinder{
 namespace frame_graph {
@@ -57,8 +58,10 @@ private:
 };
 
 //! A node that represents a Cinder gl::Texture2d, useful for displaying
-//! results.
-class TextureONode : public Node< Inlets< gl::Texture2dRef, Surface32fRef >, Outlets<> >
+//! results. Declare the precision it needs with setInputPrecision() to have
+//! StageGraph pick float render targets upstream; LDR by default. Set its
+//! region of interest to what is displayed to have only that rendered.
+class TextureONode : public Node< Inlets< gl::Texture2dRef, Surface32fRef >, Outlets<> >, public RenderStage
 {
 public:
     static TextureONodeRef create()
@@ -68,7 +71,12 @@ public:
 
     TextureONode();
 
+    //! Uploads \a image into a texture kept for the stream, see
+    //! TextureStream.
     void update( const Surface32fRef & image );
+    void update( const ci::Surface8uRef & image );
+    //! Uploads pixels of any format TextureStream takes, e.g. half floats.
+    void update( const void * data, const ci::ivec2 & size, GLenum format, GLenum type, ptrdiff_t rowBytes );
     void update( const gl::Texture2dRef & texture );
 
     void clear() { mTexture = nullptr; }
@@ -79,8 +87,8 @@ public:
 
     ci::ivec2 getSize() const { return mTexture->getSize(); }
 private:
-
     ci::gl::Texture2dRef	mTexture = nullptr;
+    TextureStream           mStream;
 };
 
 class TextureIONode : public Node< Inlets< gl::Texture2dRef >, Outlets< gl::Texture2dRef > >
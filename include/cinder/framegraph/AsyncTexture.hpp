@@ -0,0 +1,77 @@
+#pragma once
+
+#include "cinder/FrameGraph.hpp"
+#include "cinder/DataSource.h"
+#include "cinder/Filesystem.h"
+#include "cinder/gl/Sync.h"
+#include <atomic>
+#include <string>
+
+namespace cinder {
+namespace frame_graph {
+
+typedef ref< class AsyncTextureINode > AsyncTextureINodeRef;
+
+//! A TextureINode that decodes its image on the ThreadPool instead of the
+//! constructing thread, so graphs referencing many large stills build
+//! without stalling. Decoded images are uploaded on the ShaderCompiler's
+//! background context, so the render thread never copies pixels, and
+//! update() emits the placeholder, if there is one, until the upload's fence
+//! has signaled, then the image from then on. Without a background context
+//! the image is uploaded from update(). Loads that haven't finished when
+//! the node is destroyed are cancelled.
+class AsyncTextureINode : public TextureINode
+{
+public:
+    static AsyncTextureINodeRef create( const ci::DataSourceRef & source, const gl::Texture2dRef & placeholder = nullptr )
+    {
+        return std::make_shared< AsyncTextureINode >( source, placeholder );
+    }
+
+    static AsyncTextureINodeRef create( const ci::fs::path & path, const gl::Texture2dRef & placeholder = nullptr )
+    {
+        return std::make_shared< AsyncTextureINode >( ci::loadFile( path ), placeholder );
+    }
+
+    AsyncTextureINode( const ci::DataSourceRef & source, const gl::Texture2dRef & placeholder = nullptr );
+    ~AsyncTextureINode();
+
+    virtual void update() override;
+
+    bool isLoading() const { return mJob != nullptr; }
+    bool isLoaded() const { return mLoaded; }
+    //! Why the image couldn't be loaded, or empty.
+    const std::string & getError() const { return mError; }
+
+    //! The size of the image once loaded, or of the placeholder before.
+    ci::ivec2 getSize() const;
+
+    //! Emitted from update() with the texture once it is uploaded.
+    ci::signals::Signal< void( const gl::Texture2dRef & ) > & getSignalLoaded() { return mSignalLoaded; }
+
+private:
+    //! Shared with the worker, so a cancelled load finishes harmlessly.
+    struct Job {
+        std::atomic< bool > cancelled{ false };
+        std::atomic< bool > done{ false };
+        std::atomic< bool > uploaded{ false };
+        ci::Surface8uRef    surface8u;
+        ci::Surface32fRef   surface32f;
+        std::string         error;
+        gl::Texture2dRef    texture;
+        gl::SyncRef         fence;
+    };
+
+    static void upload( Job & job );
+    void finish();
+
+    std::shared_ptr< Job >                                      mJob;
+    bool                                                        mUploading = false;
+    gl::Texture2dRef                                            mPlaceholder;
+    bool                                                        mLoaded = false;
+    std::string                                                 mError;
+    ci::signals::Signal< void( const gl::Texture2dRef & ) >     mSignalLoaded;
+};
+
+}
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "cinder/FrameGraph.hpp"
+#include "cinder/framegraph/DeferredUpdates.hpp"
 
 namespace cinder {
 namespace frame_graph {
@@ -9,7 +10,8 @@ namespace frame_graph {
 //! Inlets except temperature expect values in the range of roughly -2 to +2.
 //! 0 means no change, > 0 is more of the effect, and < 0 is less of the effect.
 //! Temperature takes degrees Kelvin, and is designed to be used with values
-//! between 1000K and 40,000K.
+//! between 1000K and 40,000K. Parameter changes re-render the last frame;
+//! within DeferredUpdates batches, at most once per batch.
 class ColorGradeNode :
         public FullScreenQuadRenderer< 1 >,
         public Node< Inlets<
@@ -35,8 +37,32 @@ public:
     };
 
 
-    explicit ColorGradeNode( const ci::ivec2 & size );
+    //! A \a size of zero follows the size of the source.
+    explicit ColorGradeNode( const ci::ivec2 & size = ci::ivec2( 0 ) );
+    ~ColorGradeNode();
 
+private:
+    //! The grade as laid out in the shader's std140 uniform block. Each
+    //! adjustment is enabled by the bit of its inlet once it has a value.
+    struct Params {
+        vec3        lgg;
+        float       exposure;
+        vec3        hsv;
+        float       temperature;
+        float       contrast;
+        float       midtoneContrast;
+        uint32_t    enabled;
+        float       padding;
+    };
+    static_assert( sizeof( Params ) == 48, "ColorGradeNode::Params must match the std140 layout" );
+
+    //! Renders now, or once at the end of the current batch of updates.
+    void requestRender();
+
+    void setParameter( inlet_names name, float v );
+    void setParameter( inlet_names name, const vec3 & v );
+
+    UniformBlock< Params >  mParams;
 };
 
 }
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "cinder/FrameGraph.hpp"
+#include <functional>
+#include <vector>
+
+namespace cinder {
+namespace frame_graph {
+
+enum class CurveInterpolation {
+    STEP,
+    LINEAR,
+    BEZIER
+};
+
+//! A key of a Curve. The interpolation applies to the segment starting at
+//! this key. Bezier handles are offsets in value from their key, so each
+//! segment is a cubic in normalized time.
+struct Keyframe {
+    double              time = 0.0;
+    float               value = 0.f;
+    CurveInterpolation  interpolation = CurveInterpolation::LINEAR;
+    float               inHandle = 0.f;
+    float               outHandle = 0.f;
+};
+
+//! A parameter animated over time. Each segment is stored as a cubic in
+//! normalized time, and the segment of the last evaluation is cached, so
+//! playback evaluates in constant time and seeks by binary search. Values
+//! hold before the first key and after the last.
+class Curve
+{
+public:
+    //! A segment as ((a * u + b) * u + c) * u + d, with
+    //! u = clamp( ( t - t0 ) * invDuration, 0, 1 ). The start time stays in
+    //! double precision, so short ramps hours into a show are smooth.
+    struct Segment {
+        double  t0 = 0.0;
+        float   invDuration = 0.f;
+        float   a = 0.f;
+        float   b = 0.f;
+        float   c = 0.f;
+        float   d = 0.f;
+    };
+
+    Curve() { setKeys( {} ); }
+    explicit Curve( std::vector< Keyframe > keys ) { setKeys( std::move( keys ) ); }
+
+    //! Sorts \a keys by time.
+    void setKeys( std::vector< Keyframe > keys );
+    const std::vector< Keyframe > & getKeys() const { return mKeys; }
+
+    float evaluate( double time ) const;
+
+    //! Returns the index of the segment containing \a time: 0 before the
+    //! first key, i between keys i - 1 and i, the number of keys after the
+    //! last.
+    size_t findSegment( double time ) const;
+    const Segment & getSegment( size_t i ) const { return mSegments[ i ]; }
+
+    static float evaluate( const Segment & segment, double time );
+
+private:
+    bool contains( size_t segment, double time ) const;
+
+    std::vector< Keyframe > mKeys;
+    std::vector< Segment >  mSegments;
+    mutable size_t          mCached = 0;
+};
+
+typedef ref< class CurveNode > CurveNodeRef;
+
+//! Emits the value of a curve at the time received on its inlet, only when
+//! the value changes, so constant stretches between keys cost nothing
+//! downstream.
+class CurveNode : public Node< Inlets< double >, Outlets< float > >
+{
+public:
+    static CurveNodeRef create( const Curve & curve )
+    {
+        return std::make_shared< CurveNode >( curve );
+    }
+
+    explicit CurveNode( const Curve & curve = Curve() );
+
+    //! Replaces the curve. The next evaluation emits.
+    void setCurve( const Curve & curve );
+    const Curve & getCurve() const { return mCurve; }
+
+    //! Evaluates the curve at \a time, emitting if the value changed.
+    void setTime( double time );
+
+    float getValue() const { return mValue; }
+
+private:
+    Curve   mCurve;
+    float   mValue = 0.f;
+    bool    mEmitted = false;
+};
+
+//! Evaluates many curves at once, for scenes with hundreds or thousands of
+//! animated parameters. Segment coefficients are kept in separate arrays
+//! and evaluated eight curves at a time with AVX2 when the CPU supports
+//! it. Segment start times are kept relative to a double precision origin
+//! near the evaluation time, so narrowing them to single precision keeps
+//! microsecond resolution at any show time.
+class CurveBank
+{
+public:
+    //! Adds \a curve and returns its index.
+    size_t add( const Curve & curve );
+    void setCurve( size_t i, const Curve & curve );
+    const Curve & getCurve( size_t i ) const { return mCurves[ i ]; }
+
+    size_t size() const { return mCurves.size(); }
+
+    //! Evaluates every curve at \a time and calls \a changed with the index
+    //! and value of each whose value differs from the last evaluation. All
+    //! curves report on the first evaluation.
+    void evaluate( double time, const std::function< void( size_t, float ) > & changed );
+
+    float getValue( size_t i ) const { return mValues[ i ]; }
+
+    //! Allows vectorized evaluation. Disable to run the scalar reference.
+    void setSimd( bool enabled ) { mSimd = enabled; }
+    bool isSimdActive() const;
+
+private:
+    void setSegment( size_t i, size_t segment );
+    void rebase( double origin );
+
+    std::vector< Curve >    mCurves;
+    std::vector< size_t >   mSegments;
+    //! Segment start times, and the same relative to mOrigin.
+    std::vector< double >   mStart;
+    double                  mOrigin = 0.0;
+    std::vector< float >    mT0, mInvDuration, mA, mB, mC, mD;
+    std::vector< float >    mValues;
+    std::vector< float >    mResults;
+    std::vector< uint32_t > mChangedBlocks;
+    bool                    mSimd = true;
+};
+
+}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+namespace cinder {
+namespace frame_graph {
+
+//! Coalesces node updates so a node renders at most once however many
+//! messages it receives. Nodes hand their work to defer() keyed by
+//! themselves; outside a batch it runs immediately, inside one it is queued
+//! once per node and run by flush(), after every parameter has arrived.
+//!
+//! Batch a whole frame by enabling per-frame mode and flushing after the
+//! sources have updated, or a group of changes such as a preset recall
+//! with a ScopedDeferredUpdates. Main thread only.
+class DeferredUpdates
+{
+public:
+    static DeferredUpdates & instance();
+
+    //! Queues all updates until the next flush().
+    void setPerFrame( bool enabled );
+    bool isPerFrame() const { return mPerFrame; }
+
+    bool isDeferring() const { return mPerFrame || mDepth > 0; }
+
+    //! Runs \a update now, or once at the next flush if \a node hasn't
+    //! queued an update already.
+    void defer( const void * node, std::function< void() > update );
+
+    //! Drops the queued update of \a node. Nodes call this when destroyed.
+    void cancel( const void * node );
+
+    //! Runs the queued updates in the order they were first queued,
+    //! including updates they queue in turn.
+    void flush();
+
+    //! Starts a batch. Batches nest; the outermost end() flushes unless in
+    //! per-frame mode.
+    void begin() { ++mDepth; }
+    void end();
+
+private:
+    struct Update {
+        const void *            node;
+        std::function< void() > fn;
+    };
+
+    DeferredUpdates() {}
+
+    bool                                mPerFrame = false;
+    int                                 mDepth = 0;
+    std::vector< Update >               mQueue;
+    std::unordered_set< const void * >  mQueued;
+};
+
+//! Defers updates for its lifetime.
+class ScopedDeferredUpdates
+{
+public:
+    ScopedDeferredUpdates() { DeferredUpdates::instance().begin(); }
+    ~ScopedDeferredUpdates() { DeferredUpdates::instance().end(); }
+
+    ScopedDeferredUpdates( const ScopedDeferredUpdates & ) = delete;
+    ScopedDeferredUpdates & operator=( const ScopedDeferredUpdates & ) = delete;
+};
+
+}
+}
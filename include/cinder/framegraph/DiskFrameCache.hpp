@@ -0,0 +1,122 @@
+#pragma once
+
+#include "cinder/framegraph/FrameCache.hpp"
+#include "cinder/Exception.h"
+#include "cinder/Filesystem.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace cinder {
+namespace frame_graph {
+
+class DiskFrameCacheExc : public ci::Exception
+{
+public:
+    DiskFrameCacheExc( const std::string & description ) : ci::Exception( description ) {}
+};
+
+//! The disk tier of a FrameCacheNode, for timelines longer than memory
+//! holds. Frames are written behind on a thread into a memory-mapped file
+//! used as a circular log, overwriting the oldest, and hits are read
+//! straight from the mapping. The index is saved next to the file when the
+//! cache is destroyed and loaded by the next session, and removed while
+//! the cache is open, so a crash loses the cache rather than corrupting it.
+//! Put the file on a fast local disk.
+class DiskFrameCache
+{
+public:
+    class Format
+    {
+    public:
+        Format() {}
+
+        //! The size of the file. Defaults to 16 GB.
+        Format & capacity( uint64_t bytes ) { mCapacity = bytes; return *this; }
+        uint64_t getCapacity() const { return mCapacity; }
+
+    private:
+        uint64_t    mCapacity = 16ull << 30;
+    };
+
+    struct Entry {
+        FrameCacheKey   key;
+        ci::ivec2       size;
+        ci::ivec2       fullSize;
+        bool            topDown = true;
+        //! The FrameCacheNode::Storage of the data.
+        uint8_t         storage = 0;
+        uint64_t        offset = 0;
+        uint64_t        bytes = 0;
+    };
+
+    //! Maps \a path, creating it or reusing the frames of a previous session.
+    //! Throws DiskFrameCacheExc.
+    static DiskFrameCacheRef create( const ci::fs::path & path, const Format & format = Format() )
+    {
+        return std::make_shared< DiskFrameCache >( path, format );
+    }
+
+    DiskFrameCache( const ci::fs::path & path, const Format & format = Format() );
+    //! Finishes pending writes and saves the index.
+    ~DiskFrameCache();
+
+    //! Queues \a data, described by \a entry, to be written behind.
+    void write( const Entry & entry, std::vector< uint8_t > data );
+
+    //! Calls \a fn with the frame \a key, which can't be overwritten while
+    //! \a fn runs, and returns what it returns. Returns false if there
+    //! isn't one.
+    bool read( const FrameCacheKey & key, const std::function< bool( const Entry &, const uint8_t * ) > & fn );
+    bool contains( const FrameCacheKey & key ) const;
+
+    //! Waits for pending writes.
+    void flush();
+    void clear();
+
+    size_t getFrameCount() const;
+    size_t getPendingCount() const;
+    uint64_t getCapacity() const { return mCapacity; }
+
+private:
+    struct Pending {
+        Entry                   entry;
+        std::vector< uint8_t >  data;
+    };
+
+    void map();
+    void unmap();
+    void writeThread();
+    //! Reserves space for \a bytes, forgetting the frames it overlaps.
+    uint64_t reserve( uint64_t bytes );
+    void loadIndex();
+    void saveIndex() const;
+    ci::fs::path getIndexPath() const;
+
+    ci::fs::path                                                        mPath;
+    uint64_t                                                            mCapacity;
+    uint8_t *                                                           mData = nullptr;
+#if defined( _WIN32 )
+    void *                                                              mFile = nullptr;
+    void *                                                              mMapping = nullptr;
+#else
+    int                                                                 mFile = -1;
+#endif
+
+    mutable std::mutex                                                  mMutex;
+    std::condition_variable                                             mCV;
+    std::condition_variable                                             mIdleCV;
+    std::unordered_map< FrameCacheKey, Entry, FrameCacheKeyHash >       mEntries;
+    std::map< uint64_t, FrameCacheKey >                                 mOffsets;
+    uint64_t                                                            mHead = 0;
+    std::deque< Pending >                                               mPending;
+    bool                                                                mRun = true;
+    std::thread                                                         mThread;
+};
+
+}
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include "cinder/FrameGraph.hpp"
+#include <memory>
+
+namespace cinder {
+namespace frame_graph {
+
+typedef ref< class BlurNode >       BlurNodeRef;
+typedef ref< class PyramidNode >    PyramidNodeRef;
+typedef ref< class UpsampleNode >   UpsampleNodeRef;
+typedef ref< class BloomNode >      BloomNodeRef;
+
+////////////////////////////////////////////////////////////////////////////////
+// Kernels
+
+//! Returns a symmetric kernel: element 0 weights the center tap and element i
+//! the taps at +i and -i. The weights sum to one. The Gaussian falls off to
+//! three standard deviations at \a radius.
+std::vector< float > gaussianKernel( float radius );
+std::vector< float > boxKernel( float radius );
+
+//! Folds pairs of neighbouring taps of \a kernel into single bilinear
+//! fetches, halving the number of texture reads.
+void linearKernel( const std::vector< float > & kernel, std::vector< float > * offsets, std::vector< float > * weights );
+
+////////////////////////////////////////////////////////////////////////////////
+// CPU reference
+
+//! CPU versions of the filter passes. They sample like a GL_LINEAR texture
+//! clamped to its edges, so results match the GPU nodes closely enough to
+//! test them against.
+
+vec4 sampleBilinear( const Surface32f & surface, const vec2 & uv );
+
+//! One pass of a separable filter. \a step is the distance between taps in
+//! normalized coordinates, e.g. ( 1 / width, 0 ) for a horizontal pass.
+Surface32f convolveSurface( const Surface32f & surface, const std::vector< float > & offsets, const std::vector< float > & weights, const vec2 & step );
+
+//! Halves \a surface with a 4x4 box.
+Surface32f downsampleSurface( const Surface32f & surface );
+
+//! Scales color by how far its brightest channel is above \a threshold.
+void thresholdSurface( Surface32f & surface, float threshold );
+
+//! Returns \a base * \a baseWeight + tent-filtered \a low * \a intensity at
+//! the size of \a base.
+Surface32f upsampleSurface( const Surface32f & base, const Surface32f & low, float baseWeight, float intensity, bool keepBaseAlpha = false );
+
+////////////////////////////////////////////////////////////////////////////////
+// FilterPass
+
+//! One full screen pass of a multi-pass filter, rendering into its own
+//! automatically sized target.
+template< std::size_t I = 1 >
+class FilterPass : public FullScreenQuadRenderer< I >
+{
+public:
+    FilterPass( const SharedProgramRef & shader, float sizeScale = 1.f ) :
+        FullScreenQuadRenderer< I >( shader, ci::ivec2( 0 ) ),
+        mFullTexelSize( this->getUniformHandle( "uFullTexelSize" ) )
+    {
+        this->setAutoSizeScale( sizeScale );
+    }
+
+    //! Renders \a textures, bound in order.
+    ci::gl::Texture2dRef apply( std::initializer_list< ci::gl::Texture2dRef > textures )
+    {
+        std::size_t i = 0;
+        for ( auto & tex : textures ) this->setTexture( i++, tex );
+
+        // kernels are specified in full resolution texels so filters look
+        // the same at proxy scale
+        this->setUniform( mFullTexelSize, ci::vec2( 1.f ) / ci::vec2( ProxyScale::instance().getFullSize( *textures.begin() ) ) );
+
+        return this->render();
+    }
+
+private:
+    std::size_t mFullTexelSize;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// BlurNode
+
+//! A separable Gaussian or box blur. The kernel is baked into the shaders
+//! when the node is created. Blurs wider than Format::maxPassRadius() are
+//! run on a copy downsampled until the kernel fits and then upsampled, so a
+//! 64 pixel blur at 4K costs a few passes over small images instead of
+//! hundreds of taps per pixel.
+class BlurNode :
+        public FullScreenQuadRenderer< 2 >,
+        public Node< Inlets< gl::Texture2dRef >, Outlets< gl::Texture2dRef > >
+{
+public:
+    enum class Kernel {
+        GAUSSIAN,
+        BOX
+    };
+
+    class Format
+    {
+    public:
+        Format() {}
+
+        //! Sets the radius in full resolution pixels. Defaults to 8.
+        Format & radius( float radius ) { mRadius = radius; return *this; }
+        float getRadius() const { return mRadius; }
+
+        Format & kernel( Kernel kernel ) { mKernel = kernel; return *this; }
+        Kernel getKernel() const { return mKernel; }
+
+        //! Sets the widest radius blurred at full resolution. Defaults to 8.
+        Format & maxPassRadius( float radius ) { mMaxPassRadius = radius; return *this; }
+        float getMaxPassRadius() const { return mMaxPassRadius; }
+
+    private:
+        float   mRadius = 8.f;
+        Kernel  mKernel = Kernel::GAUSSIAN;
+        float   mMaxPassRadius = 8.f;
+    };
+
+    static BlurNodeRef create( const Format & format = Format() )
+    {
+        return std::make_shared< BlurNode >( format );
+    }
+
+    BlurNode( const Format & format = Format() );
+
+    const Format & getFormat() const { return mFormat; }
+
+    //! Returns the number of times the input is halved before blurring.
+    int getLevels() const { return (int)mDownsample.size(); }
+
+    void setOutputFormat( RenderFormat format ) override;
+
+    virtual void update( const gl::Texture2dRef & texture );
+
+    //! Runs the same passes on the CPU.
+    Surface32f process( const Surface32f & image ) const;
+
+private:
+    Format                                          mFormat;
+    std::vector< float >                            mOffsets;
+    std::vector< float >                            mWeights;
+    std::vector< std::unique_ptr< FilterPass<> > >  mDownsample;
+    std::unique_ptr< FilterPass<> >                 mBlurH;
+    std::unique_ptr< FilterPass<> >                 mBlurV;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// PyramidNode
+
+//! Emits successively halved copies of its input, level 0 being half size.
+class PyramidNode :
+        public RenderStage,
+        public Node< Inlets< gl::Texture2dRef >, Outlets< std::vector< gl::Texture2dRef > > >
+{
+public:
+    static PyramidNodeRef create( int levels = 6 )
+    {
+        return std::make_shared< PyramidNode >( levels );
+    }
+
+    explicit PyramidNode( int levels = 6 );
+
+    int getNumLevels() const { return (int)mPasses.size(); }
+    const gl::Texture2dRef & getLevel( int i ) const { return mLevels.at( i ); }
+
+    void setOutputFormat( RenderFormat format ) override;
+
+    virtual void update( const gl::Texture2dRef & texture );
+
+    //! Builds the same levels on the CPU.
+    std::vector< Surface32f > process( const Surface32f & image ) const;
+
+private:
+    std::vector< std::unique_ptr< FilterPass<> > >  mPasses;
+    std::vector< gl::Texture2dRef >                 mLevels;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// UpsampleNode
+
+//! Tent-filters a low resolution input up to the size of a base input and
+//! adds them: base * baseWeight + low * intensity. Renders when the low
+//! resolution input arrives, so connect the base first.
+class UpsampleNode :
+        public FullScreenQuadRenderer< 2 >,
+        public Node< Inlets<
+                gl::Texture2dRef,   // base
+                gl::Texture2dRef,   // low resolution
+                float               // intensity
+        >, Outlets< gl::Texture2dRef > >
+{
+public:
+    static UpsampleNodeRef create( float baseWeight = 1.f )
+    {
+        return std::make_shared< UpsampleNode >( baseWeight );
+    }
+
+    explicit UpsampleNode( float baseWeight = 1.f );
+
+    virtual void update();
+
+    Surface32f process( const Surface32f & base, const Surface32f & low ) const;
+
+private:
+    float   mBaseWeight;
+    float   mIntensity = 1.f;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// BloomNode
+
+//! Adds a glow around values above a threshold. The bright parts are
+//! downsampled into a pyramid and collapsed back up with tent filters, which
+//! gives a wide, smooth falloff for the cost of a few passes over small
+//! images.
+class BloomNode :
+        public FullScreenQuadRenderer< 2 >,
+        public Node< Inlets<
+                gl::Texture2dRef,
+                float,  // intensity
+                float   // threshold
+        >, Outlets< gl::Texture2dRef > >
+{
+public:
+    class Format
+    {
+    public:
+        Format() {}
+
+        //! Sets the number of pyramid levels. Defaults to 5.
+        Format & levels( int levels ) { mLevels = levels; return *this; }
+        int getLevels() const { return mLevels; }
+
+        Format & intensity( float intensity ) { mIntensity = intensity; return *this; }
+        float getIntensity() const { return mIntensity; }
+
+        Format & threshold( float threshold ) { mThreshold = threshold; return *this; }
+        float getThreshold() const { return mThreshold; }
+
+    private:
+        int     mLevels = 5;
+        float   mIntensity = 0.5f;
+        float   mThreshold = 1.f;
+    };
+
+    static BloomNodeRef create( const Format & format = Format() )
+    {
+        return std::make_shared< BloomNode >( format );
+    }
+
+    BloomNode( const Format & format = Format() );
+
+    virtual void update( const gl::Texture2dRef & texture );
+
+    Surface32f process( const Surface32f & image ) const;
+
+private:
+    Format                                              mFormat;
+    std::unique_ptr< FilterPass<> >                     mPrefilter;
+    std::vector< std::unique_ptr< FilterPass<> > >      mDownsample;
+    std::vector< std::unique_ptr< FilterPass< 2 > > >   mUpsample;
+};
+
+}
+}
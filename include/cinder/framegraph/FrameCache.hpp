@@ -0,0 +1,187 @@
+#pragma once
+
+#include "cinder/FrameGraph.hpp"
+#include "cinder/gl/Pbo.h"
+#include "cinder/gl/Sync.h"
+#include <deque>
+#include <list>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace cinder {
+namespace frame_graph {
+
+typedef ref< class FrameCacheNode > FrameCacheNodeRef;
+typedef ref< class DiskFrameCache > DiskFrameCacheRef;
+
+//! Hashes parameter values into the state part of a FrameCacheNode key.
+//! Values are hashed by their bytes, so they must be trivially copyable.
+class StateHash
+{
+public:
+    template< typename T >
+    StateHash & add( const T & value )
+    {
+        static_assert( std::is_trivially_copyable< T >::value, "StateHash hashes values by their bytes" );
+        const unsigned char * bytes = reinterpret_cast< const unsigned char * >( &value );
+        for ( size_t i = 0; i < sizeof( T ); ++i ) {
+            mHash = ( mHash ^ bytes[ i ] ) * 1099511628211ull;
+        }
+        return *this;
+    }
+
+    StateHash & add( const std::string & value )
+    {
+        for ( unsigned char c : value ) mHash = ( mHash ^ c ) * 1099511628211ull;
+        return *this;
+    }
+
+    uint64_t get() const { return mHash; }
+    operator uint64_t() const { return mHash; }
+
+private:
+    uint64_t    mHash = 14695981039346656037ull;
+};
+
+//! Identifies a cached frame by the source time it shows and a hash of the
+//! parameters it was rendered with.
+struct FrameCacheKey {
+    double      time = 0.0;
+    uint64_t    state = 0;
+
+    bool operator==( const FrameCacheKey & other ) const { return time == other.time && state == other.state; }
+};
+
+struct FrameCacheKeyHash {
+    size_t operator()( const FrameCacheKey & key ) const
+    {
+        return (size_t)StateHash().add( key.time ).add( key.state ).get();
+    }
+};
+
+//! Keeps frames that passed through it in memory, keyed by the source time
+//! they show and a hash of the parameters upstream, so scrubbing back over
+//! them doesn't render them again. Frames are read back and stored at the
+//! precision of Format::storage() within a byte budget, evicting the least
+//! recently used. Readbacks go through pixel buffers and a frame is only
+//! stored once its fence signals, a frame or two later, so storing never
+//! stalls the pipeline.
+//!
+//! The graph pushes frames from its sources, so the cache can only skip
+//! the nodes upstream if it is asked before they update:
+//!
+//!     cache.setKey( { movie.getElapsedTime(), StateHash().add( lift ).add( gain ) } );
+//!     if ( ! cache.present() ) movie.update();   // a miss renders and stores
+//!
+//! With a DiskFrameCache, frames evicted from memory are written behind to
+//! disk and hits there are uploaded straight from the mapped file.
+class FrameCacheNode : public Node< Inlets< gl::Texture2dRef >, Outlets< gl::Texture2dRef > >
+{
+public:
+    enum class Storage {
+        FLOAT,  //!< 16 bytes a pixel
+        HALF,   //!< 8 bytes a pixel, enough for HDR
+        BYTE    //!< 4 bytes a pixel, for display-referred frames
+    };
+
+    class Format
+    {
+    public:
+        Format() {}
+
+        //! The most memory stored frames may use. Defaults to 512 MB.
+        Format & budget( size_t bytes ) { mBudget = bytes; return *this; }
+        size_t getBudget() const { return mBudget; }
+
+        Format & storage( Storage storage ) { mStorage = storage; return *this; }
+        Storage getStorage() const { return mStorage; }
+
+        //! Spills frames evicted from memory to \a disk.
+        Format & disk( const DiskFrameCacheRef & disk ) { mDisk = disk; return *this; }
+        const DiskFrameCacheRef & getDisk() const { return mDisk; }
+
+    private:
+        size_t              mBudget = 512 << 20;
+        Storage             mStorage = Storage::HALF;
+        DiskFrameCacheRef   mDisk;
+    };
+
+    typedef FrameCacheKey Key;
+
+    struct Stats {
+        uint64_t    hits = 0;
+        uint64_t    diskHits = 0;
+        uint64_t    misses = 0;
+        uint64_t    evictions = 0;
+    };
+
+    static FrameCacheNodeRef create( const Format & format = Format() )
+    {
+        return std::make_shared< FrameCacheNode >( format );
+    }
+
+    explicit FrameCacheNode( const Format & format = Format() );
+
+    //! Sets the key frames received next are stored under.
+    void setKey( const Key & key ) { mKey = key; }
+    const Key & getKey() const { return mKey; }
+
+    //! Emits the frame stored for the current key and returns true, or
+    //! returns false so the caller updates the graph upstream.
+    bool present();
+    bool contains( const Key & key ) const { return mIndex.count( key ) > 0; }
+
+    //! Stores frames whose readback has completed. Called by present() and
+    //! for every frame received.
+    void poll();
+
+    //! Changes the budget, evicting frames that no longer fit.
+    void setBudget( size_t bytes );
+    void clear();
+
+    size_t getBytes() const { return mBytes; }
+    size_t getFrameCount() const { return mFrames.size(); }
+    const Stats & getStats() const { return mStats; }
+
+private:
+    struct Frame {
+        Key                     key;
+        ci::ivec2               size;
+        ci::ivec2               fullSize;
+        bool                    topDown;
+        std::vector< uint8_t >  data;
+    };
+
+    typedef std::list< Frame > FrameList;
+
+    struct Readback {
+        Frame       frame;
+        gl::PboRef  pbo;
+        gl::SyncRef sync;
+    };
+
+    void store( const gl::Texture2dRef & texture );
+    bool isPending( const Key & key ) const;
+    void insert( Frame frame );
+    void evict( size_t bytes );
+    bool presentFromDisk();
+    void upload( const uint8_t * data, const ci::ivec2 & size, const ci::ivec2 & fullSize, bool topDown );
+
+    GLenum getDataType() const;
+    size_t getBytesPerPixel() const;
+
+    Format                                                          mFormat;
+    Key                                                             mKey;
+    FrameList                                                       mFrames;    // most recently used first
+    std::unordered_map< Key, FrameList::iterator, FrameCacheKeyHash > mIndex;
+    size_t                                                          mBytes = 0;
+    std::deque< Readback >                                          mPending;
+    std::vector< gl::PboRef >                                       mFreePbos;
+    gl::Texture2dRef                                                mTexture;
+    Stats                                                           mStats;
+};
+
+}
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "cinder/FrameGraph.hpp"
+#include <functional>
+#include <vector>
+
+namespace cinder {
+namespace frame_graph {
+
+typedef ref< class FrameHistoryNode > FrameHistoryNodeRef;
+typedef ref< class SurfaceHistoryNode > SurfaceHistoryNodeRef;
+
+//! Keeps the last frames of its input for temporal effects like delays,
+//! echoes, trails and frame averaging. Frames are blitted into a
+//! GL_TEXTURE_2D_ARRAY allocated once, one layer per frame, used as a ring,
+//! so pushing a frame costs one blit and no allocation. The input is passed
+//! on after it has been pushed, so stages downstream of the node that
+//! attach() to it see the history including the current frame:
+//!
+//!     source >> history >> echo;
+//!     history.attach( echo );
+//!
+//! with the shader of echo declaring getGlsl() and sampling
+//! history( uv, age ).
+class FrameHistoryNode : public Node< Inlets< gl::Texture2dRef >, Outlets< gl::Texture2dRef > >, public RenderStage
+{
+public:
+    static FrameHistoryNodeRef create( size_t frames )
+    {
+        return std::make_shared< FrameHistoryNode >( frames );
+    }
+
+    explicit FrameHistoryNode( size_t frames );
+    ~FrameHistoryNode();
+
+    //! Copies \a texture into the oldest layer, reallocating the array when
+    //! its size changes.
+    void push( const gl::Texture2dRef & texture );
+    //! Forgets the frames held, keeping the array.
+    void clear();
+
+    size_t getCapacity() const { return mCapacity; }
+    //! The number of frames held, up to the capacity.
+    size_t getCount() const { return mCount; }
+    //! The layer holding the frame \a age frames before the newest.
+    int getLayer( size_t age ) const { return (int)( ( mHead + mCapacity - age % mCapacity ) % mCapacity ); }
+
+    //! The GL_TEXTURE_2D_ARRAY, with layers top down like render targets.
+    const gl::Texture3dRef & getTexture() const { return mTexture; }
+
+    //! Has \a stage sample the history as the sampler2DArray \a name, with
+    //! the layer of the newest frame in <name>Head, the number of frames
+    //! held in <name>Count and the number of layers in <name>Size.
+    template< std::size_t I >
+    void attach( FullScreenQuadRenderer< I > & stage, const std::string & name = "uHistory" )
+    {
+        std::size_t head = stage.getUniformHandle( name + "Head" );
+        std::size_t count = stage.getUniformHandle( name + "Count" );
+        std::size_t size = stage.getUniformHandle( name + "Size" );
+        mAttachments.push_back( [this, &stage, name, head, count, size] {
+            stage.setSampler( name, mTexture );
+            stage.setUniform( head, (int)mHead );
+            stage.setUniform( count, (int)mCount );
+            stage.setUniform( size, (int)mCapacity );
+        } );
+        if ( mTexture ) mAttachments.back()();
+    }
+
+    //! GLSL declaring the uniforms attach() sets and a function \a function
+    //! returning the frame age frames before the newest, clamped to the
+    //! oldest held.
+    static std::string getGlsl( const std::string & name = "uHistory", const std::string & function = "history" );
+
+    //! Reallocates the array in the negotiated format.
+    void setOutputFormat( RenderFormat format ) override;
+
+private:
+    void allocate( const ci::ivec2 & size );
+
+    size_t                                  mCapacity;
+    size_t                                  mHead = 0;
+    size_t                                  mCount = 0;
+    ci::ivec2                               mSize;
+    gl::Texture3dRef                        mTexture;
+    GLuint                                  mReadFbo = 0;
+    GLuint                                  mDrawFbo = 0;
+    std::vector< std::function< void() > >  mAttachments;
+};
+
+//! The CPU counterpart of FrameHistoryNode, for testing temporal effects
+//! without a GPU. The surfaces of the ring are allocated once and each
+//! frame is copied into the oldest.
+class SurfaceHistoryNode : public Node< Inlets< Surface32fRef >, Outlets< Surface32fRef > >
+{
+public:
+    static SurfaceHistoryNodeRef create( size_t frames )
+    {
+        return std::make_shared< SurfaceHistoryNode >( frames );
+    }
+
+    explicit SurfaceHistoryNode( size_t frames );
+
+    //! Copies \a surface into the oldest slot, reallocating the ring when
+    //! its size or channels change.
+    void push( const Surface32fRef & surface );
+    void clear();
+
+    size_t getCapacity() const { return mRing.size(); }
+    size_t getCount() const { return mCount; }
+
+    //! The frame \a age frames before the newest, clamped to the oldest
+    //! held. Null until a frame is pushed.
+    Surface32fRef get( size_t age ) const;
+
+private:
+    std::vector< Surface32fRef >    mRing;
+    size_t                          mHead = 0;
+    size_t                          mCount = 0;
+};
+
+}
+}
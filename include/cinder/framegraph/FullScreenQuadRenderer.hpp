@@ -9,25 +9,68 @@
 #include "cinder/FileWatcher.h"
 #include "cinder/app/App.h"
 #include "cinder/Log.h"
+#include "cinder/framegraph/RenderStage.hpp"
+#include "cinder/framegraph/ProxyScale.hpp"
+#include "cinder/framegraph/ProgramRegistry.hpp"
+#include "cinder/framegraph/Uniforms.hpp"
+#include <algorithm>
 
 namespace cinder {
 namespace frame_graph {
 
 template< std::size_t I >
-class FullScreenQuadRenderer {
+class FullScreenQuadRenderer : public RenderStage {
+    struct Uniform {
+        std::string     name;
+        GLint           location;
+        UniformValue    value;
+    };
+
+    struct Sampler {
+        std::string             name;
+        GLint                   location;
+        ci::gl::TextureBaseRef  texture;
+    };
+
     std::array< ci::gl::Texture2dRef, I >   mTextures;
     std::array< std::string, I >            mTextureNames;
     std::array< std::string, I >            mTextureMatrixNames;
+    std::array< GLint, I >                  mTextureLocations;
+    std::array< GLint, I >                  mTextureMatrixLocations;
+    GLint                                   mSizeLocation = -1;
+    bool                                    mLocationsValid = false;
+    std::vector< Uniform >                  mUniforms;
+    std::vector< Sampler >                  mSamplers;
+    std::string                             mUniformBlockName;
+    UniformBlockBase *                      mUniformBlock = nullptr;
+    GLint                                   mUniformBlockLocation = -1;
     ci::gl::BatchRef                        mBatch;
+    SharedProgramRef                        mProgram;
+    uint32_t                                mProgramVersion = 0;
+    bool                                    mProgramChanged = true;
+    ci::signals::ScopedConnection           mWatchConnection;
     ci::gl::FboRef                          mFbo = nullptr;
     ci::mat4                                mModelMatrix;
+    ci::ivec2                               mSize;
+    float                                   mAutoSizeScale = 1.f;
 
 public:
     typedef std::true_type WATCH;
+
+    //! The binding point of the stage's uniform block.
+    static constexpr GLuint UNIFORM_BLOCK_BINDING = 0;
+
     FullScreenQuadRenderer( const ci::gl::GlslProgRef &shader,
-                            const ci::ivec2 &size )
+                            const ci::ivec2 &size ) :
+        FullScreenQuadRenderer( SharedProgram::create( shader ), size )
+    {}
+
+    //! Renders with a program that may still be compiling, waiting for it
+    //! on first use if it isn't ready yet.
+    FullScreenQuadRenderer( const SharedProgramRef & program,
+                            const ci::ivec2 &size ) :
+        mProgram( program )
     {
-        mBatch = ci::gl::Batch::create( ci::geom::Rect() >> ci::geom::Translate( 0.5f, 0.5f ), shader );
         mTextures.fill( nullptr );
         for ( size_t i = 0; i < I; ++i ) {
             mTextureNames[i] = "uTexture" + std::to_string( i );
@@ -39,14 +82,14 @@ public:
 
     FullScreenQuadRenderer( const ci::gl::GlslProg::Format & format,
                             const ci::ivec2 &size ) :
-        FullScreenQuadRenderer( ci::gl::GlslProg::create( format ), size )
+        FullScreenQuadRenderer( ProgramRegistry::instance().get( format ), size )
     {}
 
     FullScreenQuadRenderer( const ci::gl::GlslProg::Format & format,
                             const ci::ivec2 &size,
                             WATCH watch,
                             std::function< void( const WatchEvent& ) > watchCb = [](const WatchEvent&){} ) :
-        FullScreenQuadRenderer( ci::gl::GlslProg::create( format ), size )
+        FullScreenQuadRenderer( format, size )
     {
         watchShader( format, watchCb );
     }
@@ -54,7 +97,7 @@ public:
     FullScreenQuadRenderer( DataSourceRef vertexShader,
                             DataSourceRef fragmentShader,
                             const ci::ivec2 &size ) :
-        FullScreenQuadRenderer( ci::gl::GlslProg::create( vertexShader, fragmentShader ), size )
+        FullScreenQuadRenderer( ci::gl::GlslProg::Format().vertex( vertexShader ).fragment( fragmentShader ), size )
     {}
 
     FullScreenQuadRenderer( DataSourceRef vertexShader,
@@ -62,34 +105,19 @@ public:
                             const ci::ivec2 &size,
                             WATCH watch,
                             std::function< void( const WatchEvent& ) > watchCb = [](const WatchEvent&){} ) :
-        FullScreenQuadRenderer( ci::gl::GlslProg::create( vertexShader, fragmentShader ), size )
+        FullScreenQuadRenderer( vertexShader, fragmentShader, size )
     {
         watchShader( vertexShader, fragmentShader, watchCb );
     }
 
+    //! Reloads the program when its files change. Stages watching the same
+    //! files share one reload.
     void watchShader( const ci::gl::GlslProg::Format & format,
                       std::function< void( const WatchEvent& ) > watchCb = [](const WatchEvent&){} )
     {
-        CI_LOG_I( "WATCH SHADER " << format.getVertexPath() );
-
-        std::vector< ci::fs::path > paths{ format.getVertexPath(), format.getFragmentPath() };
-        FileWatcher::instance().watch( paths, [this, format, watchCb]( const WatchEvent &event ) {
-            watchCb( event );
-
-            try {
-                auto fmt = format;
-                fmt.vertex( ci::DataSourcePath::create( format.getVertexPath() ) );
-                fmt.fragment( ci::DataSourcePath::create( format.getFragmentPath() ) );
-                auto g = ci::gl::GlslProg::create( fmt );
-                mBatch->replaceGlslProg( g );
-
-                CI_LOG_I( "Reloaded shader: " << format.getVertexPath() << ", " << format.getFragmentPath() );
-            }
-            catch( const std::exception &e ) {
-                CI_LOG_EXCEPTION( "Error reloading shader: " << format.getVertexPath() << ", " << format.getFragmentPath(), e );
-            }
-
-        } );
+        mProgram = ProgramRegistry::instance().watch( format );
+        mProgramChanged = true;
+        mWatchConnection = mProgram->getSignalChanged().connect( watchCb );
     }
 
     void watchShader( DataSourceRef vertexShader,
@@ -99,22 +127,41 @@ public:
         watchShader( ci::gl::GlslProg::Format().vertex( vertexShader ).fragment( fragmentShader ), watchCb );
     }
 
+    //! Sets the full resolution size of the render target, which is scaled
+    //! by ProxyScale when rendering. A size of zero follows the full
+    //! resolution size of the first input instead.
     virtual void resize( const ci::ivec2 & size )
     {
-        using namespace ci;
-        mFbo = gl::Fbo::create( size.x, size.y );
-        mModelMatrix = scale( vec3( mFbo->getSize(), 1.f ) );
+        mSize = size;
+        if ( ! isAutoSize() ) allocate( ProxyScale::instance().getScaledSize( size ) );
+    }
+
+    bool isAutoSize() const { return mSize == ci::ivec2( 0 ); }
+
+    //! Scales automatically sized render targets relative to their input,
+    //! e.g. 0.5 for a downsample. Defaults to 1.
+    void setAutoSizeScale( float scale ) { mAutoSizeScale = scale; }
+    float getAutoSizeScale() const { return mAutoSizeScale; }
+
+    //! Recreates the render target if the format changed.
+    void setOutputFormat( RenderFormat format ) override
+    {
+        if ( format == getOutputFormat() ) return;
+        RenderStage::setOutputFormat( format );
+        if ( mFbo ) allocate( mFbo->getSize() );
     }
 
     void setTextureName( std::size_t i, const std::string & name, bool renameMatrix = true )
     {
         mTextureNames[ i ] = name;
         if ( renameMatrix ) mTextureMatrixNames[ i ] = name + "Mtx";
+        mLocationsValid = false;
     }
 
     void setTextureMatrixName( std::size_t i, const std::string & name )
     {
         mTextureMatrixNames[ i ] = name;
+        mLocationsValid = false;
     }
 
 protected:
@@ -124,62 +171,169 @@ protected:
         mTextures[ i ] = texture;
     }
 
+    const ci::gl::Texture2dRef & getTexture( std::size_t i ) const { return mTextures[ i ]; }
+
 public:
 
+    //! Returns a handle to set the uniform \a name with, without looking it
+    //! up by name each time.
+    std::size_t getUniformHandle( const std::string & name )
+    {
+        for ( std::size_t i = 0; i < mUniforms.size(); ++i ) {
+            if ( mUniforms[ i ].name == name ) return i;
+        }
+        mUniforms.push_back( { name, -1, UniformValue() } );
+        mLocationsValid = false;
+        return mUniforms.size() - 1;
+    }
+
+    //! Sets a uniform for this stage. Values are kept here and set on the
+    //! program before each draw, since other stages may share it.
+    template< typename T >
+    void setUniform( std::size_t handle, const T & v )
+    {
+        mUniforms[ handle ].value = UniformValue( v );
+    }
+
     template< typename T >
     void setUniform( const std::string & name, const T & v )
     {
-        mBatch->getGlslProg()->uniform( name, v );
+        setUniform( getUniformHandle( name ), v );
+    }
+
+    //! Binds \a texture to the sampler \a name before each draw, on a unit
+    //! after the inputs', for textures that aren't inputs, like texture
+    //! arrays.
+    void setSampler( const std::string & name, const ci::gl::TextureBaseRef & texture )
+    {
+        for ( auto & sampler : mSamplers ) {
+            if ( sampler.name == name ) {
+                sampler.texture = texture;
+                return;
+            }
+        }
+        mSamplers.push_back( { name, -1, texture } );
+        mLocationsValid = false;
+    }
+
+    //! Binds \a block to the shader's uniform block \a name before each
+    //! draw. The block must outlive the stage.
+    void setUniformBlock( const std::string & name, UniformBlockBase * block )
+    {
+        mUniformBlockName = name;
+        mUniformBlock = block;
+        mLocationsValid = false;
     }
 
 protected:
 
-    ci::gl::BatchRef batch() { return mBatch; }
+    ci::gl::BatchRef batch()
+    {
+        resolveShader();
+        return mBatch;
+    }
     ci::gl::FboRef fbo() { return mFbo; }
 
+    void allocate( const ci::ivec2 & size )
+    {
+        using namespace ci;
+        mFbo = gl::Fbo::create( size.x, size.y, getFboFormat( getOutputFormat() ) );
+        mModelMatrix = scale( vec3( mFbo->getSize(), 1.f ) );
+    }
+
+    //! The full resolution size of the next render, taken from the first
+    //! input when sized automatically.
+    ci::ivec2 getFullSize() const
+    {
+        if ( ! isAutoSize() ) return mSize;
+
+        auto it = std::find_if( mTextures.begin(), mTextures.end(), []( const ci::gl::Texture2dRef & tex ) { return tex != nullptr; } );
+        if ( it == mTextures.end() ) return ci::ivec2( 0 );
+        ci::ivec2 size = ProxyScale::instance().getFullSize( *it );
+        if ( mAutoSizeScale == 1.f ) return size;
+        return ci::ivec2( std::max( 1, (int)( size.x * mAutoSizeScale ) ), std::max( 1, (int)( size.y * mAutoSizeScale ) ) );
+    }
+
     virtual void prepareRender() {}
 
+    //! Takes the shared program once compiled, or again once a reload has
+    //! compiled. Waits for it only when there is no program yet. Failed
+    //! reloads never reach the stage, so the last good program stays.
+    void resolveShader()
+    {
+        mProgram->update();
+        if ( mBatch && ! mProgramChanged && mProgram->getVersion() == mProgramVersion ) return;
+
+        const GlslProgFuture & program = mProgram->getProgram();
+        if ( mBatch && program.wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready ) return;
+
+        mProgramVersion = mProgram->getVersion();
+        mProgramChanged = false;
+        setShader( program.get() );
+    }
+
     virtual ci::gl::Texture2dRef render()
     {
         using namespace ci;
 
-        if ( ! mFbo ) return nullptr;
+        resolveShader();
+
+        ivec2 fullSize = getFullSize();
+        if ( fullSize == ivec2( 0 ) ) return nullptr;
+
+        ivec2 size = ProxyScale::instance().getScaledSize( fullSize );
+        if ( ! mFbo || mFbo->getSize() != size ) allocate( size );
+
+        // only shade the pixels downstream stages read. The output is top
+        // down, so the region's rows are the render target's rows as is.
+        Area region = getRegionArea( size );
+        if ( region.getWidth() <= 0 || region.getHeight() <= 0 ) return mFbo->getColorTexture();
 
         {
             gl::ScopedFramebuffer	scp_fbo( mFbo );
             gl::ScopedViewport		scp_viewport( mFbo->getSize() );
+            gl::ScopedScissor       scp_scissor( ivec2( region.x1, region.y1 ), region.getSize() );
             gl::ScopedMatrices		scp_mtx;
             gl::ScopedColor         scp_color( ColorAf( 1.f, 1.f, 1.f, 1.f ) );
 
             gl::setMatricesWindow( mFbo->getSize() );
             gl::multModelMatrix( mModelMatrix );
-            auto shader = mBatch->getGlslProg();
+            const auto & shader = mBatch->getGlslProg();
+            if ( ! mLocationsValid ) resolveLocations( shader );
+
+            for ( const auto & uniform : mUniforms ) {
+                if ( uniform.location >= 0 ) uniform.value.apply( shader, uniform.location );
+            }
+            if ( mUniformBlock && mUniformBlockLocation >= 0 ) mUniformBlock->bind( UNIFORM_BLOCK_BINDING );
 
             for ( uint8_t i = 0; i < mTextures.size(); ++i ) {
-                auto tex = mTextures.at( i );
+                const auto & tex = mTextures[ i ];
                 if ( ! tex ) continue;
-                auto name = mTextureNames.at( i );
-                auto mtxName = mTextureMatrixNames.at( i );
 
                 tex->bind( i );
 
-                shader->uniform( name, i );
+                if ( mTextureLocations[ i ] >= 0 ) shader->uniform( mTextureLocations[ i ], (int)i );
 
-                int loc;
-                if ( shader->findUniform( mtxName, &loc ) != nullptr ) {
+                if ( mTextureMatrixLocations[ i ] >= 0 ) {
                     mat4 m;
                     if ( ! tex->isTopDown() ) {
                         m = translate( vec3( 0.f, 1.f, 0.f )) *
                             scale( vec3( 1.f, -1.f, 1.f ));
                     }
-                    shader->uniform( loc, m );
+                    shader->uniform( mTextureMatrixLocations[ i ], m );
                 }
             }
 
+            for ( size_t i = 0; i < mSamplers.size(); ++i ) {
+                const auto & sampler = mSamplers[ i ];
+                if ( ! sampler.texture ) continue;
 
-            int loc;
-            if ( shader->findUniform( "uSize", &loc ) != nullptr ) {
-                shader->uniform( loc, vec2( mFbo->getSize()));
+                sampler.texture->bind( (uint8_t)( I + i ) );
+                if ( sampler.location >= 0 ) shader->uniform( sampler.location, (int)( I + i ) );
+            }
+
+            if ( mSizeLocation >= 0 ) {
+                shader->uniform( mSizeLocation, vec2( mFbo->getSize()));
             }
 
             prepareRender();
@@ -189,18 +343,56 @@ protected:
             mBatch->draw();
 
             for ( uint8_t i = 0; i < mTextures.size(); ++i ) {
-                auto tex = mTextures.at( i );
-                if ( ! tex ) continue;
-                tex->unbind();
+                if ( mTextures[ i ] ) mTextures[ i ]->unbind();
+            }
+            for ( size_t i = 0; i < mSamplers.size(); ++i ) {
+                if ( mSamplers[ i ].texture ) mSamplers[ i ].texture->unbind( (uint8_t)( I + i ) );
             }
         }
 
         auto tex = mFbo->getColorTexture();
         tex->setTopDown( true );
+        ProxyScale::instance().registerTexture( tex, fullSize );
         return tex;
     }
 
-    ci::gl::Texture2dRef getTexture() { return mFbo->getColorTexture(); }
+    ci::gl::Texture2dRef getTexture() { return mFbo ? mFbo->getColorTexture() : nullptr; }
+
+private:
+
+    void setShader( const ci::gl::GlslProgRef & shader )
+    {
+        if ( mBatch && mBatch->getGlslProg() == shader ) return;
+        if ( mBatch ) mBatch->replaceGlslProg( shader );
+        else          mBatch = ci::gl::Batch::create( ci::geom::Rect() >> ci::geom::Translate( 0.5f, 0.5f ), shader );
+        mLocationsValid = false;
+    }
+
+    //! Looks up everything render() sets once per program rather than by
+    //! name every frame. Missing uniforms get location -1 and are skipped.
+    void resolveLocations( const ci::gl::GlslProgRef & shader )
+    {
+        auto find = [&]( const std::string & name ) {
+            int loc;
+            return shader->findUniform( name, &loc ) != nullptr ? loc : -1;
+        };
+
+        for ( size_t i = 0; i < I; ++i ) {
+            mTextureLocations[ i ] = find( mTextureNames[ i ] );
+            mTextureMatrixLocations[ i ] = find( mTextureMatrixNames[ i ] );
+        }
+        mSizeLocation = find( "uSize" );
+        for ( auto & uniform : mUniforms ) uniform.location = find( uniform.name );
+        for ( auto & sampler : mSamplers ) sampler.location = find( sampler.name );
+
+        mUniformBlockLocation = -1;
+        if ( mUniformBlock ) {
+            mUniformBlockLocation = shader->getUniformBlockLocation( mUniformBlockName );
+            if ( mUniformBlockLocation >= 0 ) shader->uniformBlock( mUniformBlockLocation, UNIFORM_BLOCK_BINDING );
+        }
+
+        mLocationsValid = true;
+    }
 
 };
 
@@ -4,14 +4,95 @@
 #include "glvideo.h"
 #include "Movie.h"
 #include "cinder/FrameGraph.hpp"
+#include "cinder/framegraph/PresentationClock.hpp"
 #include "cinder/Log.h"
+#include <deque>
+#include <utility>
+#include <vector>
 
 namespace cinder {
 namespace frame_graph {
 
+typedef ref< class GLVideoSource > GLVideoSourceRef;
 typedef ref< class GLVideoINode > GLVideoINodeRef;
 typedef ref< class GLVideoHapQDecodeShaderIONode > GLVideoHapQDecodeShaderIONodeRef;
 
+//! One decode of a movie shared by several GLVideoINodes. Decoded frames
+//! are kept for a while, keyed by a stream time that keeps increasing
+//! through loops and seeks, so playheads at the same time get the same
+//! texture and playheads trailing the decode reuse frames it already
+//! produced instead of decoding the file again. Cached frames hold on to
+//! their GPU textures, so the cache costs a texture per frame it spans.
+class GLVideoSource
+{
+public:
+    typedef decltype( std::declval< glvideo::Movie & >().getCurrentFrame() ) FrameRef;
+
+    static GLVideoSourceRef create( const glvideo::Movie::ref & movie )
+    {
+        return std::make_shared< GLVideoSource >( movie );
+    }
+
+    explicit GLVideoSource( const glvideo::Movie::ref & movie );
+
+    //! Takes the movie's newest frame into the cache. Every playhead calls
+    //! this; the movie is only asked once per decoded frame.
+    void update();
+
+    //! Returns the newest cached frame at or before stream time \a time, or
+    //! the oldest one when the cache doesn't reach back that far.
+    ci::gl::Texture2dRef getFrame( double time ) const;
+
+    //! The stream time of the newest decoded frame.
+    double getTime() const { return mStreamTime; }
+
+    //! Keeps at least \a seconds of frames behind the newest one.
+    void reserveHistory( double seconds ) { mHistory = std::max( mHistory, seconds ); }
+    double getHistory() const { return mHistory; }
+    size_t getCachedFrameCount() const { return mFrames.size(); }
+
+    void setLooping( bool enabled ) { mMovie->loop( enabled ); mLooping = enabled; }
+    bool isLooping() const { return mLooping; }
+
+    //! Registers a playhead synced to a PresentationClock that shows the
+    //! movie \a position seconds ahead of the clock. The movie is steered to
+    //! the playhead furthest ahead; the others read the cache behind it.
+    void setPlayhead( const void * playhead, double position );
+    void removePlayhead( const void * playhead );
+
+    //! The largest position of the registered playheads, which the movie is
+    //! steered to.
+    double getLeadPosition() const;
+
+    //! Returns true the first time it is called for \a vsync, so the movie
+    //! is steered once per frame however many playheads share it.
+    bool beginSync( int64_t vsync );
+
+    glvideo::Movie::ref getMovie() const { return mMovie; }
+
+private:
+    struct CachedFrame {
+        double                  time;
+        FrameRef                frame;
+        ci::gl::Texture2dRef    texture;
+    };
+
+    glvideo::Movie::ref         mMovie;
+    std::deque< CachedFrame >   mFrames;
+    std::vector< std::pair< const void *, double > >    mPlayheads;
+    int64_t                     mSyncedVsync = -1;
+    double                      mHistory = 0.0;
+    double                      mStreamTime = 0.0;
+    double                      mLastElapsed = 0.0;
+    double                      mLastStep = 0.0;
+    bool                        mLooping = false;
+};
+
+//! A playhead on a GLVideoSource. Copies share the original's source, so
+//! several screens can show one clip, at the same time or delayed by
+//! setDelay(), from a single decode. Playheads that share a source and sync
+//! to the same clock at different offsets don't fight over the movie: it
+//! follows the one furthest ahead and the others become cache delays.
 class GLVideoINode : public TextureINode
 {
 public:
@@ -26,6 +107,11 @@ public:
         return std::make_shared< GLVideoINode >( movie );
     }
 
+    static GLVideoINodeRef create( const GLVideoSourceRef & source )
+    {
+        return std::make_shared< GLVideoINode >( source );
+    }
+
 	static GLVideoINodeRef create( const GLVideoINode & original )
 	{
 		return std::make_shared< GLVideoINode >( original );
@@ -33,17 +119,32 @@ public:
 
 	GLVideoINode( const glvideo::Context::ref & context, const ci::fs::path & path, bool playImmediately = true );
 	GLVideoINode( const glvideo::Movie::ref & movie );
+	GLVideoINode( const GLVideoSourceRef & source );
+	//! Shares the decode of \a original.
 	explicit GLVideoINode( const GLVideoINode & original );
+	~GLVideoINode();
 
 	virtual void update() override;
 
 	GLVideoINode & play() { mMovie->play(); return *this; }
-	GLVideoINode & loop( bool enabled = true ) { mMovie->loop( enabled ); return *this; }
+	GLVideoINode & loop( bool enabled = true ) { mSource->setLooping( enabled ); return *this; }
 	GLVideoINode & stop() { mMovie->stop(); return *this; }
 	GLVideoINode & seekToStart() { mMovie->seekToStart(); return *this; }
 	GLVideoINode & seek( glvideo::seconds secs ) { mMovie->seek( secs ); return *this; }
 	GLVideoINode & setPlaybackRate( float rate ) { mMovie->setPlaybackRate( rate ); return *this; }
 
+    //! Presents the frame at \a offset plus the time of \a clock, seeking
+    //! when playback drifts more than a frame and a half from it, and
+    //! holding the previous frame when the clock repeats one. Pass nullptr
+    //! to play freely again.
+    GLVideoINode & syncTo( PresentationClock * clock = &PresentationClock::instance(), double offset = 0.0 );
+    PresentationClock * getClock() const { return mClock; }
+
+    //! Shows the source's frames \a seconds after it decodes them. A synced
+    //! playhead's delay is taken off its clock offset.
+    GLVideoINode & setDelay( double seconds );
+    double getDelay() const { return mDelay; }
+
     std::string getFilename() const { return mMovie->getFilename(); }
     glvideo::seconds getDuration() const { return mMovie->getDuration(); }
     glvideo::seconds getElapsedTime() const { return mMovie->getElapsedTime(); }
@@ -55,9 +156,17 @@ public:
 	ci::vec2 getSize() { return ci::vec2( mMovie->getWidth(), mMovie->getHeight() ); }
 
     glvideo::Movie::ref getMovie() const { return mMovie; }
+    GLVideoSourceRef getSource() const { return mSource; }
 
 private:
+    void registerPlayhead();
+    void syncToClock( double position );
+
+    GLVideoSourceRef    mSource;
 	glvideo::Movie::ref mMovie;
+    double              mDelay = 0.0;
+    PresentationClock * mClock = nullptr;
+    double              mClockOffset = 0.0;
 };
 
 class GLVideoHapQDecodeShaderIONode : public TextureShaderIONode<>
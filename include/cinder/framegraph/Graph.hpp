@@ -0,0 +1,257 @@
+#pragma once
+
+#include "cinder/FrameGraph.hpp"
+#include "cinder/Exception.h"
+#include "cinder/Json.h"
+#include <iosfwd>
+#include <map>
+#include <typeindex>
+#include <utility>
+
+namespace cinder {
+namespace frame_graph {
+
+class GraphExc : public ci::Exception
+{
+public:
+    GraphExc( const std::string & description ) : ci::Exception( description ) {}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// NodeFactory
+
+namespace detail {
+
+template< class In, class Out >
+struct Ports {
+    typedef In  inlets;
+    typedef Out outlets;
+};
+
+//! Deduces the value types of a node's inlets and outlets from its Node base.
+template< class... In, class... Out >
+Ports< std::tuple< In... >, std::tuple< Out... > > portsOf( const Node< Inlets< In... >, Outlets< Out... > > * );
+
+template< class T >
+using PortsOf = decltype( portsOf( std::declval< T * >() ) );
+
+//! The inlet type carrying values of type \a T.
+template< class T >
+using InletOf = std::remove_reference_t< decltype( std::declval< Node< Inlets< T >, Outlets<> > & >().template in< 0 >() ) >;
+
+}
+
+//! How the graph creates and connects nodes of one type without knowing it.
+struct NodeType {
+    std::string                                                         name;
+    std::type_index                                                     type = typeid( void );
+    std::function< std::shared_ptr< void >( const ci::JsonTree & ) >   create;
+    //! Returns inlet \a i of a node if it carries values of type \a value.
+    void *                                                              ( *findInlet )( void * node, size_t i, std::type_index value ) = nullptr;
+    //! Connects outlet \a o of \a from to inlet \a i of \a to.
+    bool                                                                ( *connect )( void * from, size_t o, const NodeType & toType, void * to, size_t i ) = nullptr;
+    RenderStage *                                                       ( *stage )( void * node ) = nullptr;
+    //! Set for sources, which Graph::update() updates every frame.
+    void                                                                ( *update )( void * node ) = nullptr;
+};
+
+//! Creates nodes by type name for graphs loaded from files. The nodes of
+//! this block are registered by default. Parameters are read from the
+//! node's "params" object.
+class NodeFactory
+{
+public:
+    static NodeFactory & instance();
+
+    //! Registers \a T as \a name, created by \a create.
+    template< class T >
+    void add( const std::string & name, std::function< ref< T >( const ci::JsonTree & params ) > create )
+    {
+        mTypes[ name ] = makeType< T >( name, create );
+    }
+
+    //! Registers a source, whose update() is called by Graph::update().
+    template< class T >
+    void addSource( const std::string & name, std::function< ref< T >( const ci::JsonTree & params ) > create )
+    {
+        NodeType type = makeType< T >( name, create );
+        type.update = []( void * node ) { static_cast< T * >( node )->update(); };
+        mTypes[ name ] = type;
+    }
+
+    bool has( const std::string & name ) const { return mTypes.count( name ) > 0; }
+
+    //! Throws GraphExc if \a name isn't registered.
+    const NodeType & get( const std::string & name ) const;
+
+private:
+    NodeFactory();
+
+    template< class T >
+    static NodeType makeType( const std::string & name, std::function< ref< T >( const ci::JsonTree & ) > create );
+
+    template< class T, class InTuple, size_t... Is >
+    static void * findInlet( T & node, size_t i, std::type_index value, std::index_sequence< Is... > );
+
+    template< class T, class OutTuple, size_t... Os >
+    static bool connect( T & node, size_t o, const NodeType & toType, void * to, size_t i, std::index_sequence< Os... > );
+
+    template< class V, class Outlet >
+    static bool connectOutlet( Outlet & outlet, const NodeType & toType, void * to, size_t i );
+
+    template< class T >
+    static RenderStage * stageOf( void * node, std::true_type ) { return static_cast< T * >( node ); }
+    template< class T >
+    static RenderStage * stageOf( void *, std::false_type ) { return nullptr; }
+
+    std::map< std::string, NodeType > mTypes;
+};
+
+template< class T >
+NodeType NodeFactory::makeType( const std::string & name, std::function< ref< T >( const ci::JsonTree & ) > create )
+{
+    typedef typename detail::PortsOf< T >::inlets   InTuple;
+    typedef typename detail::PortsOf< T >::outlets  OutTuple;
+
+    NodeType type;
+    type.name = name;
+    type.type = typeid( T );
+    type.create = [create]( const ci::JsonTree & params ) -> std::shared_ptr< void > { return create( params ); };
+    type.findInlet = []( void * node, size_t i, std::type_index value ) {
+        return findInlet< T, InTuple >( *static_cast< T * >( node ), i, value, std::make_index_sequence< std::tuple_size< InTuple >::value >() );
+    };
+    type.connect = []( void * from, size_t o, const NodeType & toType, void * to, size_t i ) {
+        return connect< T, OutTuple >( *static_cast< T * >( from ), o, toType, to, i, std::make_index_sequence< std::tuple_size< OutTuple >::value >() );
+    };
+    type.stage = []( void * node ) { return stageOf< T >( node, std::is_base_of< RenderStage, T >() ); };
+    return type;
+}
+
+template< class T, class InTuple, size_t... Is >
+void * NodeFactory::findInlet( T & node, size_t i, std::type_index value, std::index_sequence< Is... > )
+{
+    void * inlet = nullptr;
+    using expand = int[];
+    (void)expand{ 0, ( i == Is && value == typeid( std::tuple_element_t< Is, InTuple > )
+        ? ( inlet = static_cast< void * >( &node.template in< Is >() ), 0 ) : 0 )... };
+    return inlet;
+}
+
+template< class T, class OutTuple, size_t... Os >
+bool NodeFactory::connect( T & node, size_t o, const NodeType & toType, void * to, size_t i, std::index_sequence< Os... > )
+{
+    bool connected = false;
+    using expand = int[];
+    (void)expand{ 0, ( o == Os
+        ? ( connected = connectOutlet< std::tuple_element_t< Os, OutTuple > >( node.template out< Os >(), toType, to, i ), 0 ) : 0 )... };
+    return connected;
+}
+
+template< class V, class Outlet >
+bool NodeFactory::connectOutlet( Outlet & outlet, const NodeType & toType, void * to, size_t i )
+{
+    using namespace operators;
+
+    void * inlet = toType.findInlet( to, i, typeid( V ) );
+    if ( ! inlet ) return false;
+
+    outlet >> *static_cast< detail::InletOf< V > * >( inlet );
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// GraphDesc
+
+//! A graph as authored: nodes by id and type with their parameters, and the
+//! connections between them. Stored as JSON, e.g.
+//!
+//!     { "nodes": [ { "id": "src", "type": "TextureINode", "params": { "path": "a.png" } },
+//!                  { "id": "grade", "type": "ColorGradeNode" },
+//!                  { "id": "out", "type": "TextureONode", "active": true } ],
+//!       "connections": [ { "from": "src", "to": "grade" },
+//!                        { "from": "grade", "to": "out" } ] }
+//!
+//! Outlets and inlets default to 0. Graphs can also be written in a compact
+//! binary form that loads without parsing JSON.
+struct GraphDesc {
+    struct NodeDesc {
+        std::string     id;
+        std::string     type;
+        ci::JsonTree    params;
+        bool            active = false;
+    };
+
+    struct Connection {
+        size_t  from;
+        size_t  outlet;
+        size_t  to;
+        size_t  inlet;
+    };
+
+    std::vector< NodeDesc >     nodes;
+    std::vector< Connection >   connections;
+
+    //! Returns the index of the node \a id. Throws GraphExc if there isn't one.
+    size_t indexOf( const std::string & id ) const;
+
+    static GraphDesc fromJson( const ci::JsonTree & json );
+    ci::JsonTree toJson() const;
+
+    //! Reads either form. Throws GraphExc or JsonTree::ExcJsonParserError.
+    static GraphDesc load( const ci::DataSourceRef & source );
+
+    void writeBinary( std::ostream & out ) const;
+    //! Throws GraphExc if \a in is truncated or corrupt, checking counts and
+    //! lengths against the bytes left before allocating for them.
+    static GraphDesc readBinary( std::istream & in );
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Graph
+
+//! A loaded graph that creates its nodes lazily. Nothing is created until a
+//! node is activated; then it and everything upstream of it is created,
+//! connected and linked for format negotiation, so the textures, programs
+//! and decoders of inactive parts of a large show are never loaded. Nodes
+//! stay alive once created.
+class Graph
+{
+public:
+    //! Activates the nodes marked active.
+    explicit Graph( const GraphDesc & desc );
+
+    //! Creates \a id and everything upstream of it.
+    void activate( const std::string & id );
+
+    bool isActive( const std::string & id ) const { return mNodes[ mDesc.indexOf( id ) ] != nullptr; }
+    size_t getNumActive() const;
+
+    //! Returns the node \a id, or nullptr if it isn't active or isn't a \a T.
+    template< class T >
+    ref< T > getNode( const std::string & id ) const
+    {
+        size_t i = mDesc.indexOf( id );
+        if ( ! mNodes[ i ] || mTypes[ i ]->type != std::type_index( typeid( T ) ) ) return nullptr;
+        return std::static_pointer_cast< T >( mNodes[ i ] );
+    }
+
+    //! Updates the active sources.
+    void update();
+
+    //! Links between the active render stages, for propagating regions.
+    StageGraph & getStages() { return mStages; }
+
+    const GraphDesc & getDesc() const { return mDesc; }
+
+private:
+    void create( size_t i, std::vector< bool > & visiting, std::vector< size_t > * created );
+
+    GraphDesc                               mDesc;
+    std::vector< const NodeType * >         mTypes;
+    std::vector< std::shared_ptr< void > >  mNodes;
+    std::vector< size_t >                   mSources;
+    StageGraph                              mStages;
+};
+
+}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "cinder/gl/Context.h"
+#include "cinder/Exception.h"
+#include <EGL/egl.h>
+
+namespace cinder {
+namespace frame_graph {
+
+typedef std::shared_ptr< class HeadlessContext > HeadlessContextRef;
+
+class HeadlessContextExc : public ci::Exception
+{
+public:
+    HeadlessContextExc( const std::string & description ) : ci::Exception( description ) {}
+};
+
+//! An offscreen OpenGL 3.3 core context for running render stages on
+//! machines without a display or GPU, e.g. Mesa's llvmpipe on CI with
+//! LIBGL_ALWAYS_SOFTWARE=1. Uses EGL's surfaceless platform where available
+//! and a 1x1 pbuffer otherwise. Needs Cinder configured for headless EGL
+//! (CINDER_HEADLESS_GL=egl) and ENABLE_FRAMEGRAPH_HEADLESS; apps built that
+//! way get an offscreen context from their renderer already, this is for
+//! tools that run without an app.
+class HeadlessContext
+{
+public:
+    //! Creates the context and makes it current. Throws HeadlessContextExc.
+    static HeadlessContextRef create();
+
+    HeadlessContext();
+    ~HeadlessContext();
+
+    HeadlessContext( const HeadlessContext & ) = delete;
+    HeadlessContext & operator=( const HeadlessContext & ) = delete;
+
+    void makeCurrent() const { mContext->makeCurrent(); }
+
+    const ci::gl::ContextRef & getContext() const { return mContext; }
+
+    //! The GL_RENDERER string, recorded with timings since they only
+    //! compare on the same renderer.
+    std::string getRenderer() const;
+
+private:
+    EGLDisplay          mDisplay = EGL_NO_DISPLAY;
+    EGLContext          mEglContext = EGL_NO_CONTEXT;
+    EGLSurface          mSurface = EGL_NO_SURFACE;
+    ci::gl::ContextRef  mContext;
+};
+
+}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "cinder/Exception.h"
+#include "cinder/Filesystem.h"
+#include "cinder/FrameGraph.hpp"
+#include "cinder/framegraph/Lut.hpp"
+
+namespace cinder {
+namespace frame_graph {
+
+typedef ref< class LUTFileINode > LUTFileINodeRef;
+
+class LUTFileExc : public ci::Exception
+{
+public:
+    LUTFileExc( const std::string & description ) : ci::Exception( description ) {}
+};
+
+//! Parses the text of an Adobe/Resolve .cube file.
+Lut3d parseCubeLut( const std::string & text );
+
+//! Parses the text of an Autodesk/Lustre .3dl file.
+Lut3d parse3dlLut( const std::string & text );
+
+//! Loads a .cube or .3dl file. Parsed LUTs are cached in a binary sidecar,
+//! keyed by the source's size, modification time and content hash, so later
+//! loads read the lattice back directly. The sidecar is written next to the
+//! source unless \a cacheDirectory is given. Throws LUTFileExc.
+Lut3d loadLut( const ci::fs::path & path, const ci::fs::path & cacheDirectory = ci::fs::path() );
+
+//! A node that loads a .cube or .3dl file and emits it both as a 3D texture
+//! and as CPU data, which carries the domain, for LUTNode's third inlet.
+class LUTFileINode : public Node< Inlets<>, Outlets< gl::Texture3dRef, Lut3dRef > >
+{
+public:
+    class Format
+    {
+    public:
+        Format() {}
+
+        //! Stores binary caches in \a dir instead of next to the LUT file.
+        Format & cacheDirectory( const ci::fs::path & dir ) { mCacheDirectory = dir; return *this; }
+        const ci::fs::path & getCacheDirectory() const { return mCacheDirectory; }
+
+        //! Creates a 3D texture. Disable for CPU-only pipelines.
+        Format & texture( bool enabled = true ) { mTexture = enabled; return *this; }
+        bool hasTexture() const { return mTexture; }
+
+        //! Sets the precision of the 3D texture. Defaults to GL_RGB16F.
+        Format & internalFormat( GLint internalFormat ) { mInternalFormat = internalFormat; return *this; }
+        GLint getInternalFormat() const { return mInternalFormat; }
+
+    private:
+        ci::fs::path    mCacheDirectory;
+        bool            mTexture = true;
+        GLint           mInternalFormat = GL_RGB16F;
+    };
+
+    static LUTFileINodeRef create( const ci::fs::path & path, const Format & format = Format() )
+    {
+        return std::make_shared< LUTFileINode >( path, format );
+    }
+
+    LUTFileINode( const ci::fs::path & path, const Format & format = Format() );
+
+    virtual void update();
+
+    const Lut3dRef & getLut() const { return mLut; }
+    const ci::gl::Texture3dRef & getTexture() const { return mTexture; }
+
+private:
+    Lut3dRef                mLut;
+    ci::gl::Texture3dRef    mTexture = nullptr;
+};
+
+}
+}
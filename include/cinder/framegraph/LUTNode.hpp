@@ -1,21 +1,95 @@
 #pragma once
 
 #include "cinder/FrameGraph.hpp"
+#include "cinder/framegraph/Lut.hpp"
 
 namespace cinder {
 namespace frame_graph {
 
 typedef std::shared_ptr< class LUTNode > LUTShaderIONodeRef;
 
-class LUTNode : public TextureShaderIONode< 2 > {
+//! A node that applies a color lookup table to a texture. By default the LUT
+//! is a 2D atlas of 64 slices of 64x64, like assets/luts/K_TONE_Kodachrome.png,
+//! received on the second inlet. With Format::texture3d() the LUT is sampled
+//! from a 3D texture instead, uploaded from a Lut3d received on the third
+//! inlet, e.g. from LUTFileINode, or set directly.
+class LUTNode :
+        public FullScreenQuadRenderer< 2 >,
+        public Node< Inlets<
+                gl::Texture2dRef, // source
+                gl::Texture2dRef, // 2D atlas LUT
+                Lut3dRef          // 3D LUT
+        >, Outlets< gl::Texture2dRef > >
+{
 public:
+    typedef Lut3d::Interpolation Interpolation;
 
-    static LUTShaderIONodeRef create( const ci::ivec2 & size )
+    class Format
     {
-        return std::make_shared< LUTNode >( size );
+    public:
+        Format() {}
+
+        //! Sets the number of lattice points along each axis. Defaults to 64.
+        Format & size( int size ) { mSize = size; return *this; }
+        int getSize() const { return mSize; }
+
+        //! Samples the LUT from a 3D texture. Atlases received on the second
+        //! inlet are converted once when they arrive.
+        Format & texture3d( bool enabled = true ) { mTexture3d = enabled; return *this; }
+        bool isTexture3d() const { return mTexture3d; }
+
+        //! Trilinear uses hardware filtering, tetrahedral does four texel
+        //! fetches and is more accurate along the neutral axis.
+        Format & interpolation( Interpolation interpolation ) { mInterpolation = interpolation; return *this; }
+        Interpolation getInterpolation() const { return mInterpolation; }
+
+        //! Sets the precision of 3D textures created by the node. Defaults to
+        //! GL_RGB16F.
+        Format & internalFormat( GLint internalFormat ) { mInternalFormat = internalFormat; return *this; }
+        GLint getInternalFormat() const { return mInternalFormat; }
+
+    private:
+        int             mSize = 64;
+        bool            mTexture3d = false;
+        Interpolation   mInterpolation = Interpolation::TRILINEAR;
+        GLint           mInternalFormat = GL_RGB16F;
+    };
+
+    static LUTShaderIONodeRef create( const ci::ivec2 & size = ci::ivec2( 0 ), const Format & format = Format() )
+    {
+        return std::make_shared< LUTNode >( size, format );
     }
 
-    LUTNode( const ci::ivec2 & size );
+    //! A \a size of zero follows the size of the source.
+    LUTNode( const ci::ivec2 & size = ci::ivec2( 0 ), const Format & format = Format() );
+
+    //! Uploads \a lut to a 3D texture and uses it over its domain. Requires
+    //! Format::texture3d().
+    void setLUT( const Lut3d & lut );
+    //! Uses \a lut directly, with its lattice spanning inputs from \a domainMin
+    //! to \a domainMax. Its size must match Format::size(). Requires
+    //! Format::texture3d().
+    void setLUT( const ci::gl::Texture3dRef & lut, const ci::vec3 & domainMin = ci::vec3( 0.f ), const ci::vec3 & domainMax = ci::vec3( 1.f ) );
+
+    const Format & getFormat() const { return mFormat; }
+
+protected:
+    ci::gl::Texture2dRef render() override;
+
+private:
+    void updateSource( const ci::gl::Texture2dRef & texture );
+    void updateAtlas( const ci::gl::Texture2dRef & atlas );
+    void update();
+
+    bool hasLUT() const { return mFormat.isTexture3d() ? mLUT3d != nullptr : mAtlas != nullptr; }
+
+    Format                  mFormat;
+    ci::gl::Texture2dRef    mSource = nullptr;
+    ci::gl::Texture2dRef    mAtlas = nullptr;
+    ci::gl::Texture3dRef    mLUT3d = nullptr;
+    ci::vec3                mDomainMin = ci::vec3( 0.f );
+    ci::vec3                mDomainMax = ci::vec3( 1.f );
+    Lut3dRef                mReceived = nullptr;
 };
 
 
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "cinder/Surface.h"
+#include "cinder/gl/Texture.h"
+#include "cinder/framegraph/Types.hpp"
+#include <vector>
+
+namespace cinder {
+namespace frame_graph {
+
+//! A 3D color lookup table held on the CPU. Lattice values are stored as
+//! interleaved RGB floats with red varying fastest, which is the layout
+//! OpenColorIO produces and the layout GL expects for a GL_RGB 3D texture.
+//! The lookups double as the reference implementation for the GPU paths.
+class Lut3d
+{
+public:
+    enum class Interpolation {
+        TRILINEAR,
+        TETRAHEDRAL
+    };
+
+    static Lut3dRef create( int size )
+    {
+        return std::make_shared< Lut3d >( size );
+    }
+
+    //! Returns an identity LUT with \a size lattice points per axis.
+    static Lut3d createIdentity( int size );
+
+    //! Decodes a 2D atlas, like the ones consumed by LUTNode, into a 3D LUT.
+    //! The atlas is a grid of \a size x \a size slices, one per blue level,
+    //! laid out left to right and top to bottom.
+    static Lut3d createFromAtlas( const Surface32f & atlas, int size = 64 );
+
+    Lut3d() {}
+    explicit Lut3d( int size );
+    Lut3d( int size, std::vector< float > data );
+
+    int getSize() const { return mSize; }
+
+    const std::vector< float > & getData() const { return mData; }
+    std::vector< float > & getData() { return mData; }
+
+    //! The input range mapped onto the lattice, [0, 1] by default.
+    void setDomain( const vec3 & min, const vec3 & max ) { mDomainMin = min; mDomainMax = max; }
+    const vec3 & getDomainMin() const { return mDomainMin; }
+    const vec3 & getDomainMax() const { return mDomainMax; }
+
+    vec3 at( int r, int g, int b ) const
+    {
+        const float * p = &mData[ index( r, g, b ) ];
+        return vec3( p[ 0 ], p[ 1 ], p[ 2 ] );
+    }
+
+    void set( int r, int g, int b, const vec3 & v )
+    {
+        float * p = &mData[ index( r, g, b ) ];
+        p[ 0 ] = v.r; p[ 1 ] = v.g; p[ 2 ] = v.b;
+    }
+
+    vec3 lookup( const vec3 & c, Interpolation interpolation = Interpolation::TRILINEAR ) const;
+    vec3 lookupTrilinear( const vec3 & c ) const;
+    vec3 lookupTetrahedral( const vec3 & c ) const;
+
+    //! Applies the LUT to every pixel of \a surface, in place.
+    void apply( Surface32f & surface, Interpolation interpolation = Interpolation::TRILINEAR ) const;
+
+    //! Creates a 3D texture containing the lattice. \a internalFormat selects
+    //! the precision, typically GL_RGB16F or GL_RGB32F.
+    gl::Texture3dRef createTexture( GLint internalFormat = GL_RGB16F ) const;
+
+    //! Uploads the lattice into an existing texture of the same size.
+    void updateTexture( const gl::Texture3dRef & texture ) const;
+
+private:
+    size_t index( int r, int g, int b ) const { return 3 * ( ( (size_t)b * mSize + g ) * mSize + r ); }
+
+    //! Maps \a c through the domain to lattice coordinates in [0, size - 1].
+    vec3 toLattice( const vec3 & c ) const;
+
+    int                     mSize = 0;
+    std::vector< float >    mData;
+    vec3                    mDomainMin = vec3( 0.f );
+    vec3                    mDomainMax = vec3( 1.f );
+};
+
+//! A per-channel 1D lookup table held on the CPU, stored as interleaved RGB
+//! floats.
+class Lut1d
+{
+public:
+    static Lut1dRef create( int size )
+    {
+        return std::make_shared< Lut1d >( size );
+    }
+
+    Lut1d() {}
+    explicit Lut1d( int size );
+    Lut1d( int size, std::vector< float > data );
+
+    int getSize() const { return mSize; }
+
+    const std::vector< float > & getData() const { return mData; }
+    std::vector< float > & getData() { return mData; }
+
+    //! The input range mapped onto the table, [0, 1] by default.
+    void setDomain( const vec3 & min, const vec3 & max ) { mDomainMin = min; mDomainMax = max; }
+    const vec3 & getDomainMin() const { return mDomainMin; }
+    const vec3 & getDomainMax() const { return mDomainMax; }
+
+    vec3 at( int i ) const { return vec3( mData[ 3 * i ], mData[ 3 * i + 1 ], mData[ 3 * i + 2 ] ); }
+    void set( int i, const vec3 & v ) { mData[ 3 * i ] = v.r; mData[ 3 * i + 1 ] = v.g; mData[ 3 * i + 2 ] = v.b; }
+
+    //! Linearly interpolates each channel independently.
+    vec3 lookup( const vec3 & c ) const;
+
+    //! Applies the LUT to every pixel of \a surface, in place.
+    void apply( Surface32f & surface ) const;
+
+private:
+    int                     mSize = 0;
+    std::vector< float >    mData;
+    vec3                    mDomainMin = vec3( 0.f );
+    vec3                    mDomainMax = vec3( 1.f );
+};
+
+}
+}
@@ -4,6 +4,10 @@
 #include "cinder/gl/Fbo.h"
 
 #include "cinder/FrameGraph.hpp"
+#include "cinder/framegraph/Lut.hpp"
+#include "cinder/framegraph/RenderStage.hpp"
+#include "cinder/framegraph/ProxyScale.hpp"
+#include "cinder/framegraph/ProgramRegistry.hpp"
 #include "libnodes/NodeContainer.h"
 #include "cinder/framegraph/Types.hpp"
 
@@ -73,10 +77,11 @@ public:
 private:
 	Config						mConfig;
 	core::ConstProcessorRcPtr	mProcessor;
+	ci::Surface32fRef			mOutput;
 };
 
 //! A node that does processing on the GPU.
-class ProcessGPUIONode : public TextureIONode
+class ProcessGPUIONode : public TextureIONode, public RenderStage
 {
 public:
 	static ProcessGPUIONodeRef create( const Config & config )
@@ -103,6 +108,20 @@ public:
 	std::string getLook() const { return mLook; }
 
 	void setExposureFStop( float exposure );
+
+	//! Sets the number of lattice points along each axis of the baked 3D
+	//! LUT. Defaults to 32.
+	void setLUTSize( int size );
+	int getLUTSize() const { return mLUTSize; }
+
+	//! Sets the precision of the baked 3D LUT, GL_RGB16F by default.
+	void setLUTInternalFormat( GLint internalFormat );
+	GLint getLUTInternalFormat() const { return mLUTInternalFormat; }
+
+	//! Selects hardware trilinear filtering or tetrahedral interpolation of
+	//! the baked 3D LUT.
+	void setLUTInterpolation( Lut3d::Interpolation interpolation );
+	Lut3d::Interpolation getLUTInterpolation() const { return mLUTInterpolation; }
 private:
 	class BatchFormat
 	{
@@ -113,13 +132,19 @@ private:
 		BatchFormat & textureSize( const ci::vec2 & size ) { mTextureSize = size; return *this; }
 		ci::vec2 getTextureSize() const { return mTextureSize; }
 
-		bool operator == ( const BatchFormat & rhs ) const { return mTextureTarget == rhs.mTextureTarget && mTextureSize == rhs.mTextureSize; }
+		BatchFormat & lutInterpolation( Lut3d::Interpolation interpolation ) { mLUTInterpolation = interpolation; return *this; }
+		Lut3d::Interpolation getLUTInterpolation() const { return mLUTInterpolation; }
+
+		bool operator == ( const BatchFormat & rhs ) const { return mTextureTarget == rhs.mTextureTarget && mTextureSize == rhs.mTextureSize && mLUTInterpolation == rhs.mLUTInterpolation; }
 
 	private:
-		GLenum		mTextureTarget;
-		ci::vec2	mTextureSize;
+		GLenum					mTextureTarget = 0;
+		ci::vec2				mTextureSize;
+		Lut3d::Interpolation	mLUTInterpolation = Lut3d::Interpolation::TRILINEAR;
 	};
 
+	//! Generates the program for \a fmt and builds the batch once it has
+	//! compiled. Waits for it only when there is no batch that can draw yet.
 	void						updateBatch( const BatchFormat & fmt );
 	void						updateProcessor();
 
@@ -131,12 +156,19 @@ private:
 	std::string					mLook = "";
 	float						mExposureFStop = 0.f;
 	bool						mProcessorNeedsUpdate = false;
+	bool						mBatchNeedsUpdate = false;
+	int							mLUTSize = 32;
+	GLint						mLUTInternalFormat = GL_RGB16F;
+	Lut3d::Interpolation		mLUTInterpolation = Lut3d::Interpolation::TRILINEAR;
 
 	core::ConstProcessorRcPtr	mProcessor = nullptr;
 	core::GpuShaderDesc			mShaderDesc;
 	ci::gl::Texture3dRef		mLUTTex = nullptr;
 	ci::gl::FboRef				mFbo;
 	ci::gl::BatchRef			mBatch;
+	SharedProgramRef			mProgram;
+	uint32_t					mProgramVersion = 0;
+	bool						mProgramChanged = false;
 	ci::mat4					mModelMatrix;
 	BatchFormat					mBatchFormat;
 };
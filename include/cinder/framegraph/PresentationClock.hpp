@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace cinder {
+namespace frame_graph {
+
+//! The time sources present at, shared by every source in the graph so they
+//! advance in lockstep. Each frame is assigned the vsync it can be
+//! presented at given the latency budget and how long frames have been
+//! taking to render, and its presentation time is a function of that vsync
+//! alone. A frame projected to miss its vsync targets a later one, so
+//! sources skip frames rather than drifting behind; a frame that comes
+//! around before the next vsync repeats the previous one.
+//!
+//! The vsync grid locks onto the phase of frame starts that are a whole
+//! number of refreshes apart, as they are in a vsync-locked loop. Frames
+//! only repeat or drop when they land clearly off the next vsync, so timer
+//! jitter doesn't make a steady loop alternate between the two.
+//!
+//!     clock.beginFrame();     // at the start of update()
+//!     movie.update();         // sources sample clock.getTime()
+//!     ...
+//!     clock.endFrame();       // at the end of draw()
+//!
+//! Windows of a multi-screen show share one clock, so all their sources
+//! show the same frame.
+class PresentationClock
+{
+public:
+    class Format
+    {
+    public:
+        Format() {}
+
+        //! The display refresh rate. Defaults to 60 Hz.
+        Format & refreshRate( double hz ) { mRefreshRate = hz; return *this; }
+        double getRefreshRate() const { return mRefreshRate; }
+
+        //! The least time allowed between starting a frame and its vsync.
+        //! Frames are planned with this or the measured render time,
+        //! whichever is longer. Defaults to half a refresh.
+        Format & latencyBudget( double seconds ) { mLatencyBudget = seconds; return *this; }
+        double getLatencyBudget() const { return mLatencyBudget < 0.0 ? 0.5 / mRefreshRate : mLatencyBudget; }
+
+    private:
+        double  mRefreshRate = 60.0;
+        double  mLatencyBudget = -1.0;
+    };
+
+    struct Stats {
+        uint64_t    frames = 0;
+        //! Vsyncs skipped because a frame couldn't make the next one.
+        uint64_t    dropped = 0;
+        //! Frames that showed the previous frame's sources again.
+        uint64_t    repeated = 0;
+        //! Frames that finished after their vsync.
+        uint64_t    late = 0;
+        double      meanRenderTime = 0.0;
+        double      maxRenderTime = 0.0;
+    };
+
+    //! The clock shared by the sources of the process.
+    static PresentationClock & instance();
+
+    explicit PresentationClock( const Format & format = Format() );
+
+    void setFormat( const Format & format ) { mFormat = format; }
+    const Format & getFormat() const { return mFormat; }
+
+    //! Restarts time at zero and clears the statistics.
+    void start();
+
+    //! Plans the frame: picks its vsync and presentation time.
+    void beginFrame();
+    //! Records how long the frame took and whether it made its vsync.
+    void endFrame();
+
+    //! The presentation time of the current frame, in whole refreshes since
+    //! start().
+    double getTime() const { return mVsync * getPeriod(); }
+    //! The vsync the current frame is presented at.
+    int64_t getVsync() const { return mVsync; }
+    //! The vsyncs since the previous frame: 1 normally, 0 when repeating
+    //! and more when vsyncs were dropped.
+    int64_t getAdvance() const { return mAdvance; }
+
+    double getPeriod() const { return 1.0 / mFormat.getRefreshRate(); }
+
+    //! The smoothed render time frames are planned with.
+    double getRenderEstimate() const { return mRenderEstimate; }
+
+    const Stats & getStats() const { return mStats; }
+    void resetStats() { mStats = Stats(); }
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    double now() const;
+
+    Format              mFormat;
+    clock::time_point   mStart;
+    double              mBeginTime = 0.0;
+    //! When vsync 0 was, in seconds since start().
+    double              mPhase = 0.0;
+    int64_t             mVsync = 0;
+    int64_t             mAdvance = 0;
+    bool                mFirst = true;
+    double              mRenderEstimate = 0.0;
+    double              mRenderTotal = 0.0;
+    Stats               mStats;
+};
+
+}
+}
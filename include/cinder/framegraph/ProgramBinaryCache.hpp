@@ -0,0 +1,63 @@
+#pragma once
+
+#include "cinder/gl/GlslProg.h"
+#include "cinder/Filesystem.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cinder {
+namespace frame_graph {
+
+//! A GlslProg linked from a driver binary instead of GLSL sources. The base
+//! class always compiles its format, so it is built from a trivial program
+//! carrying the format's bindings and semantics, whose handle is then
+//! relinked from the binary and introspected as usual.
+class BinaryGlslProg : public ci::gl::GlslProg
+{
+public:
+    //! Returns null if the driver rejects \a binary, e.g. after an update.
+    static ci::gl::GlslProgRef create( const Format & format, GLenum binaryFormat, const std::vector< uint8_t > & binary );
+
+protected:
+    BinaryGlslProg( const Format & format, GLenum binaryFormat, const std::vector< uint8_t > & binary );
+
+    static Format getStubFormat( const Format & format );
+
+    bool    mLoaded = false;
+};
+
+//! Keeps linked programs on disk as driver binaries, keyed by a hash of
+//! their sources and of the GL vendor, renderer and version, so later
+//! launches load them with glProgramBinary instead of compiling GLSL. The
+//! ShaderCompiler creates every program through it. Disabled until a
+//! directory is set.
+class ProgramBinaryCache
+{
+public:
+    static ProgramBinaryCache & instance();
+
+    //! Stores binaries in \a dir, which is created if needed. An empty path
+    //! disables the cache.
+    void setDirectory( const ci::fs::path & dir );
+    ci::fs::path getDirectory() const;
+
+    //! Loads the program for \a format from the cache, or compiles it and
+    //! stores its binary. Binaries that are missing, stale or rejected by
+    //! the driver fall back to compiling. Call with a current context.
+    //! Throws the usual GlslProg exceptions.
+    ci::gl::GlslProgRef create( const ci::gl::GlslProg::Format & format );
+
+private:
+    ProgramBinaryCache() {}
+
+    ci::fs::path getPath( const ci::gl::GlslProg::Format & format );
+    void store( const ci::fs::path & path, const ci::gl::GlslProgRef & program );
+
+    mutable std::mutex  mMutex;
+    ci::fs::path        mDirectory;
+    std::string         mDriver;
+};
+
+}
+}
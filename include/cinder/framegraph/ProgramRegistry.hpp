@@ -0,0 +1,79 @@
+#pragma once
+
+#include "cinder/framegraph/ShaderCompiler.hpp"
+#include "cinder/FileWatcher.h"
+#include "cinder/Signals.h"
+#include <map>
+
+namespace cinder {
+namespace frame_graph {
+
+typedef std::shared_ptr< class SharedProgram > SharedProgramRef;
+
+//! A program shared by every render stage built from the same shader
+//! sources. Stages keep their uniform values themselves and set them before
+//! each draw, so sharing the program doesn't mix up their parameters.
+class SharedProgram
+{
+public:
+    //! Wraps a program that isn't shared.
+    static SharedProgramRef create( const ci::gl::GlslProgRef & program );
+
+    //! The last program that compiled, or the first compile while it is
+    //! still running.
+    const GlslProgFuture & getProgram() const { return mProgram; }
+
+    //! Swaps in a reload that has finished compiling. A reload that failed
+    //! is logged and dropped, keeping the last good program. Call from the
+    //! GL thread, before getProgram().
+    void update();
+
+    //! Incremented each time a reload is swapped in.
+    uint32_t getVersion() const { return mVersion; }
+
+    //! Emitted when the watched shader files change, before recompiling.
+    ci::signals::Signal< void( const WatchEvent & ) > & getSignalChanged() { return mSignalChanged; }
+
+private:
+    friend class ProgramRegistry;
+
+    ci::gl::GlslProg::Format                            mFormat;
+    GlslProgFuture                                      mProgram;
+    GlslProgFuture                                      mReload;
+    uint32_t                                            mVersion = 0;
+    bool                                                mWatched = false;
+    ci::signals::Signal< void( const WatchEvent & ) >   mSignalChanged;
+};
+
+//! Compiles each distinct program once per process. Programs are keyed by
+//! their sources, defines and GLSL version, and released when the last
+//! stage using them is destroyed.
+class ProgramRegistry
+{
+public:
+    static ProgramRegistry & instance();
+
+    //! Returns the program for \a format, queueing it on the ShaderCompiler
+    //! if no live stage uses it yet.
+    SharedProgramRef get( const ci::gl::GlslProg::Format & format );
+
+    //! Returns the program for \a format and reloads it, once for all its
+    //! users, whenever its vertex or fragment file changes. Watched programs
+    //! are also keyed by their file paths.
+    SharedProgramRef watch( const ci::gl::GlslProg::Format & format );
+
+    //! The number of distinct programs in use.
+    size_t getNumPrograms() const;
+
+    //! The key of \a format's program, including its vertex and fragment
+    //! paths if \a withPaths is true.
+    static std::string getKey( const ci::gl::GlslProg::Format & format, bool withPaths = false );
+
+private:
+    SharedProgramRef get( const std::string & key, const ci::gl::GlslProg::Format & format );
+
+    std::map< std::string, std::weak_ptr< SharedProgram > > mPrograms;
+};
+
+}
+}
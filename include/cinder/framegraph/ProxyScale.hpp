@@ -0,0 +1,78 @@
+#pragma once
+
+#include "cinder/gl/Texture.h"
+#include "cinder/Signals.h"
+#include <chrono>
+#include <map>
+
+namespace cinder {
+namespace frame_graph {
+
+//! Global preview resolution. Call interact() whenever the user scrubs a
+//! parameter and update() once a frame: while interacting, render stages
+//! render at the proxy scale of their full size, and they return to full
+//! resolution once interaction has been idle for the timeout.
+//!
+//! Render stages also record the full resolution size each texture they
+//! render stands in for, so stages downstream of a proxy render derive
+//! their size from the source rather than from the proxy.
+class ProxyScale
+{
+public:
+    static ProxyScale & instance();
+
+    //! Sets the scale used while interacting, e.g. 0.5 or 0.25. Defaults to
+    //! 0.5; 1 disables proxy rendering.
+    void setProxyScale( float scale );
+    float getProxyScale() const { return mProxyScale; }
+
+    //! Sets the idle time before returning to full resolution. Defaults to
+    //! 0.25 seconds.
+    void setIdleTimeout( double seconds ) { mIdleTimeout = seconds; }
+    double getIdleTimeout() const { return mIdleTimeout; }
+
+    //! Switches to the proxy scale and restarts the idle timer.
+    void interact();
+
+    //! Returns to full resolution once the idle timeout has passed.
+    void update();
+
+    //! The scale render stages currently render at.
+    float getScale() const { return mProxy ? mProxyScale : 1.f; }
+    bool isProxy() const { return mProxy; }
+
+    //! Emitted with the new scale when it changes. Sources that only emit on
+    //! demand should re-emit so the graph re-renders at the new resolution.
+    ci::signals::Signal< void( float ) > & getSignalScaleChanged() { return mSignalScaleChanged; }
+
+    //! Returns \a fullSize at the current scale, at least one pixel.
+    ci::ivec2 getScaledSize( const ci::ivec2 & fullSize ) const;
+
+    //! Records that \a texture was rendered for a full resolution size of
+    //! \a fullSize.
+    void registerTexture( const ci::gl::Texture2dRef & texture, const ci::ivec2 & fullSize );
+
+    //! Returns the full resolution size \a texture stands in for, which is
+    //! its own size unless it was registered by a render stage.
+    ci::ivec2 getFullSize( const ci::gl::Texture2dRef & texture ) const;
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    struct Entry {
+        std::weak_ptr< ci::gl::Texture2d >  texture;
+        ci::ivec2                           fullSize;
+    };
+
+    void setProxy( bool proxy );
+
+    float                                   mProxyScale = 0.5f;
+    double                                  mIdleTimeout = 0.25;
+    bool                                    mProxy = false;
+    clock::time_point                       mLastInteraction;
+    ci::signals::Signal< void( float ) >    mSignalScaleChanged;
+    std::map< const ci::gl::Texture2d *, Entry > mFullSizes;
+};
+
+}
+}
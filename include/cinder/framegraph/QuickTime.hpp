@@ -2,6 +2,7 @@
 
 #include "cinder/FrameGraph.hpp"
 #include "cinder/framegraph/concurrent_queue.h"
+#include "cinder/framegraph/PresentationClock.hpp"
 #include "cinder/qtime/QuickTimeGl.h"
 #include "cinder/qtime/AvfWriter.h"
 #include <thread>
@@ -29,11 +30,18 @@ public:
 
 	QTMovieGlINode & play() { mMovie->play(); return *this; }
 	QTMovieGlINode & stop() { mMovie->stop(); return *this; }
-	QTMovieGlINode & loop( bool enabled = true ) { mMovie->setLoop( enabled ); return *this; }
+	QTMovieGlINode & loop( bool enabled = true ) { mMovie->setLoop( enabled ); mLooping = enabled; return *this; }
 	QTMovieGlINode & seekToTime( float seconds ) { mMovie->seekToTime( seconds ); return *this; }
 	QTMovieGlINode & seekToFrame( int frame ) { mMovie->seekToFrame( frame ); return *this; }
 	QTMovieGlINode & seekToStart() { mMovie->seekToStart(); return *this; }
-	QTMovieGlINode & setRate( float rate ) { mMovie->setRate( rate ); return *this; }
+	QTMovieGlINode & setRate( float rate ) { mMovie->setRate( rate ); mRate = rate; return *this; }
+
+	//! Presents the frame at \a offset plus the time of \a clock, seeking
+	//! when playback drifts more than a frame and a half from it, and
+	//! holding the previous frame when the clock repeats one. Pass nullptr
+	//! to play freely again.
+	QTMovieGlINode & syncTo( PresentationClock * clock = &PresentationClock::instance(), float offset = 0.f ) { mClock = clock; mClockOffset = offset; return *this; }
+	PresentationClock * getClock() const { return mClock; }
 
 	float getDuration() const { return mMovie->getDuration(); }
 	float getCurrentTime() const { return mMovie->getCurrentTime(); }
@@ -43,8 +51,13 @@ public:
 	ci::vec2 getSize() const { return mMovie->getSize(); }
 
 private:
+	void syncToClock();
 
-	ci::qtime::MovieGlRef mMovie;
+	ci::qtime::MovieGlRef	mMovie;
+	bool					mLooping = false;
+	float					mRate = 1.f;
+	PresentationClock *		mClock = nullptr;
+	float					mClockOffset = 0.f;
 };
 
 
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "cinder/gl/Texture.h"
+#include "cinder/Filesystem.h"
+#include "cinder/Surface.h"
+#include <functional>
+#include <map>
+
+namespace cinder {
+namespace frame_graph {
+
+//! How far a rendered image is from its golden image.
+struct ImageDiff {
+    //! The largest difference of any channel of any pixel.
+    float   maxError = 0.f;
+    //! The mean over pixels of their largest channel difference.
+    float   meanError = 0.f;
+    //! The number of pixels with a channel differing by more than the
+    //! tolerance.
+    size_t  numFailing = 0;
+    bool    sizeMismatch = false;
+};
+
+//! Compares \a result to \a golden channel by channel.
+ImageDiff compareImages( const ci::Surface32f & result, const ci::Surface32f & golden, float tolerance );
+
+//! Renders fixed inputs through render stages and checks the results
+//! against golden images, timing each case so slowdowns are caught along
+//! with visual changes:
+//!
+//!     RegressionSuite suite( RegressionSuite::Format().goldens( "goldens" ).baseline( "timings.json" ) );
+//!     suite.add( "lut", [&] { image.update(); return out.getTexture(); } );
+//!     bool passed = suite.run();
+//!     suite.writeTimings( "timings.json" );
+//!
+//! Goldens are PNGs named after their case. A case without a golden fails;
+//! run with Format::updateGoldens() to record goldens from the current
+//! results.
+class RegressionSuite
+{
+public:
+    class Format
+    {
+    public:
+        Format() {}
+
+        //! The directory of the golden images.
+        Format & goldens( const ci::fs::path & directory ) { mGoldens = directory; return *this; }
+        const ci::fs::path & getGoldens() const { return mGoldens; }
+
+        //! Where the results of failing cases are written, next to their
+        //! goldens by default.
+        Format & failures( const ci::fs::path & directory ) { mFailures = directory; return *this; }
+        const ci::fs::path & getFailures() const { return mFailures; }
+
+        //! The largest channel difference that still matches. Goldens are
+        //! 8 bit and renderers round differently, so 2 / 255 by default.
+        Format & tolerance( float tolerance ) { mTolerance = tolerance; return *this; }
+        float getTolerance() const { return mTolerance; }
+
+        //! The fraction of pixels allowed to exceed the tolerance.
+        Format & maxFailingFraction( float fraction ) { mMaxFailingFraction = fraction; return *this; }
+        float getMaxFailingFraction() const { return mMaxFailingFraction; }
+
+        //! Renders before timing, which compile shaders and allocate targets.
+        Format & warmup( int runs ) { mWarmup = runs; return *this; }
+        int getWarmup() const { return mWarmup; }
+
+        //! Timed renders per case.
+        Format & iterations( int runs ) { mIterations = runs; return *this; }
+        int getIterations() const { return mIterations; }
+
+        //! Timings written by writeTimings() by an earlier run. A case fails
+        //! if its median time exceeds the baseline's by more than \a slack.
+        Format & baseline( const ci::fs::path & path, float slack = 1.25f ) { mBaseline = path; mSlack = slack; return *this; }
+        const ci::fs::path & getBaseline() const { return mBaseline; }
+        float getSlack() const { return mSlack; }
+
+        //! Rewrites every golden from the current results.
+        Format & updateGoldens( bool update = true ) { mUpdateGoldens = update; return *this; }
+        bool getUpdateGoldens() const { return mUpdateGoldens; }
+
+    private:
+        ci::fs::path    mGoldens;
+        ci::fs::path    mFailures;
+        float           mTolerance = 2.f / 255.f;
+        float           mMaxFailingFraction = 0.f;
+        int             mWarmup = 2;
+        int             mIterations = 10;
+        ci::fs::path    mBaseline;
+        float           mSlack = 1.25f;
+        bool            mUpdateGoldens = false;
+    };
+
+    //! Renders the case and returns its output.
+    typedef std::function< ci::gl::Texture2dRef() > RenderFn;
+
+    struct Result {
+        std::string     name;
+        ImageDiff       diff;
+        bool            recorded = false;
+        bool            imagePassed = false;
+        bool            timePassed = true;
+        double          minMs = 0.0;
+        double          medianMs = 0.0;
+        double          meanMs = 0.0;
+        //! The baseline's median, or 0 if there is none.
+        double          baselineMs = 0.0;
+
+        bool passed() const { return imagePassed && timePassed; }
+    };
+
+    explicit RegressionSuite( const Format & format = Format() );
+
+    void add( const std::string & name, const RenderFn & render );
+
+    //! Runs every case on the current context. Returns whether all passed.
+    bool run();
+
+    const std::vector< Result > & getResults() const { return mResults; }
+
+    //! Writes the results as JSON along with the GL renderer, for use as a
+    //! baseline or for tracking over time.
+    void writeTimings( const ci::fs::path & path ) const;
+
+private:
+    struct Case {
+        std::string name;
+        RenderFn    render;
+    };
+
+    Result run( const Case & c, const std::map< std::string, double > & baseline );
+
+    Format                  mFormat;
+    std::vector< Case >     mCases;
+    std::vector< Result >   mResults;
+};
+
+}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "cinder/gl/Fbo.h"
+
+namespace cinder {
+namespace frame_graph {
+
+//! Color formats for intermediate render targets.
+enum class RenderFormat {
+    RGBA8,      //!< 4 bytes, [0, 1] at 8 bits
+    R11G11B10F, //!< 4 bytes, unsigned float with a 5-6 bit mantissa, no alpha
+    RGBA16F,    //!< 8 bytes, half float
+    RGBA32F     //!< 16 bytes, single float
+};
+
+//! The precision a node needs from the textures it receives, lowest first.
+enum class Precision {
+    LDR,        //!< display-referred values in [0, 1]
+    HDR_PACKED, //!< values above 1 at low precision
+    HDR_HALF,   //!< values above 1 or below 0 at half float precision
+    HDR_FLOAT   //!< full float precision
+};
+
+GLint getInternalFormat( RenderFormat format );
+size_t getBytesPerPixel( RenderFormat format );
+bool hasAlpha( RenderFormat format );
+
+//! Returns the smallest format that satisfies \a precision, with an alpha
+//! channel if \a alpha is true.
+RenderFormat getCheapestFormat( Precision precision, bool alpha );
+
+//! Returns an FBO format with a color texture of \a format.
+ci::gl::Fbo::Format getFboFormat( RenderFormat format );
+
+}
+}
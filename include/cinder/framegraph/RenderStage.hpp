@@ -0,0 +1,101 @@
+#pragma once
+
+#include "cinder/Area.h"
+#include "cinder/Rect.h"
+#include "cinder/framegraph/RenderFormat.hpp"
+#include <cmath>
+#include <vector>
+
+namespace cinder {
+namespace frame_graph {
+
+//! A node that renders to textures, consumes them, or both. Render stages
+//! take part in format negotiation and region of interest propagation
+//! through a StageGraph.
+class RenderStage
+{
+public:
+    virtual ~RenderStage() {}
+
+    //! Sets the format of the textures this node renders.
+    virtual void setOutputFormat( RenderFormat format ) { mOutputFormat = format; }
+    RenderFormat getOutputFormat() const { return mOutputFormat; }
+
+    //! Declares the precision this node needs from its inputs, and whether it
+    //! uses their alpha channel.
+    void setInputPrecision( Precision precision, bool alpha = true ) { mInputPrecision = precision; mInputAlpha = alpha; }
+    Precision getInputPrecision() const { return mInputPrecision; }
+    bool needsInputAlpha() const { return mInputAlpha; }
+
+    //! Stages that pass their inputs through, like point-wise shaders, cannot
+    //! restore precision lost upstream, so during negotiation their consumers'
+    //! requirements are forwarded to their own inputs. Sinks and stages that
+    //! quantize anyway can opt out.
+    void setForwardsPrecision( bool forwards ) { mForwardsPrecision = forwards; }
+    bool forwardsPrecision() const { return mForwardsPrecision; }
+
+    //! Sets the part of the output that is used, in normalized coordinates
+    //! with the origin at the top left. Sinks declare what they display;
+    //! StageGraph::propagateRegions() sets it on everything upstream.
+    void setRegionOfInterest( const ci::Rectf & region ) { mRegion = region; }
+    const ci::Rectf & getRegionOfInterest() const { return mRegion; }
+
+    //! Returns true if the whole output is used.
+    bool isRegionFull() const { return mRegion.x1 <= 0.f && mRegion.y1 <= 0.f && mRegion.x2 >= 1.f && mRegion.y2 >= 1.f; }
+
+    //! Returns the region of interest in pixels of a render target of
+    //! \a size, rounded outwards.
+    ci::Area getRegionArea( const ci::ivec2 & size ) const
+    {
+        return ci::Area( (int)std::floor( mRegion.x1 * size.x ), (int)std::floor( mRegion.y1 * size.y ),
+                         (int)std::ceil( mRegion.x2 * size.x ), (int)std::ceil( mRegion.y2 * size.y ) );
+    }
+
+    //! Sets how far beyond its region of interest this node reads its inputs,
+    //! as a fraction of the image size, e.g. a blur radius over the width.
+    void setInputMargin( float margin ) { mInputMargin = margin; }
+    float getInputMargin() const { return mInputMargin; }
+
+private:
+    RenderFormat    mOutputFormat = RenderFormat::RGBA8;
+    Precision       mInputPrecision = Precision::LDR;
+    bool            mInputAlpha = true;
+    bool            mForwardsPrecision = true;
+    ci::Rectf       mRegion = ci::Rectf( 0.f, 0.f, 1.f, 1.f );
+    float           mInputMargin = 0.f;
+};
+
+//! The producer to consumer links between render stages. libnodes
+//! connections don't expose the graph, so links mirror the >> connections:
+//!
+//!     StageGraph stages;
+//!     stages.link( grader, lut ).link( lut, out );
+//!     stages.negotiateFormats();
+class StageGraph
+{
+public:
+    //! Records that \a consumer reads the output of \a producer.
+    StageGraph & link( RenderStage & producer, RenderStage & consumer );
+
+    void clear() { mLinks.clear(); }
+
+    //! Sets the output format of every producer to the cheapest format that
+    //! satisfies everything downstream of it. Producers without consumers
+    //! keep their format.
+    void negotiateFormats();
+
+    //! Sets the region of interest of every producer to the union of what its
+    //! consumers read. Call after changing the regions of the sinks.
+    void propagateRegions();
+
+private:
+    struct Link {
+        RenderStage * producer;
+        RenderStage * consumer;
+    };
+
+    std::vector< Link > mLinks;
+};
+
+}
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "cinder/FrameGraph.hpp"
+#include "cinder/gl/Pbo.h"
+#include "cinder/gl/Sync.h"
+#include "cinder/gl/Vao.h"
+#include <deque>
+
+namespace cinder {
+namespace frame_graph {
+
+typedef ref< class ScopeNode > ScopeNodeRef;
+
+enum class ScopeType {
+    HISTOGRAM,  //!< counts of R, G, B and luminance values
+    WAVEFORM,   //!< the same per image column
+    VECTORSCOPE //!< counts of Rec. 709 Cb, Cr pairs
+};
+
+//! The result of a scope: a grid of counts for each channel. Histograms are
+//! one row of bins with channels R, G, B and luminance. Waveforms have a
+//! column per range of image columns and a row per bin, with the same
+//! channels. Vectorscopes have a single channel with Cb along x and Cr
+//! along y. Row 0 holds the lowest values.
+struct Scope {
+    ScopeType               type = ScopeType::HISTOGRAM;
+    int                     width = 0;
+    int                     height = 0;
+    int                     channels = 0;
+    std::vector< uint32_t > counts;
+
+    uint32_t at( int channel, int x, int y = 0 ) const { return counts[ ( (size_t)channel * height + y ) * width + x ]; }
+};
+
+typedef std::shared_ptr< const Scope > ScopeRef;
+
+//! Computes histograms, waveforms or vectorscopes. Surfaces received on the
+//! first inlet are analyzed on the ThreadPool and the result is emitted
+//! right away. Textures received on the second inlet are reduced on the GPU
+//! and only the small result is read back, asynchronously, so it is emitted
+//! a frame or two later, when the readback has completed.
+class ScopeNode : public Node< Inlets< Surface32fRef, gl::Texture2dRef >, Outlets< ScopeRef > >
+{
+public:
+    class Format
+    {
+    public:
+        Format( ScopeType type = ScopeType::HISTOGRAM );
+
+        Format & type( ScopeType type ) { mType = type; return *this; }
+        ScopeType getType() const { return mType; }
+
+        //! Sets the size of the result. Defaults to 256 bins for histograms,
+        //! and 256 x 256 for waveforms and vectorscopes.
+        Format & size( int width, int height = 1 ) { mWidth = width; mHeight = height; return *this; }
+        int getWidth() const { return mWidth; }
+        int getHeight() const { return mHeight; }
+
+        //! Sets the range of values counted, [0, 1] for histograms and
+        //! waveforms and [-0.5, 0.5] for vectorscopes. Values outside it are
+        //! counted in the first or last bin.
+        Format & range( float min, float max ) { mMin = min; mMax = max; return *this; }
+        float getMin() const { return mMin; }
+        float getMax() const { return mMax; }
+
+        //! Analyzes every \a step th pixel along each axis. Defaults to 1.
+        Format & step( int step ) { mStep = step; return *this; }
+        int getStep() const { return mStep; }
+
+    private:
+        ScopeType   mType;
+        int         mWidth;
+        int         mHeight;
+        float       mMin;
+        float       mMax;
+        int         mStep = 1;
+    };
+
+    static ScopeNodeRef create( const Format & format = Format() )
+    {
+        return std::make_shared< ScopeNode >( format );
+    }
+
+    ScopeNode( const Format & format = Format() );
+
+    const Format & getFormat() const { return mFormat; }
+
+    //! Analyzes \a image on the CPU.
+    static ScopeRef analyze( const Surface32f & image, const Format & format );
+
+    virtual void update( const Surface32fRef & image );
+    virtual void update( const gl::Texture2dRef & texture );
+
+    //! Emits GPU results whose readback has completed, without new input.
+    void poll();
+
+private:
+    void setupGpu();
+
+    struct Readback {
+        gl::PboRef  pbo;
+        gl::SyncRef sync;
+    };
+
+    Format                      mFormat;
+    gl::FboRef                  mFbo = nullptr;
+    gl::GlslProgRef             mShader = nullptr;
+    gl::VaoRef                  mVao = nullptr;
+    std::deque< Readback >      mPending;
+    std::vector< gl::PboRef >   mFreePbos;
+};
+
+}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "cinder/gl/GlslProg.h"
+#include "cinder/gl/Context.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+namespace cinder {
+namespace frame_graph {
+
+typedef std::shared_future< ci::gl::GlslProgRef > GlslProgFuture;
+
+//! Compiles shader programs on a background thread with its own GL context,
+//! shared with the one rendering, so building a large graph or reloading a
+//! shader doesn't stall the render thread. Render stages take the program
+//! when they first render, by which time it is usually compiled. Programs
+//! are created through the ProgramBinaryCache, so with a cache directory
+//! set, later launches skip compiling.
+//!
+//! Programs compile synchronously instead when background compilation is
+//! disabled or a shared context can't be created. Other GL work that would
+//! stall the render thread, like large texture uploads, can run on the same
+//! context through submit().
+class ShaderCompiler
+{
+public:
+    static ShaderCompiler & instance();
+
+    ~ShaderCompiler();
+
+    //! Queues \a format for compilation. Call on the thread that renders,
+    //! which must have a current context. The future throws the usual
+    //! GlslProg exceptions if compilation fails.
+    GlslProgFuture compileAsync( const ci::gl::GlslProg::Format & format );
+
+    //! Queues \a task to run on the background context, after the programs
+    //! queued before it. Call on the thread that renders. Returns false
+    //! without running \a task when there is no background context; the
+    //! task should fence anything it hands back to the render thread.
+    bool submit( std::function< void() > task );
+
+    //! Enables compiling in the background. Defaults to true.
+    void setEnabled( bool enabled ) { mEnabled = enabled; }
+    bool isEnabled() const { return mEnabled; }
+
+    //! Returns true once a background context is running.
+    bool isRunning() const { return mThread.joinable(); }
+
+private:
+    ShaderCompiler() {}
+
+    bool start();
+    void run( ci::gl::ContextRef context );
+
+    bool                    mEnabled = true;
+    bool                    mFailed = false;
+    bool                    mStop = false;
+    std::thread             mThread;
+    std::mutex              mMutex;
+    std::condition_variable mCondition;
+    //! Dropping the queue on shutdown breaks the promises of unfinished
+    //! compiles, so nobody waits forever.
+    std::deque< std::function< void() > >   mJobs;
+};
+
+}
+}
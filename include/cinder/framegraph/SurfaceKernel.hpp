@@ -0,0 +1,312 @@
+#pragma once
+
+#include "cinder/FrameGraph.hpp"
+#include "cinder/framegraph/SurfacePool.hpp"
+#include "cinder/framegraph/ThreadPool.hpp"
+#include "cinder/Log.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+namespace cinder {
+namespace frame_graph {
+
+////////////////////////////////////////////////////////////////////////////////
+// Kernels
+
+//! Channels of N pixels in separate planes, so kernels written as loops over
+//! the lanes compile to vector instructions.
+template< std::size_t N >
+struct PixelBatch {
+    static_assert( N == 4 || N == 8, "batches are 4 or 8 pixels" );
+    static const std::size_t size = N;
+
+    alignas( 32 ) float r[ N ];
+    alignas( 32 ) float g[ N ];
+    alignas( 32 ) float b[ N ];
+    alignas( 32 ) float a[ N ];
+};
+
+namespace detail {
+
+//! Reads the pixels of one row of a surface as RGBA, with alpha 1 for
+//! surfaces without.
+class RowReader
+{
+public:
+    RowReader() {}
+    RowReader( const ci::Surface32f & surface, int32_t y ) :
+            mData( surface.getData( ci::ivec2( 0, y ) ) ),
+            mInc( surface.getPixelInc() ),
+            mR( surface.getRedOffset() ),
+            mG( surface.getGreenOffset() ),
+            mB( surface.getBlueOffset() ),
+            mA( surface.getAlphaOffset() ),
+            mAlpha( surface.hasAlpha() )
+    {}
+
+    ci::vec4 operator[]( int32_t x ) const
+    {
+        const float * p = mData + x * mInc;
+        return ci::vec4( p[ mR ], p[ mG ], p[ mB ], mAlpha ? p[ mA ] : 1.f );
+    }
+
+    template< std::size_t N >
+    void load( int32_t x, int32_t n, PixelBatch< N > & batch ) const
+    {
+        // the tail repeats the last pixel so kernels never see garbage
+        for ( std::size_t lane = 0; lane < N; ++lane ) {
+            ci::vec4 c = ( *this )[ x + std::min< int32_t >( (int32_t)lane, n - 1 ) ];
+            batch.r[ lane ] = c.r;
+            batch.g[ lane ] = c.g;
+            batch.b[ lane ] = c.b;
+            batch.a[ lane ] = c.a;
+        }
+    }
+
+private:
+    const float *   mData = nullptr;
+    uint8_t         mInc = 0;
+    int8_t          mR = 0, mG = 0, mB = 0, mA = 0;
+    bool            mAlpha = false;
+};
+
+class RowWriter
+{
+public:
+    RowWriter( ci::Surface32f & surface, int32_t y ) :
+            mData( surface.getData( ci::ivec2( 0, y ) ) ),
+            mInc( surface.getPixelInc() ),
+            mR( surface.getRedOffset() ),
+            mG( surface.getGreenOffset() ),
+            mB( surface.getBlueOffset() ),
+            mA( surface.getAlphaOffset() ),
+            mAlpha( surface.hasAlpha() )
+    {}
+
+    void set( int32_t x, const ci::vec4 & c )
+    {
+        float * p = mData + x * mInc;
+        p[ mR ] = c.r;
+        p[ mG ] = c.g;
+        p[ mB ] = c.b;
+        if ( mAlpha ) p[ mA ] = c.a;
+    }
+
+    template< std::size_t N >
+    void store( int32_t x, int32_t n, const PixelBatch< N > & batch )
+    {
+        for ( int32_t lane = 0; lane < n; ++lane ) {
+            set( x + lane, ci::vec4( batch.r[ lane ], batch.g[ lane ], batch.b[ lane ], batch.a[ lane ] ) );
+        }
+    }
+
+private:
+    float *     mData;
+    uint8_t     mInc;
+    int8_t      mR, mG, mB, mA;
+    bool        mAlpha;
+};
+
+}
+
+namespace kernel {
+
+//! Wraps \a fn( const std::array< vec4, I > & inputs ) -> vec4, called for
+//! every pixel with the pixels of the inputs at the same position.
+template< class F >
+struct Pixel {
+    F fn;
+
+    template< std::size_t I >
+    void operator()( const std::array< const ci::Surface32f *, I > & inputs, ci::Surface32f & output, int32_t y ) const
+    {
+        std::array< detail::RowReader, I > readers;
+        for ( std::size_t i = 0; i < I; ++i ) readers[ i ] = detail::RowReader( *inputs[ i ], y );
+        detail::RowWriter writer( output, y );
+
+        std::array< ci::vec4, I > pixels;
+        for ( int32_t x = 0; x < output.getWidth(); ++x ) {
+            for ( std::size_t i = 0; i < I; ++i ) pixels[ i ] = readers[ i ][ x ];
+            writer.set( x, fn( pixels ) );
+        }
+    }
+};
+
+//! Wraps \a fn( const std::array< const Surface32f *, I > & inputs,
+//! Surface32f & output, int32_t y ), called for every row.
+template< class F >
+struct Row {
+    F fn;
+
+    template< std::size_t I >
+    void operator()( const std::array< const ci::Surface32f *, I > & inputs, ci::Surface32f & output, int32_t y ) const
+    {
+        fn( inputs, output, y );
+    }
+};
+
+//! Wraps \a fn( const std::array< PixelBatch< N >, I > & inputs,
+//! PixelBatch< N > & output ), called for every N pixels of a row.
+template< std::size_t N, class F >
+struct Batch {
+    F fn;
+
+    template< std::size_t I >
+    void operator()( const std::array< const ci::Surface32f *, I > & inputs, ci::Surface32f & output, int32_t y ) const
+    {
+        std::array< detail::RowReader, I > readers;
+        for ( std::size_t i = 0; i < I; ++i ) readers[ i ] = detail::RowReader( *inputs[ i ], y );
+        detail::RowWriter writer( output, y );
+
+        std::array< PixelBatch< N >, I > in;
+        PixelBatch< N > out;
+        for ( int32_t x = 0; x < output.getWidth(); x += (int32_t)N ) {
+            int32_t n = std::min< int32_t >( (int32_t)N, output.getWidth() - x );
+            for ( std::size_t i = 0; i < I; ++i ) readers[ i ].load( x, n, in[ i ] );
+            fn( in, out );
+            writer.store( x, n, out );
+        }
+    }
+};
+
+template< class F >
+Pixel< F > pixel( F fn ) { return Pixel< F >{ fn }; }
+
+template< class F >
+Row< F > row( F fn ) { return Row< F >{ fn }; }
+
+template< std::size_t N, class F >
+Batch< N, F > batch( F fn ) { return Batch< N, F >{ fn }; }
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SurfaceKernelIONode
+
+template< std::size_t I, class Kernel >
+class SurfaceKernelIONode;
+
+template< std::size_t I, class Kernel >
+using SurfaceKernelIONodeRef = ref< SurfaceKernelIONode< I, Kernel > >;
+
+//! The CPU counterpart of TextureShaderIONode: applies a kernel to I
+//! Surface32f inputs of the same size, in bands of rows on the ThreadPool.
+//! Kernels are template parameters, so their bodies are inlined into the
+//! row loops. Renders once the last inlet receives a frame:
+//!
+//!     auto invert = makeSurfaceKernelIONode( kernel::pixel( []( const std::array< vec4, 1 > & in ) {
+//!         return vec4( vec3( 1.f ) - vec3( in[ 0 ] ), in[ 0 ].a );
+//!     } ) );
+//!     source >> *invert >> out;
+template< std::size_t I, class Kernel >
+class SurfaceKernelIONode : public Node< UniformInlets< Surface32fRef, I >, Outlets< Surface32fRef > >
+{
+public:
+    class Format
+    {
+    public:
+        Format() {}
+
+        //! Rows per task on the thread pool. Defaults to 16.
+        Format & rowGrain( size_t rows ) { mRowGrain = rows; return *this; }
+        size_t getRowGrain() const { return mRowGrain; }
+
+        //! Whether the output has alpha. By default it matches the first
+        //! input.
+        Format & alpha( bool alpha ) { mAlpha = alpha ? 1 : 0; return *this; }
+        int getAlpha() const { return mAlpha; }
+
+    private:
+        size_t  mRowGrain = 16;
+        int     mAlpha = -1;
+    };
+
+    static SurfaceKernelIONodeRef< I, Kernel > create( const Kernel & kernel, const Format & format = Format() )
+    {
+        return std::make_shared< SurfaceKernelIONode >( kernel, format );
+    }
+
+    SurfaceKernelIONode( const Kernel & kernel, const Format & format = Format() ) :
+            mKernel( kernel ),
+            mFormat( format )
+    {
+        listen();
+    }
+
+    //! The kernel, for changing the state of functors between frames.
+    Kernel & getKernel() { return mKernel; }
+    const Format & getFormat() const { return mFormat; }
+
+    //! Throughput of the most recent frame.
+    double getMegapixelsPerSecond() const { return mMegapixelsPerSecond; }
+
+    virtual void update( std::size_t i, const Surface32fRef & image )
+    {
+        mInputs[ i ] = image;
+        if ( i == I - 1 ) update();
+    }
+
+    virtual void update()
+    {
+        std::array< const ci::Surface32f *, I > inputs;
+        for ( std::size_t i = 0; i < I; ++i ) {
+            if ( ! mInputs[ i ] ) return;
+            if ( mInputs[ i ]->getSize() != mInputs[ 0 ]->getSize() ) {
+                CI_LOG_W( "Dropping a frame with inputs of different sizes" );
+                return;
+            }
+            inputs[ i ] = mInputs[ i ].get();
+        }
+
+        const ci::ivec2 size = mInputs[ 0 ]->getSize();
+        bool alpha = mFormat.getAlpha() < 0 ? mInputs[ 0 ]->hasAlpha() : mFormat.getAlpha() > 0;
+
+        // reuse the previous output unless a downstream node is holding on to it
+        if ( ! mOutput || mOutput.use_count() > 1 || mOutput->getSize() != size || mOutput->hasAlpha() != alpha ) {
+            mOutput = SurfacePool::instance().get( size.x, size.y, alpha );
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        ci::Surface32f & output = *mOutput;
+        const Kernel & kernel = mKernel;
+        ThreadPool::instance().parallelFor( size.y, mFormat.getRowGrain(), [&]( size_t begin, size_t end ) {
+            for ( size_t y = begin; y < end; ++y ) {
+                kernel( inputs, output, (int32_t)y );
+            }
+        } );
+
+        std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+        mMegapixelsPerSecond = size.x * size.y / std::max( elapsed.count(), 1e-9 ) / 1e6;
+
+        this->template out< 0 >().update( mOutput );
+    }
+
+protected:
+    void listen()
+    {
+        this->inlets().each_with_index( [&]( auto & inlet, size_t i ) {
+            inlet.onReceive( [&, i]( const Surface32fRef & image ) {
+                update( i, image );
+            } );
+        } );
+    }
+
+private:
+    Kernel                              mKernel;
+    Format                              mFormat;
+    std::array< Surface32fRef, I >      mInputs;
+    Surface32fRef                       mOutput = nullptr;
+    double                              mMegapixelsPerSecond = 0.0;
+};
+
+//! Creates a SurfaceKernelIONode with \a I inputs, deducing the kernel type.
+template< std::size_t I = 1, class Kernel >
+SurfaceKernelIONodeRef< I, Kernel > makeSurfaceKernelIONode( const Kernel & kernel, const typename SurfaceKernelIONode< I, Kernel >::Format & format = typename SurfaceKernelIONode< I, Kernel >::Format() )
+{
+    return SurfaceKernelIONode< I, Kernel >::create( kernel, format );
+}
+
+}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "cinder/FrameGraph.hpp"
+#include "cinder/framegraph/Lut.hpp"
+
+namespace cinder {
+namespace frame_graph {
+
+typedef ref< class SurfaceLUTNode > SurfaceLUTNodeRef;
+
+//! The CPU counterpart of LUTNode, for machines without a GPU. Applies an
+//! optional 1D LUT followed by a 3D LUT to Surface32f frames. The 3D LUT can
+//! be the same atlas image LUTNode uses, received on the second inlet, or
+//! Lut3d data on the third. Rows are processed in bands on the ThreadPool,
+//! eight pixels at a time with AVX2 gathers when the CPU supports it.
+class SurfaceLUTNode : public Node< Inlets<
+        Surface32fRef,  // source
+        Surface32fRef,  // 2D atlas LUT
+        Lut3dRef,       // 3D LUT
+        Lut1dRef        // 1D LUT
+>, Outlets< Surface32fRef > >
+{
+public:
+    typedef Lut3d::Interpolation Interpolation;
+
+    class Format
+    {
+    public:
+        Format() {}
+
+        //! Sets the lattice size of atlases received on the second inlet.
+        //! Defaults to 64.
+        Format & atlasSize( int size ) { mAtlasSize = size; return *this; }
+        int getAtlasSize() const { return mAtlasSize; }
+
+        Format & interpolation( Interpolation interpolation ) { mInterpolation = interpolation; return *this; }
+        Interpolation getInterpolation() const { return mInterpolation; }
+
+        //! Allows vectorized kernels. Disable to run the scalar reference.
+        Format & simd( bool enabled = true ) { mSimd = enabled; return *this; }
+        bool isSimd() const { return mSimd; }
+
+    private:
+        int             mAtlasSize = 64;
+        Interpolation   mInterpolation = Interpolation::TRILINEAR;
+        bool            mSimd = true;
+    };
+
+    static SurfaceLUTNodeRef create( const Format & format = Format() )
+    {
+        return std::make_shared< SurfaceLUTNode >( format );
+    }
+
+    SurfaceLUTNode( const Format & format = Format() );
+
+    void setLUT( const Lut3dRef & lut );
+    void setLUT( const Lut1dRef & lut );
+
+    virtual void update( const Surface32fRef & image );
+
+    const Format & getFormat() const { return mFormat; }
+
+    //! Throughput of the most recent frame.
+    double getMegapixelsPerSecond() const { return mMegapixelsPerSecond; }
+
+    //! Returns true if frames are processed with AVX2.
+    bool isSimdActive() const;
+
+private:
+    void updateAtlas( const Surface32fRef & atlas );
+
+    Format                  mFormat;
+    Surface32fRef           mAtlas = nullptr;
+    Lut3dRef                mLut3d = nullptr;
+    Lut1dRef                mLut1d = nullptr;
+    //! LUT channels split into separate planes for the vector kernels
+    std::vector< float >    mPlanes3d;
+    std::vector< float >    mPlanes1d;
+    Surface32fRef           mOutput = nullptr;
+    double                  mMegapixelsPerSecond = 0.0;
+};
+
+}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "cinder/Surface.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace cinder {
+namespace frame_graph {
+
+typedef std::shared_ptr< class SurfacePool > SurfacePoolRef;
+
+//! Recycles the memory of the Surface32f frames CPU nodes produce. Pixel
+//! memory is kept in size classes, so frames of a stream reuse the blocks
+//! of earlier ones instead of faulting in fresh pages, and goes back to the
+//! pool when the last reference to its surface drops. The surface objects
+//! are recycled too, so once a pipeline has warmed up getting a frame
+//! doesn't touch the heap.
+class SurfacePool : public std::enable_shared_from_this< SurfacePool >
+{
+public:
+    class Format
+    {
+    public:
+        Format() {}
+
+        //! Asks for transparent huge pages for blocks of 2 MB and more, where
+        //! the OS supports them. Defaults to true.
+        Format & hugePages( bool enabled ) { mHugePages = enabled; return *this; }
+        bool getHugePages() const { return mHugePages; }
+
+        //! Touches new blocks on the allocating thread, so their pages are
+        //! faulted in up front and, on NUMA systems with first-touch
+        //! placement, land on that thread's node. Defaults to false.
+        Format & prefault( bool enabled ) { mPrefault = enabled; return *this; }
+        bool getPrefault() const { return mPrefault; }
+
+        //! The most memory kept for reuse; blocks returned beyond it are
+        //! freed. Defaults to 1 GB.
+        Format & maxCachedBytes( size_t bytes ) { mMaxCachedBytes = bytes; return *this; }
+        size_t getMaxCachedBytes() const { return mMaxCachedBytes; }
+
+    private:
+        bool    mHugePages = true;
+        bool    mPrefault = false;
+        size_t  mMaxCachedBytes = size_t( 1 ) << 30;
+    };
+
+    struct Stats {
+        //! Blocks allocated from the OS.
+        size_t  allocations = 0;
+        //! Frames served from the pool.
+        size_t  reuses = 0;
+        size_t  cachedBytes = 0;
+    };
+
+    static SurfacePoolRef create( const Format & format = Format() )
+    {
+        return SurfacePoolRef( new SurfacePool( format ) );
+    }
+
+    //! The pool shared by the CPU nodes.
+    static SurfacePool & instance();
+
+    ~SurfacePool();
+
+    SurfacePool( const SurfacePool & ) = delete;
+    SurfacePool & operator=( const SurfacePool & ) = delete;
+
+    //! Returns a surface with uninitialized pixels. Its memory returns to
+    //! the pool when the last reference to it drops, even if that outlives
+    //! the pool's other owners.
+    Surface32fRef get( int32_t width, int32_t height, bool alpha );
+
+    //! Frees the memory kept for reuse.
+    void trim();
+
+    Stats getStats() const;
+
+private:
+    template< typename T > class WrapperAllocator;
+    class PooledSurface;
+
+    struct Block {
+        void *  data;
+        bool    mapped;
+    };
+
+    explicit SurfacePool( const Format & format );
+
+    static size_t getSizeClass( size_t bytes );
+
+    Block acquire( size_t sizeClass );
+    void release( const Block & block, size_t sizeClass );
+    Block allocateBlock( size_t sizeClass );
+    void freeBlock( const Block & block, size_t sizeClass );
+
+    void * acquireWrapper( size_t bytes );
+    void releaseWrapper( void * wrapper, size_t bytes );
+
+    Format                                          mFormat;
+    mutable std::mutex                              mMutex;
+    std::map< size_t, std::vector< Block > >        mFree;
+    std::map< size_t, std::vector< void * > >       mWrappers;
+    Stats                                           mStats;
+};
+
+}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "cinder/gl/Texture.h"
+#include "cinder/Surface.h"
+#include <vector>
+
+namespace cinder {
+namespace frame_graph {
+
+//! Streams CPU pixels into a texture it keeps, reallocated only when the
+//! size or format of the stream changes. Each upload copies the pixels once,
+//! into the next of a ring of pixel unpack buffers, and the transfer to the
+//! texture runs on the GPU while the CPU goes on. Buffers are mapped
+//! persistently when GL_ARB_buffer_storage is available, and are reused
+//! once the GPU has finished reading them.
+class TextureStream
+{
+public:
+    explicit TextureStream( size_t buffers = 3 );
+    ~TextureStream();
+
+    TextureStream( const TextureStream & ) = delete;
+    TextureStream & operator=( const TextureStream & ) = delete;
+
+    //! Uploads rows of \a rowBytes bytes. \a format is GL_RGB, GL_RGBA,
+    //! GL_BGR or GL_BGRA and \a type GL_UNSIGNED_BYTE, GL_HALF_FLOAT or
+    //! GL_FLOAT, stored in a texture of the same precision.
+    const ci::gl::Texture2dRef & upload( const void * data, const ci::ivec2 & size, GLenum format, GLenum type, ptrdiff_t rowBytes );
+
+    //! Uploads \a surface in its own type, or returns null if GL can't read
+    //! its channel order directly.
+    ci::gl::Texture2dRef upload( const ci::Surface8u & surface );
+    ci::gl::Texture2dRef upload( const ci::Surface32f & surface );
+
+    const ci::gl::Texture2dRef & getTexture() const { return mTexture; }
+    bool isPersistent() const { return mPersistent; }
+
+private:
+    struct Buffer {
+        GLuint      id = 0;
+        void *      mapped = nullptr;
+        GLsync      fence = nullptr;
+    };
+
+    template< typename T >
+    ci::gl::Texture2dRef uploadSurface( const ci::SurfaceT< T > & surface, GLenum type );
+    void allocate( size_t bytes );
+    void release();
+
+    std::vector< Buffer >   mBuffers;
+    size_t                  mNext = 0;
+    size_t                  mBufferSize = 0;
+    bool                    mPersistent = false;
+    ci::gl::Texture2dRef    mTexture;
+    GLenum                  mFormat = 0;
+    GLenum                  mType = 0;
+};
+
+}
+}
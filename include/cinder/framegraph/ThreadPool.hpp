@@ -0,0 +1,74 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace cinder {
+namespace frame_graph {
+
+//! A fixed set of worker threads shared by the CPU nodes.
+class ThreadPool
+{
+public:
+    //! Returns the process-wide pool, with one worker per hardware thread.
+    static ThreadPool & instance();
+
+    explicit ThreadPool( size_t numThreads );
+    ~ThreadPool();
+
+    ThreadPool( const ThreadPool & ) = delete;
+    ThreadPool & operator=( const ThreadPool & ) = delete;
+
+    size_t getNumThreads() const { return mWorkers.size(); }
+
+    //! Queues \a task to run on a worker thread.
+    std::future< void > submit( std::function< void() > task );
+
+    //! Splits [0, \a n) into ranges of at most \a grain elements and calls
+    //! \a fn( begin, end ) for each range on the pool. The calling thread
+    //! takes part and the call returns once every range has been processed,
+    //! so it is safe to call from within a task. If \a fn throws, the ranges
+    //! not yet started are skipped and the first exception is rethrown on the
+    //! calling thread once every running range has finished. \a fn is called
+    //! through a plain function pointer and the call's state lives on the
+    //! caller's stack, so a parallelFor doesn't allocate.
+    template< typename Fn >
+    void parallelFor( size_t n, size_t grain, Fn && fn )
+    {
+        typedef typename std::remove_reference< Fn >::type Callable;
+        Range range{ []( void * context, size_t begin, size_t end ) { ( *static_cast< Callable * >( context ) )( begin, end ); },
+                     const_cast< void * >( static_cast< const void * >( &fn ) ) };
+        dispatch( n, grain, range );
+    }
+
+private:
+    struct Range {
+        void    ( *call )( void *, size_t, size_t );
+        void *  context;
+    };
+
+    //! One parallelFor, shared by the caller and the workers helping it.
+    struct Job;
+
+    void dispatch( size_t n, size_t grain, const Range & range );
+    void work( Job & job );
+    void run();
+
+    std::vector< std::thread >                  mWorkers;
+    std::deque< std::packaged_task< void() > >  mTasks;
+    std::mutex                                  mMutex;
+    std::condition_variable                     mCV;
+    //! Jobs still wanting helpers, oldest first, linked through the jobs.
+    Job *                                       mJobs = nullptr;
+    Job *                                       mJobsTail = nullptr;
+    bool                                        mStop = false;
+};
+
+}
+}
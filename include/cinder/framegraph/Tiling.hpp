@@ -0,0 +1,129 @@
+#pragma once
+
+#include "cinder/Area.h"
+#include "cinder/FrameGraph.hpp"
+
+namespace cinder {
+namespace frame_graph {
+
+typedef ref< class TileINode > TileINodeRef;
+typedef ref< class TileONode > TileONodeRef;
+
+//! One tile of a tiled render. Tile textures all have the same size: the
+//! tile size plus a halo on each side, filled by clamping to the image edge
+//! where a tile runs past it. The part of the image a tile contributes,
+//! \a bounds, starts \a offset pixels into the texture.
+struct Tile {
+    ci::Area    bounds;
+    ci::ivec2   offset;
+    ci::ivec2   imageSize;
+    size_t      index = 0;
+    size_t      count = 0;
+};
+
+//! Streams an image larger than GL_MAX_TEXTURE_SIZE, or larger than fits in
+//! VRAM, through a shader chain tile by tile. Each tile's description is
+//! emitted on the second outlet, followed by its texture on the first:
+//!
+//!     tiles >> grader >> lut >> sink;
+//!     tiles.out< 1 >() >> sink.in< 1 >();
+//!     tiles.update();
+//!
+//! Downstream stages should be sized automatically so their render targets
+//! follow the tile size, keeping peak GPU memory proportional to the tile
+//! size rather than the image size. The halo must cover the widest filter
+//! in the chain. Tiled renders are offline; run them with ProxyScale at full
+//! resolution. Inside a DeferredUpdates batch, queued updates are flushed
+//! after each tile, so deferred stages render every tile.
+class TileINode : public Node< Inlets<>, Outlets< gl::Texture2dRef, Tile > >
+{
+public:
+    class Format
+    {
+    public:
+        Format() {}
+
+        //! Sets the edge length of the region each tile contributes.
+        //! Defaults to 2048.
+        Format & tileSize( int size ) { mTileSize = size; return *this; }
+        int getTileSize() const { return mTileSize; }
+
+        //! Sets the number of extra pixels read around each tile for filters
+        //! that sample neighbours. Defaults to 0.
+        Format & halo( int halo ) { mHalo = halo; return *this; }
+        int getHalo() const { return mHalo; }
+
+        //! Sets the precision of the tile texture. Defaults to GL_RGBA16F.
+        Format & internalFormat( GLint internalFormat ) { mInternalFormat = internalFormat; return *this; }
+        GLint getInternalFormat() const { return mInternalFormat; }
+
+    private:
+        int     mTileSize = 2048;
+        int     mHalo = 0;
+        GLint   mInternalFormat = GL_RGBA16F;
+    };
+
+    static TileINodeRef create( const Surface32fRef & image, const Format & format = Format() )
+    {
+        return std::make_shared< TileINode >( image, format );
+    }
+
+    TileINode( const Surface32fRef & image, const Format & format = Format() );
+
+    void setImage( const Surface32fRef & image );
+    const Surface32fRef & getImage() const { return mImage; }
+
+    const Format & getFormat() const { return mFormat; }
+
+    //! Returns the tiles covering the image, in row order.
+    std::vector< Tile > getTiles() const;
+
+    //! Streams every tile through the graph.
+    virtual void update();
+
+    //! Streams a single tile through the graph.
+    void update( const Tile & tile );
+
+private:
+    Surface32fRef           mImage;
+    Format                  mFormat;
+    Surface32fRef           mTileSurface = nullptr;
+    gl::Texture2dRef        mTileTexture = nullptr;
+};
+
+//! Reads rendered tiles back and assembles them into a Surface32f, or hands
+//! each one to a callback, e.g. to write it straight to disk without holding
+//! the whole image in memory.
+class TileONode : public Node< Inlets< gl::Texture2dRef, Tile >, Outlets<> >
+{
+public:
+    typedef std::function< void( const Surface32f & tile, const ci::Area & bounds ) > TileFn;
+
+    static TileONodeRef create()
+    {
+        return std::make_shared< TileONode >();
+    }
+
+    TileONode();
+
+    //! Receives each finished tile, cropped to its bounds. While set, tiles
+    //! are not assembled.
+    void setTileFn( const TileFn & fn ) { mTileFn = fn; }
+
+    //! Returns the assembled image.
+    const Surface32fRef & getSurface() const { return mSurface; }
+
+    //! Returns true once the last tile has been received.
+    bool isComplete() const { return mComplete; }
+
+private:
+    void update( const gl::Texture2dRef & texture );
+
+    Tile            mTile;
+    TileFn          mTileFn;
+    Surface32fRef   mSurface = nullptr;
+    bool            mComplete = false;
+};
+
+}
+}
@@ -18,6 +18,8 @@ typedef ref< class ImageIONode >		ImageIONodeRef;
 typedef ref< class SurfaceINode >		SurfaceINodeRef;
 typedef ref< class TextureINode >		TextureINodeRef;
 typedef ref< class TextureONode >		TextureONodeRef;
+typedef ref< class Lut3d >				Lut3dRef;
+typedef ref< class Lut1d >				Lut1dRef;
 template< std::size_t I >
 class TextureShaderIONode;
 template< std::size_t I >
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "cinder/gl/GlslProg.h"
+#include "cinder/gl/Ubo.h"
+#include <cstring>
+
+namespace cinder {
+namespace frame_graph {
+
+//! A uniform value of one of the types render stages use, stored inline so
+//! setting it every frame doesn't allocate.
+class UniformValue
+{
+public:
+    enum class Type {
+        NONE, INT, FLOAT, VEC2, VEC3, VEC4, IVEC2, MAT3, MAT4
+    };
+
+    UniformValue() {}
+    UniformValue( bool v ) : UniformValue( (int)v ) {}
+    UniformValue( int v ) : mType( Type::INT ) { mInt[ 0 ] = v; }
+    UniformValue( float v ) : mType( Type::FLOAT ) { mFloat[ 0 ] = v; }
+    UniformValue( const ci::vec2 & v ) : mType( Type::VEC2 ) { copy( &v, sizeof( v ) ); }
+    UniformValue( const ci::vec3 & v ) : mType( Type::VEC3 ) { copy( &v, sizeof( v ) ); }
+    UniformValue( const ci::vec4 & v ) : mType( Type::VEC4 ) { copy( &v, sizeof( v ) ); }
+    UniformValue( const ci::ivec2 & v ) : mType( Type::IVEC2 ) { mInt[ 0 ] = v.x; mInt[ 1 ] = v.y; }
+    UniformValue( const ci::mat3 & v ) : mType( Type::MAT3 ) { copy( &v, sizeof( v ) ); }
+    UniformValue( const ci::mat4 & v ) : mType( Type::MAT4 ) { copy( &v, sizeof( v ) ); }
+
+    Type getType() const { return mType; }
+
+    //! Sets the value on \a shader, which must be the program \a location
+    //! was looked up in.
+    void apply( const ci::gl::GlslProgRef & shader, GLint location ) const
+    {
+        switch ( mType ) {
+            case Type::NONE: break;
+            case Type::INT: shader->uniform( location, mInt[ 0 ] ); break;
+            case Type::FLOAT: shader->uniform( location, mFloat[ 0 ] ); break;
+            case Type::VEC2: shader->uniform( location, as< ci::vec2 >() ); break;
+            case Type::VEC3: shader->uniform( location, as< ci::vec3 >() ); break;
+            case Type::VEC4: shader->uniform( location, as< ci::vec4 >() ); break;
+            case Type::IVEC2: shader->uniform( location, ci::ivec2( mInt[ 0 ], mInt[ 1 ] ) ); break;
+            case Type::MAT3: shader->uniform( location, as< ci::mat3 >() ); break;
+            case Type::MAT4: shader->uniform( location, as< ci::mat4 >() ); break;
+        }
+    }
+
+private:
+    void copy( const void * v, size_t size ) { std::memcpy( mFloat, v, size ); }
+
+    template< typename T >
+    T as() const
+    {
+        T v;
+        std::memcpy( &v, mFloat, sizeof( T ) );
+        return v;
+    }
+
+    Type        mType = Type::NONE;
+    union {
+        int     mInt[ 2 ];
+        float   mFloat[ 16 ];
+    };
+};
+
+//! A uniform block a render stage binds before drawing.
+class UniformBlockBase
+{
+public:
+    virtual ~UniformBlockBase() {}
+
+    //! Uploads the parameters if they changed and binds them to \a binding.
+    virtual void bind( GLuint binding ) = 0;
+};
+
+//! Parameters uploaded as a uniform buffer only when they change. \a T must
+//! match the std140 layout of the block in the shader, e.g. by padding each
+//! vec3 with a float.
+template< typename T >
+class UniformBlock : public UniformBlockBase
+{
+public:
+    const T & get() const { return mData; }
+
+    //! Returns the parameters for changing and marks them for upload.
+    T & edit()
+    {
+        mDirty = true;
+        return mData;
+    }
+
+    void bind( GLuint binding ) override
+    {
+        if ( ! mUbo ) {
+            mUbo = ci::gl::Ubo::create( sizeof( T ), &mData, GL_DYNAMIC_DRAW );
+            mDirty = false;
+        }
+        else if ( mDirty ) {
+            mUbo->bufferSubData( 0, sizeof( T ), &mData );
+            mDirty = false;
+        }
+        mUbo->bindBufferBase( binding );
+    }
+
+private:
+    T               mData = T();
+    bool            mDirty = true;
+    ci::gl::UboRef  mUbo;
+};
+
+}
+}
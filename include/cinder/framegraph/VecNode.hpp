@@ -3,6 +3,7 @@
 #include "cinder/CinderGlm.h"
 #include "libnodes/Node.h"
 #include "libnodes/ValueNode.h"
+#include "cinder/framegraph/DeferredUpdates.hpp"
 
 namespace cinder {
 namespace frame_graph {
@@ -23,6 +24,18 @@ public:
 //        listen();
     }
 
+    ~Vec2Node()
+    {
+        DeferredUpdates::instance().cancel( this );
+    }
+
+    //! Emits the vector now, or once at the end of the current batch of
+    //! updates however many components change.
+    void requestUpdate()
+    {
+        DeferredUpdates::instance().defer( this, [this] { this->update(); } );
+    }
+
     V & x() { return this->get().x; }
     const V & x() const { return this->get().x; }
     V & y() { return this->get().y; }
@@ -35,17 +48,15 @@ protected:
         nodes::ValueNode< T, V, V >::listen();
 
         this->template in< 1 >().onReceive( [&] ( const V & v ) {
-            T cp = (*this)();
-            cp.x = v;
-            this->set( cp );
+            this->get().x = v;
             this->template out< 1 >().update( v );
+            requestUpdate();
         });
 
         this->template in< 2 >().onReceive( [&] ( const V & v ) {
-            T cp = (*this)();
-            cp.y = v;
-            this->set( cp );
+            this->get().y = v;
             this->template out< 2 >().update( v );
+            requestUpdate();
         });
     }
 };
@@ -66,6 +77,18 @@ public:
 //        listen();
     }
 
+    ~Vec3Node()
+    {
+        DeferredUpdates::instance().cancel( this );
+    }
+
+    //! Emits the vector now, or once at the end of the current batch of
+    //! updates however many components change.
+    void requestUpdate()
+    {
+        DeferredUpdates::instance().defer( this, [this] { this->update(); } );
+    }
+
     V & x() { return this->get().x; }
     const V & x() const { return this->get().x; }
     V & y() { return this->get().y; }
@@ -79,24 +102,21 @@ protected:
         nodes::ValueNode< T, V, V, V >::listen();
 
         this->template in< 1 >().onReceive( [&] ( const V & v ) {
-            T cp = (*this)();
-            cp.x = v;
-            this->set( cp );
+            this->get().x = v;
             this->template out< 1 >().update( v );
+            requestUpdate();
         });
 
         this->template in< 2 >().onReceive( [&] ( const V & v ) {
-            T cp = (*this)();
-            cp.y = v;
-            this->set( cp );
+            this->get().y = v;
             this->template out< 2 >().update( v );
+            requestUpdate();
         });
 
         this->template in< 3 >().onReceive( [&] ( const V & v ) {
-            T cp = (*this)();
-            cp.z = v;
-            this->set( cp );
+            this->get().z = v;
             this->template out< 3 >().update( v );
+            requestUpdate();
         });
     }
 };
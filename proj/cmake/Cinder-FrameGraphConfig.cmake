@@ -5,6 +5,7 @@ if( NOT TARGET Cinder-FrameGraph )
 
     option(ENABLE_FRAMEGRAPH_QUICKTIME "enable nodes for working with Quicktime videos" OFF)
     option(ENABLE_FRAMEGRAPH_LIBGLVIDEO "enable nodes for working with libglvideo" OFF)
+    option(ENABLE_FRAMEGRAPH_HEADLESS "enable offscreen EGL contexts, for Cinder built with CINDER_HEADLESS_GL=egl" OFF)
 
     get_filename_component( FrameGraph_SOURCE_PATH "${CMAKE_CURRENT_LIST_DIR}/../../src" ABSOLUTE )
     get_filename_component( FrameGraph_INCLUDE_PATH "${CMAKE_CURRENT_LIST_DIR}/../../include" ABSOLUTE )
@@ -17,10 +18,60 @@ if( NOT TARGET Cinder-FrameGraph )
             ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/Types.hpp
             ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/ColorGradeNode.hpp
             ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/LUTNode.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/Lut.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/LUTFile.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/ThreadPool.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/SurfaceLUTNode.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/RenderFormat.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/RenderStage.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/ProxyScale.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/Tiling.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/Filters.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/Scopes.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/ShaderCompiler.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/ProgramRegistry.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/ProgramBinaryCache.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/Uniforms.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/Graph.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/Regression.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/SurfaceKernel.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/DeferredUpdates.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/Curve.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/PresentationClock.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/FrameHistory.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/FrameCache.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/DiskFrameCache.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/TextureStream.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/AsyncTexture.hpp
+            ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/SurfacePool.hpp
             ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/FullScreenQuadRenderer.hpp
             ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/VecNode.hpp
             ${FrameGraph_SOURCE_PATH}/cinder/FrameGraph.cpp
             ${FrameGraph_SOURCE_PATH}/cinder/framegraph/LUTNode.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/Lut.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/LUTFile.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/ThreadPool.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/SurfaceLUTNode.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/RenderFormat.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/RenderStage.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/ProxyScale.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/Tiling.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/Filters.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/Scopes.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/ShaderCompiler.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/ProgramRegistry.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/ProgramBinaryCache.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/Graph.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/Regression.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/DeferredUpdates.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/Curve.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/PresentationClock.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/FrameHistory.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/FrameCache.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/DiskFrameCache.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/TextureStream.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/AsyncTexture.cpp
+            ${FrameGraph_SOURCE_PATH}/cinder/framegraph/SurfacePool.cpp
             ${FrameGraph_SOURCE_PATH}/cinder/framegraph/ColorGradeNode.cpp
             ${FrameGraph_LIB_PATH}/libnodes/src/libnodes/Node.cpp
             )
@@ -38,6 +89,14 @@ if( NOT TARGET Cinder-FrameGraph )
         ${FrameGraph_SOURCE_PATH}/cinder/framegraph/QuickTime.cpp
         )
     endif()
+    if( ENABLE_FRAMEGRAPH_HEADLESS )
+      list( APPEND FrameGraph_SOURCES
+        ${FrameGraph_INCLUDE_PATH}/cinder/framegraph/Headless.hpp
+        ${FrameGraph_SOURCE_PATH}/cinder/framegraph/Headless.cpp
+        )
+
+      list( APPEND FrameGraph_LIBS EGL )
+    endif()
     if( ENABLE_FRAMEGRAPH_LIBGLVIDEO )
       find_package(libglvideo REQUIRED PATHS "${LIBGLVIDEO_PATH}/cmake" NO_DEFAULT_PATH)
 
@@ -59,7 +59,20 @@ TextureONode::TextureONode()
 
 void TextureONode::update( const Surface32fRef & image )
 {
-    update( gl::Texture2d::create( *image ) );
+    auto texture = mStream.upload( *image );
+    // orders GL can't read directly take the allocating path
+    update( texture ? texture : gl::Texture2d::create( *image ) );
+}
+
+void TextureONode::update( const Surface8uRef & image )
+{
+    auto texture = mStream.upload( *image );
+    update( texture ? texture : gl::Texture2d::create( *image ) );
+}
+
+void TextureONode::update( const void * data, const ivec2 & size, GLenum format, GLenum type, ptrdiff_t rowBytes )
+{
+    update( mStream.upload( data, size, format, type, rowBytes ) );
 }
 
 void TextureONode::update( const gl::Texture2dRef & texture )
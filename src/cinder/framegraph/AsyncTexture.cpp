@@ -0,0 +1,112 @@
+#include "cinder/framegraph/AsyncTexture.hpp"
+#include "cinder/framegraph/ShaderCompiler.hpp"
+#include "cinder/framegraph/TextureStream.hpp"
+#include "cinder/framegraph/ThreadPool.hpp"
+#include "cinder/ImageIo.h"
+#include "cinder/Log.h"
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+AsyncTextureINode::AsyncTextureINode( const DataSourceRef & source, const gl::Texture2dRef & placeholder ) :
+        mJob( make_shared< Job >() ),
+        mPlaceholder( placeholder )
+{
+    shared_ptr< Job > job = mJob;
+    ThreadPool::instance().submit( [job, source] {
+        if ( job->cancelled ) return;
+
+        try {
+            ImageSourceRef image = loadImage( source );
+            if ( job->cancelled ) return;
+
+            // 8-bit images stay 8-bit, everything else is decoded to float
+            if ( image->getDataType() == ImageIo::UINT8 ) job->surface8u = Surface8u::create( image );
+            else                                          job->surface32f = Surface32f::create( image );
+        }
+        catch ( const std::exception & e ) {
+            job->error = e.what();
+        }
+        job->done = true;
+    } );
+}
+
+AsyncTextureINode::~AsyncTextureINode()
+{
+    if ( mJob ) mJob->cancelled = true;
+}
+
+void AsyncTextureINode::update()
+{
+    if ( mJob && mJob->done ) {
+        if ( ! mJob->error.empty() ) {
+            finish();
+            return;
+        }
+
+        if ( ! mUploading ) {
+            mUploading = true;
+            shared_ptr< Job > job = mJob;
+            if ( ! ShaderCompiler::instance().submit( [job] { if ( ! job->cancelled ) upload( *job ); } ) ) upload( *job );
+        }
+
+        // the texture is only complete for this context once the fence the
+        // background context set after the upload has signaled
+        if ( mJob->uploaded ) {
+            GLenum status = mJob->fence->clientWaitSync();
+            if ( status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED ) {
+                finish();
+                return;
+            }
+        }
+    }
+
+    if ( mLoaded ) TextureINode::update();
+    else if ( mPlaceholder ) out< 0 >().update( mPlaceholder );
+}
+
+void AsyncTextureINode::upload( Job & job )
+{
+    // a stream of one buffer, released once the GPU has the pixels
+    {
+        TextureStream stream( 1 );
+        if ( job.surface8u ) {
+            job.texture = stream.upload( *job.surface8u );
+            if ( ! job.texture ) job.texture = gl::Texture2d::create( *job.surface8u );
+        }
+        else {
+            job.texture = stream.upload( *job.surface32f );
+            if ( ! job.texture ) job.texture = gl::Texture2d::create( *job.surface32f );
+        }
+    }
+    job.surface8u.reset();
+    job.surface32f.reset();
+
+    // flushed so the render context can wait on it
+    job.fence = gl::Sync::create();
+    glFlush();
+    job.uploaded = true;
+}
+
+void AsyncTextureINode::finish()
+{
+    shared_ptr< Job > job = move( mJob );
+
+    if ( ! job->error.empty() ) {
+        mError = job->error;
+        CI_LOG_E( "Error loading image: " << mError );
+        if ( mPlaceholder ) out< 0 >().update( mPlaceholder );
+        return;
+    }
+
+    mLoaded = true;
+    TextureINode::update( job->texture );
+    mSignalLoaded.emit( job->texture );
+}
+
+ivec2 AsyncTextureINode::getSize() const
+{
+    if ( mLoaded ) return TextureINode::getSize();
+    return mPlaceholder ? mPlaceholder->getSize() : ivec2( 0 );
+}
@@ -4,16 +4,6 @@ using namespace ci;
 using namespace frame_graph;
 using namespace std;
 
-static const std::map< ColorGradeNode::inlet_names, std::string > INLET_NAME_STRINGS{
-        {ColorGradeNode::exposure,          "Exposure"},
-        {ColorGradeNode::LGG,               "LGG"},
-        {ColorGradeNode::temperature,       "Temperature"},
-        {ColorGradeNode::contrast,          "Contrast"},
-        {ColorGradeNode::midtone_contrast,  "MidtoneContrast"},
-        {ColorGradeNode::HSV,               "HSV"}
-};
-
-
 static const string VERT = R"EOF(
 uniform mat4	ciModelViewProjection;
 uniform mat4    uTexMtx;
@@ -34,19 +24,24 @@ static const string FRAG = R"EOF(
 
 uniform sampler2D uTex;
 
-uniform bool uEnableExposure;
-uniform bool uEnableLGG;
-uniform bool uEnableTemperature;
-uniform bool uEnableContrast;
-uniform bool uEnableMidtoneContrast;
-uniform bool uEnableHSV;
-
-uniform float   uExposure;
-uniform vec3    uLGG;
-uniform float   uTemperature;
-uniform float   uContrast;
-uniform float   uMidtoneContrast;
-uniform vec3    uHSV;
+// bits of uEnable, in inlet order
+const uint ENABLE_EXPOSURE          = 1u;
+const uint ENABLE_LGG               = 2u;
+const uint ENABLE_TEMPERATURE       = 4u;
+const uint ENABLE_CONTRAST          = 8u;
+const uint ENABLE_MIDTONE_CONTRAST  = 16u;
+const uint ENABLE_HSV               = 32u;
+
+// matches ColorGradeNode::Params
+layout( std140 ) uniform uParams {
+    vec3    uLGG;
+    float   uExposure;
+    vec3    uHSV;
+    float   uTemperature;
+    float   uContrast;
+    float   uMidtoneContrast;
+    uint    uEnable;
+};
 
 in vec2 uv;
 out vec4 oColor;
@@ -175,12 +170,12 @@ vec3 temperature( in vec3 c_in, in float K )
 void main() {
     vec4 c = texture( uTex, uv );
 
-    if ( uEnableExposure )          c.rgb = exposure( c.rgb, uExposure );
-    if ( uEnableLGG )               c.rgb = liftGammaGain( c.rgb, uLGG );
-    if ( uEnableTemperature )       c.rgb = temperature( c.rgb, uTemperature );
-    if ( uEnableContrast )          c.rgb = contrast( c.rgb, uContrast );
-    if ( uEnableMidtoneContrast )   c.rgb = midToneContrast( c.rgb, uMidtoneContrast );
-    if ( uEnableHSV )               c.rgb = hsv( c.rgb, uHSV );
+    if ( ( uEnable & ENABLE_EXPOSURE ) != 0u )          c.rgb = exposure( c.rgb, uExposure );
+    if ( ( uEnable & ENABLE_LGG ) != 0u )               c.rgb = liftGammaGain( c.rgb, uLGG );
+    if ( ( uEnable & ENABLE_TEMPERATURE ) != 0u )       c.rgb = temperature( c.rgb, uTemperature );
+    if ( ( uEnable & ENABLE_CONTRAST ) != 0u )          c.rgb = contrast( c.rgb, uContrast );
+    if ( ( uEnable & ENABLE_MIDTONE_CONTRAST ) != 0u )  c.rgb = midToneContrast( c.rgb, uMidtoneContrast );
+    if ( ( uEnable & ENABLE_HSV ) != 0u )               c.rgb = hsv( c.rgb, uHSV );
 
     oColor = c;
 }
@@ -188,25 +183,61 @@ void main() {
 
 
 ColorGradeNode::ColorGradeNode( const ci::ivec2 & size ) :
-        FullScreenQuadRenderer< 1 >( gl::GlslProg::create( gl::GlslProg::Format()
-                                                                   .fragment( FRAG )
-                                                                   .vertex( VERT )
-        ), size )
+        FullScreenQuadRenderer< 1 >( gl::GlslProg::Format()
+                                             .fragment( FRAG )
+                                             .vertex( VERT ), size )
 {
     setTextureName( 0, "uTex" );
+    setUniformBlock( "uParams", &mParams );
+    // exposure and lift can bring back values outside [0, 1]
+    setInputPrecision( Precision::HDR_HALF );
 
     this->in< 0 >().onReceive( [&]( const gl::Texture2dRef & tex ) {
         setTexture( 0, tex );
-        this->out< 0 >().update( render() );
+        requestRender();
     } );
 
     inlets()[ from< first_inlet >{} ].each_with_index( [&]( auto & inlet, size_t i ) {
-        string n = INLET_NAME_STRINGS.at( (inlet_names)i );
-        setUniform( "uEnable" + n, false );
-
-        inlet.onReceive( [&, n]( const auto & v ) {
-            setUniform( "uEnable" + n, true );
-            setUniform( "u" + n, v );
+        inlet.onReceive( [&, i]( const auto & v ) {
+            setParameter( (inlet_names)i, v );
+            if ( getTexture( 0 ) ) requestRender();
         });
     } );
 }
+
+ColorGradeNode::~ColorGradeNode()
+{
+    DeferredUpdates::instance().cancel( this );
+}
+
+void ColorGradeNode::requestRender()
+{
+    // in a batch, a new frame and any number of parameters render once
+    DeferredUpdates::instance().defer( this, [this] {
+        this->out< 0 >().update( render() );
+    } );
+}
+
+void ColorGradeNode::setParameter( inlet_names name, float v )
+{
+    Params & params = mParams.edit();
+    switch ( name ) {
+        case exposure:          params.exposure = v; break;
+        case temperature:       params.temperature = v; break;
+        case contrast:          params.contrast = v; break;
+        case midtone_contrast:  params.midtoneContrast = v; break;
+        default:                return;
+    }
+    params.enabled |= 1u << ( name - first_inlet );
+}
+
+void ColorGradeNode::setParameter( inlet_names name, const vec3 & v )
+{
+    Params & params = mParams.edit();
+    switch ( name ) {
+        case LGG:   params.lgg = v; break;
+        case HSV:   params.hsv = v; break;
+        default:    return;
+    }
+    params.enabled |= 1u << ( name - first_inlet );
+}
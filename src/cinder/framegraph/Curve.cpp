@@ -0,0 +1,265 @@
+#include "cinder/framegraph/Curve.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+#include <immintrin.h>
+#if defined( __GNUC__ ) || defined( __clang__ )
+#define FG_CURVE_AVX2 1
+#define FG_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#elif defined( __AVX2__ )
+#define FG_CURVE_AVX2 1
+#define FG_TARGET_AVX2
+#endif
+#endif
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+// Curve
+
+void Curve::setKeys( vector< Keyframe > keys )
+{
+    stable_sort( keys.begin(), keys.end(), []( const Keyframe & a, const Keyframe & b ) { return a.time < b.time; } );
+    mKeys = move( keys );
+    mCached = 0;
+
+    // holds before the first key and after the last, and a cubic between
+    // each pair
+    mSegments.assign( mKeys.size() + 1, Segment() );
+    if ( mKeys.empty() ) return;
+
+    mSegments.front().d = mKeys.front().value;
+    mSegments.back().d = mKeys.back().value;
+
+    for ( size_t i = 1; i < mKeys.size(); ++i ) {
+        const Keyframe & k0 = mKeys[ i - 1 ];
+        const Keyframe & k1 = mKeys[ i ];
+        Segment & s = mSegments[ i ];
+
+        double duration = k1.time - k0.time;
+        s.t0 = k0.time;
+        s.invDuration = duration > 0.0 ? (float)( 1.0 / duration ) : 0.f;
+        s.d = k0.value;
+
+        switch ( k0.interpolation ) {
+            case CurveInterpolation::STEP:
+                break;
+            case CurveInterpolation::LINEAR:
+                s.c = k1.value - k0.value;
+                break;
+            case CurveInterpolation::BEZIER: {
+                float p0 = k0.value;
+                float p1 = k0.value + k0.outHandle;
+                float p2 = k1.value + k1.inHandle;
+                float p3 = k1.value;
+                s.a = -p0 + 3.f * p1 - 3.f * p2 + p3;
+                s.b = 3.f * p0 - 6.f * p1 + 3.f * p2;
+                s.c = -3.f * p0 + 3.f * p1;
+                break;
+            }
+        }
+    }
+}
+
+bool Curve::contains( size_t segment, double time ) const
+{
+    return ( segment == 0 || mKeys[ segment - 1 ].time <= time )
+        && ( segment == mKeys.size() || time < mKeys[ segment ].time );
+}
+
+size_t Curve::findSegment( double time ) const
+{
+    // playback mostly stays in a segment or moves on to the next one
+    if ( contains( mCached, time ) ) return mCached;
+    if ( mCached < mKeys.size() && contains( mCached + 1, time ) ) return ++mCached;
+
+    auto it = upper_bound( mKeys.begin(), mKeys.end(), time, []( double t, const Keyframe & k ) { return t < k.time; } );
+    mCached = it - mKeys.begin();
+    return mCached;
+}
+
+float Curve::evaluate( const Segment & s, double time )
+{
+    // the difference is small, only then is it narrowed
+    float u = std::min( std::max( (float)( time - s.t0 ) * s.invDuration, 0.f ), 1.f );
+    return ( ( s.a * u + s.b ) * u + s.c ) * u + s.d;
+}
+
+float Curve::evaluate( double time ) const
+{
+    return evaluate( mSegments[ findSegment( time ) ], time );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CurveNode
+
+CurveNode::CurveNode( const Curve & curve ) :
+        mCurve( curve )
+{
+    in< 0 >().onReceive( [&]( const double & time ) {
+        setTime( time );
+    } );
+}
+
+void CurveNode::setCurve( const Curve & curve )
+{
+    mCurve = curve;
+    mEmitted = false;
+}
+
+void CurveNode::setTime( double time )
+{
+    float value = mCurve.evaluate( time );
+    if ( mEmitted && value == mValue ) return;
+
+    mValue = value;
+    mEmitted = true;
+    out< 0 >().update( mValue );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CurveBank
+
+namespace {
+
+//! How far evaluations may move from the origin before segment start times
+//! are rebased; float resolution at this distance is about a microsecond.
+const double REBASE_INTERVAL = 8.0;
+
+inline float evaluateRelative( float t, float t0, float invDuration, float a, float b, float c, float d )
+{
+    float u = std::min( std::max( ( t - t0 ) * invDuration, 0.f ), 1.f );
+    return ( ( a * u + b ) * u + c ) * u + d;
+}
+
+#if defined( FG_CURVE_AVX2 )
+
+bool hasAvx2()
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return __builtin_cpu_supports( "avx2" );
+#else
+    return true;
+#endif
+}
+
+//! Evaluates curves [0, n) with n a multiple of 8, writing the results and
+//! collecting the blocks of eight with a changed value.
+FG_TARGET_AVX2 void evaluateAvx2( size_t n, float time, const float * t0, const float * invDuration,
+                                  const float * a, const float * b, const float * c, const float * d,
+                                  const float * values, float * results, vector< uint32_t > & changedBlocks )
+{
+    const __m256 t = _mm256_set1_ps( time );
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps( 1.f );
+
+    for ( size_t i = 0; i < n; i += 8 ) {
+        __m256 u = _mm256_mul_ps( _mm256_sub_ps( t, _mm256_loadu_ps( t0 + i ) ), _mm256_loadu_ps( invDuration + i ) );
+        u = _mm256_min_ps( _mm256_max_ps( u, zero ), one );
+
+        __m256 v = _mm256_add_ps( _mm256_mul_ps( _mm256_loadu_ps( a + i ), u ), _mm256_loadu_ps( b + i ) );
+        v = _mm256_add_ps( _mm256_mul_ps( v, u ), _mm256_loadu_ps( c + i ) );
+        v = _mm256_add_ps( _mm256_mul_ps( v, u ), _mm256_loadu_ps( d + i ) );
+        _mm256_storeu_ps( results + i, v );
+
+        // unordered, so the NaNs of the first evaluation count as changed
+        __m256 neq = _mm256_cmp_ps( v, _mm256_loadu_ps( values + i ), _CMP_NEQ_UQ );
+        if ( _mm256_movemask_ps( neq ) ) changedBlocks.push_back( (uint32_t)( i / 8 ) );
+    }
+}
+
+#endif
+
+}
+
+size_t CurveBank::add( const Curve & curve )
+{
+    size_t i = mCurves.size();
+    mCurves.push_back( curve );
+    mSegments.push_back( 0 );
+    mStart.push_back( 0.0 );
+    for ( auto * v : { &mT0, &mInvDuration, &mA, &mB, &mC, &mD } ) v->push_back( 0.f );
+    mValues.push_back( numeric_limits< float >::quiet_NaN() );
+    mResults.push_back( 0.f );
+    setSegment( i, 0 );
+    return i;
+}
+
+void CurveBank::setCurve( size_t i, const Curve & curve )
+{
+    mCurves[ i ] = curve;
+    mValues[ i ] = numeric_limits< float >::quiet_NaN();
+    setSegment( i, 0 );
+}
+
+void CurveBank::setSegment( size_t i, size_t segment )
+{
+    const Curve::Segment & s = mCurves[ i ].getSegment( segment );
+    mSegments[ i ] = segment;
+    mStart[ i ] = s.t0;
+    mT0[ i ] = (float)( s.t0 - mOrigin );
+    mInvDuration[ i ] = s.invDuration;
+    mA[ i ] = s.a;
+    mB[ i ] = s.b;
+    mC[ i ] = s.c;
+    mD[ i ] = s.d;
+}
+
+void CurveBank::rebase( double origin )
+{
+    mOrigin = origin;
+    for ( size_t i = 0; i < mStart.size(); ++i ) mT0[ i ] = (float)( mStart[ i ] - mOrigin );
+}
+
+bool CurveBank::isSimdActive() const
+{
+#if defined( FG_CURVE_AVX2 )
+    return mSimd && hasAvx2();
+#else
+    return false;
+#endif
+}
+
+void CurveBank::evaluate( double time, const function< void( size_t, float ) > & changed )
+{
+    // times are narrowed relative to an origin near the playhead, keeping
+    // them precise however far into a show it is
+    if ( std::abs( time - mOrigin ) > REBASE_INTERVAL ) rebase( time );
+
+    // segments only change at keys, so the coefficients are rarely touched
+    for ( size_t i = 0; i < mCurves.size(); ++i ) {
+        size_t segment = mCurves[ i ].findSegment( time );
+        if ( segment != mSegments[ i ] ) setSegment( i, segment );
+    }
+
+    auto report = [&]( size_t i ) {
+        if ( mResults[ i ] == mValues[ i ] ) return;
+        mValues[ i ] = mResults[ i ];
+        changed( i, mValues[ i ] );
+    };
+
+    size_t n = mCurves.size();
+    size_t simdEnd = 0;
+    float t = (float)( time - mOrigin );
+
+#if defined( FG_CURVE_AVX2 )
+    if ( isSimdActive() ) {
+        simdEnd = n - n % 8;
+        mChangedBlocks.clear();
+        evaluateAvx2( simdEnd, t, mT0.data(), mInvDuration.data(), mA.data(), mB.data(), mC.data(), mD.data(),
+                      mValues.data(), mResults.data(), mChangedBlocks );
+        for ( uint32_t block : mChangedBlocks ) {
+            for ( size_t i = block * 8; i < block * 8 + 8; ++i ) report( i );
+        }
+    }
+#endif
+
+    for ( size_t i = simdEnd; i < n; ++i ) {
+        mResults[ i ] = evaluateRelative( t, mT0[ i ], mInvDuration[ i ], mA[ i ], mB[ i ], mC[ i ], mD[ i ] );
+        report( i );
+    }
+}
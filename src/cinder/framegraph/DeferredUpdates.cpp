@@ -0,0 +1,62 @@
+#include "cinder/framegraph/DeferredUpdates.hpp"
+
+using namespace cinder;
+using namespace frame_graph;
+using namespace std;
+
+DeferredUpdates & DeferredUpdates::instance()
+{
+    static DeferredUpdates updates;
+    return updates;
+}
+
+void DeferredUpdates::setPerFrame( bool enabled )
+{
+    mPerFrame = enabled;
+    if ( ! isDeferring() ) flush();
+}
+
+void DeferredUpdates::defer( const void * node, function< void() > update )
+{
+    if ( ! isDeferring() ) {
+        update();
+        return;
+    }
+
+    if ( ! mQueued.insert( node ).second ) return;
+    mQueue.push_back( { node, move( update ) } );
+}
+
+void DeferredUpdates::cancel( const void * node )
+{
+    if ( ! mQueued.erase( node ) ) return;
+
+    // only mark the entry, flush() may be walking the queue
+    for ( auto & u : mQueue ) {
+        if ( u.node == node && u.fn ) {
+            u.fn = nullptr;
+            break;
+        }
+    }
+}
+
+void DeferredUpdates::flush()
+{
+    // updates emit to downstream nodes, which queue their own at the end.
+    // Each entry is moved out before it runs, so cancel() can still reach
+    // the entries after it, and a nested flush() skips the ones already run.
+    for ( size_t i = 0; i < mQueue.size(); ++i ) {
+        Update u = move( mQueue[ i ] );
+        mQueue[ i ].fn = nullptr;
+        if ( ! u.fn ) continue;
+
+        mQueued.erase( u.node );
+        u.fn();
+    }
+    mQueue.clear();
+}
+
+void DeferredUpdates::end()
+{
+    if ( mDepth > 0 && --mDepth == 0 && ! mPerFrame ) flush();
+}
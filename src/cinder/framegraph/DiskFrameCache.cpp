@@ -0,0 +1,294 @@
+#include "cinder/framegraph/DiskFrameCache.hpp"
+#include <cstring>
+#include <fstream>
+
+#if defined( _WIN32 )
+#if ! defined( NOMINMAX )
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+
+const char INDEX_MAGIC[ 4 ] = { 'F', 'G', 'D', 'C' };
+const uint32_t INDEX_VERSION = 1;
+
+template< typename T >
+void put( ostream & out, const T & value )
+{
+    out.write( reinterpret_cast< const char * >( &value ), sizeof( T ) );
+}
+
+template< typename T >
+bool get( istream & in, T & value )
+{
+    return (bool)in.read( reinterpret_cast< char * >( &value ), sizeof( T ) );
+}
+
+}
+
+DiskFrameCache::DiskFrameCache( const fs::path & path, const Format & format ) :
+        mPath( path ),
+        mCapacity( format.getCapacity() )
+{
+    map();
+    loadIndex();
+    mThread = thread( &DiskFrameCache::writeThread, this );
+}
+
+DiskFrameCache::~DiskFrameCache()
+{
+    {
+        lock_guard< mutex > lock( mMutex );
+        mRun = false;
+    }
+    mCV.notify_all();
+    if ( mThread.joinable() ) mThread.join();
+
+    // the data has to be on disk before an index that refers to it
+#if defined( _WIN32 )
+    FlushViewOfFile( mData, 0 );
+#else
+    msync( mData, mCapacity, MS_SYNC );
+#endif
+    saveIndex();
+    unmap();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Mapping
+
+void DiskFrameCache::map()
+{
+#if defined( _WIN32 )
+    mFile = CreateFileW( mPath.wstring().c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+    if ( mFile == INVALID_HANDLE_VALUE ) {
+        mFile = nullptr;
+        throw DiskFrameCacheExc( "Couldn't open " + mPath.string() );
+    }
+
+    // mapping past the end of the file extends it
+    mMapping = CreateFileMappingW( mFile, nullptr, PAGE_READWRITE, (DWORD)( mCapacity >> 32 ), (DWORD)( mCapacity & 0xffffffff ), nullptr );
+    if ( mMapping ) mData = (uint8_t *)MapViewOfFile( mMapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)mCapacity );
+#else
+    mFile = open( mPath.string().c_str(), O_RDWR | O_CREAT, 0644 );
+    if ( mFile < 0 ) throw DiskFrameCacheExc( "Couldn't open " + mPath.string() );
+
+    if ( ftruncate( mFile, (off_t)mCapacity ) == 0 ) {
+        void * data = mmap( nullptr, (size_t)mCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, mFile, 0 );
+        if ( data != MAP_FAILED ) mData = (uint8_t *)data;
+    }
+#endif
+
+    if ( ! mData ) {
+        unmap();
+        throw DiskFrameCacheExc( "Couldn't map " + std::to_string( mCapacity ) + " bytes of " + mPath.string() );
+    }
+}
+
+void DiskFrameCache::unmap()
+{
+#if defined( _WIN32 )
+    if ( mData ) UnmapViewOfFile( mData );
+    if ( mMapping ) CloseHandle( mMapping );
+    if ( mFile ) CloseHandle( mFile );
+    mMapping = nullptr;
+    mFile = nullptr;
+#else
+    if ( mData ) munmap( mData, (size_t)mCapacity );
+    if ( mFile >= 0 ) close( mFile );
+    mFile = -1;
+#endif
+    mData = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Index
+
+fs::path DiskFrameCache::getIndexPath() const
+{
+    fs::path path = mPath;
+    path += ".index";
+    return path;
+}
+
+void DiskFrameCache::loadIndex()
+{
+    fs::path path = getIndexPath();
+    {
+        ifstream in( path.string(), ios::binary );
+        if ( ! in ) return;
+
+        char magic[ 4 ];
+        uint32_t version;
+        uint64_t capacity, head, count;
+        if ( ! in.read( magic, 4 ) || memcmp( magic, INDEX_MAGIC, 4 ) != 0 ) return;
+        if ( ! get( in, version ) || version != INDEX_VERSION ) return;
+        if ( ! get( in, capacity ) || capacity != mCapacity ) return;
+        if ( ! get( in, head ) || ! get( in, count ) || head > mCapacity ) return;
+
+        for ( uint64_t i = 0; i < count; ++i ) {
+            Entry e;
+            uint8_t topDown;
+            bool ok = get( in, e.key.time ) && get( in, e.key.state )
+                && get( in, e.size.x ) && get( in, e.size.y ) && get( in, e.fullSize.x ) && get( in, e.fullSize.y )
+                && get( in, topDown ) && get( in, e.storage ) && get( in, e.offset ) && get( in, e.bytes );
+            if ( ! ok ) break;
+            if ( e.bytes > mCapacity || e.offset > mCapacity - e.bytes ) continue;
+
+            e.topDown = topDown != 0;
+            mEntries[ e.key ] = e;
+            mOffsets[ e.offset ] = e.key;
+        }
+        mHead = head;
+    }
+
+    // written again on a clean shutdown
+    fs::remove( path );
+}
+
+void DiskFrameCache::saveIndex() const
+{
+    ofstream out( getIndexPath().string(), ios::binary );
+    if ( ! out ) return;
+
+    out.write( INDEX_MAGIC, 4 );
+    put( out, INDEX_VERSION );
+    put( out, mCapacity );
+    put( out, mHead );
+    put( out, (uint64_t)mEntries.size() );
+    for ( const auto & kv : mEntries ) {
+        const Entry & e = kv.second;
+        put( out, e.key.time );
+        put( out, e.key.state );
+        put( out, e.size.x );
+        put( out, e.size.y );
+        put( out, e.fullSize.x );
+        put( out, e.fullSize.y );
+        put( out, (uint8_t)e.topDown );
+        put( out, e.storage );
+        put( out, e.offset );
+        put( out, e.bytes );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Frames
+
+void DiskFrameCache::write( const Entry & entry, vector< uint8_t > data )
+{
+    if ( data.size() > mCapacity ) return;
+
+    {
+        lock_guard< mutex > lock( mMutex );
+        if ( mEntries.count( entry.key ) ) return;
+        for ( const auto & p : mPending ) {
+            if ( p.entry.key == entry.key ) return;
+        }
+
+        Pending p;
+        p.entry = entry;
+        p.entry.bytes = data.size();
+        p.data = move( data );
+        mPending.push_back( move( p ) );
+    }
+    mCV.notify_one();
+}
+
+uint64_t DiskFrameCache::reserve( uint64_t bytes )
+{
+    if ( mHead + bytes > mCapacity ) mHead = 0;
+    uint64_t begin = mHead;
+    uint64_t end = begin + bytes;
+
+    // the log is written in order, so nothing starting before begin reaches it
+    for ( auto it = mOffsets.lower_bound( begin ); it != mOffsets.end() && it->first < end; ) {
+        mEntries.erase( it->second );
+        it = mOffsets.erase( it );
+    }
+
+    mHead = end;
+    return begin;
+}
+
+void DiskFrameCache::writeThread()
+{
+    unique_lock< mutex > lock( mMutex );
+    while ( true ) {
+        mCV.wait( lock, [&] { return ! mRun || ! mPending.empty(); } );
+        if ( mPending.empty() ) return;
+
+        // the frame stays pending, and readable, until it is indexed
+        Pending & p = mPending.front();
+        uint64_t offset = reserve( p.entry.bytes );
+        lock.unlock();
+
+        memcpy( mData + offset, p.data.data(), p.data.size() );
+
+        lock.lock();
+        p.entry.offset = offset;
+        mEntries[ p.entry.key ] = p.entry;
+        mOffsets[ offset ] = p.entry.key;
+        mPending.pop_front();
+        if ( mPending.empty() ) mIdleCV.notify_all();
+    }
+}
+
+bool DiskFrameCache::read( const FrameCacheKey & key, const function< bool( const Entry &, const uint8_t * ) > & fn )
+{
+    lock_guard< mutex > lock( mMutex );
+
+    auto it = mEntries.find( key );
+    if ( it != mEntries.end() ) return fn( it->second, mData + it->second.offset );
+
+    for ( const auto & p : mPending ) {
+        if ( p.entry.key == key ) return fn( p.entry, p.data.data() );
+    }
+    return false;
+}
+
+bool DiskFrameCache::contains( const FrameCacheKey & key ) const
+{
+    lock_guard< mutex > lock( mMutex );
+    if ( mEntries.count( key ) ) return true;
+    for ( const auto & p : mPending ) {
+        if ( p.entry.key == key ) return true;
+    }
+    return false;
+}
+
+void DiskFrameCache::flush()
+{
+    unique_lock< mutex > lock( mMutex );
+    mIdleCV.wait( lock, [&] { return mPending.empty(); } );
+}
+
+void DiskFrameCache::clear()
+{
+    flush();
+    lock_guard< mutex > lock( mMutex );
+    mEntries.clear();
+    mOffsets.clear();
+    mHead = 0;
+}
+
+size_t DiskFrameCache::getFrameCount() const
+{
+    lock_guard< mutex > lock( mMutex );
+    return mEntries.size();
+}
+
+size_t DiskFrameCache::getPendingCount() const
+{
+    lock_guard< mutex > lock( mMutex );
+    return mPending.size();
+}
@@ -0,0 +1,569 @@
+#include "cinder/framegraph/Filters.hpp"
+#include "cinder/framegraph/ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+
+const size_t ROW_GRAIN = 16;
+
+const string VERT = R"EOF(
+#version 150
+
+uniform mat4    ciModelViewProjection;
+uniform mat4    uTexture0Mtx;
+#if INPUTS > 1
+uniform mat4    uTexture1Mtx;
+#endif
+in vec4         ciPosition;
+in vec2         ciTexCoord0;
+out vec2        uv0;
+#if INPUTS > 1
+out vec2        uv1;
+#endif
+
+void main( void ) {
+    gl_Position = ciModelViewProjection * ciPosition;
+    vec4 texCoord = uTexture0Mtx * vec4( ciTexCoord0, 0., 1. );
+    uv0 = texCoord.st / texCoord.q;
+#if INPUTS > 1
+    texCoord = uTexture1Mtx * vec4( ciTexCoord0, 0., 1. );
+    uv1 = texCoord.st / texCoord.q;
+#endif
+}
+)EOF";
+
+//! OFFSETS, WEIGHTS and TAPS are generated from the kernel
+const string BLUR_FRAG = R"EOF(
+uniform sampler2D   uTexture0;
+uniform vec2        uFullTexelSize;
+
+in vec2 uv0;
+out vec4 oColor;
+
+void main( void ) {
+    vec2 step = DIRECTION * uFullTexelSize;
+    vec4 c = texture( uTexture0, uv0 ) * WEIGHTS[ 0 ];
+    for ( int i = 1; i < TAPS; ++i ) {
+        vec2 d = step * OFFSETS[ i ];
+        c += ( texture( uTexture0, uv0 + d ) + texture( uTexture0, uv0 - d ) ) * WEIGHTS[ i ];
+    }
+    oColor = c;
+}
+)EOF";
+
+const string DOWNSAMPLE_FRAG = R"EOF(
+#version 150
+
+uniform sampler2D   uTexture0;
+uniform float       uThreshold;
+
+in vec2 uv0;
+out vec4 oColor;
+
+void main( void ) {
+    // four bilinear fetches between texels average a 4x4 box
+    vec2 t = 1. / vec2( textureSize( uTexture0, 0 ) );
+    vec4 c = texture( uTexture0, uv0 + t * vec2( -1., -1. ) )
+           + texture( uTexture0, uv0 + t * vec2(  1., -1. ) )
+           + texture( uTexture0, uv0 + t * vec2( -1.,  1. ) )
+           + texture( uTexture0, uv0 + t * vec2(  1.,  1. ) );
+    c *= 0.25;
+#ifdef THRESHOLD
+    float brightness = max( c.r, max( c.g, c.b ) );
+    c.rgb *= max( brightness - uThreshold, 0. ) / max( brightness, 1e-5 );
+#endif
+    oColor = c;
+}
+)EOF";
+
+const string UPSAMPLE_FRAG = R"EOF(
+#version 150
+
+uniform sampler2D   uTexture0;
+uniform sampler2D   uTexture1;
+uniform float       uBaseWeight;
+uniform float       uIntensity;
+
+in vec2 uv0;
+in vec2 uv1;
+out vec4 oColor;
+
+// 3x3 tent over the low resolution input
+vec4 tent( in vec2 p )
+{
+    vec2 t = 1. / vec2( textureSize( uTexture1, 0 ) );
+    vec4 c = texture( uTexture1, p ) * 4.;
+    c += ( texture( uTexture1, p + vec2( t.x, 0. ) ) + texture( uTexture1, p - vec2( t.x, 0. ) )
+         + texture( uTexture1, p + vec2( 0., t.y ) ) + texture( uTexture1, p - vec2( 0., t.y ) ) ) * 2.;
+    c += texture( uTexture1, p + t ) + texture( uTexture1, p - t )
+       + texture( uTexture1, p + vec2( t.x, -t.y ) ) + texture( uTexture1, p + vec2( -t.x, t.y ) );
+    return c / 16.;
+}
+
+void main( void ) {
+    vec4 base = texture( uTexture0, uv0 );
+    vec4 c = base * uBaseWeight + tent( uv1 ) * uIntensity;
+#ifdef KEEP_BASE_ALPHA
+    c.a = base.a;
+#endif
+    oColor = c;
+}
+)EOF";
+
+string glslArray( const vector< float > & values )
+{
+    ostringstream os;
+    os << fixed << setprecision( 9 ) << "float[](";
+    for ( size_t i = 0; i < values.size(); ++i ) {
+        os << ( i ? ", " : " " ) << values[ i ];
+    }
+    os << " )";
+    return os.str();
+}
+
+SharedProgramRef blurShader( const vector< float > & offsets, const vector< float > & weights, bool horizontal )
+{
+    ostringstream os;
+    os << "#version 150\n\n"
+       << "const int TAPS = " << offsets.size() << ";\n"
+       << "const float OFFSETS[ TAPS ] = " << glslArray( offsets ) << ";\n"
+       << "const float WEIGHTS[ TAPS ] = " << glslArray( weights ) << ";\n"
+       << BLUR_FRAG;
+
+    return ProgramRegistry::instance().get( gl::GlslProg::Format()
+        .vertex( VERT )
+        .fragment( os.str() )
+        .define( "INPUTS", "1" )
+        .define( "DIRECTION", horizontal ? "vec2( 1., 0. )" : "vec2( 0., 1. )" ) );
+}
+
+SharedProgramRef downsampleShader( bool threshold )
+{
+    auto fmt = gl::GlslProg::Format()
+        .vertex( VERT )
+        .fragment( DOWNSAMPLE_FRAG )
+        .define( "INPUTS", "1" );
+    if ( threshold ) fmt.define( "THRESHOLD" );
+    return ProgramRegistry::instance().get( fmt );
+}
+
+SharedProgramRef upsampleShader( bool keepBaseAlpha )
+{
+    auto fmt = gl::GlslProg::Format()
+        .vertex( VERT )
+        .fragment( UPSAMPLE_FRAG )
+        .define( "INPUTS", "2" );
+    if ( keepBaseAlpha ) fmt.define( "KEEP_BASE_ALPHA" );
+    return ProgramRegistry::instance().get( fmt );
+}
+
+//! Reads through the surface's channel offsets, so any channel order works;
+//! a missing alpha reads as 1.
+inline vec4 readPixel( const Surface32f & s, int x, int y )
+{
+    const float * p = s.getData( ivec2( x, y ) );
+    return vec4( p[ s.getRedOffset() ], p[ s.getGreenOffset() ], p[ s.getBlueOffset() ], s.hasAlpha() ? p[ s.getAlphaOffset() ] : 1.f );
+}
+
+inline void writePixel( Surface32f & s, int x, int y, const vec4 & c )
+{
+    float * p = s.getData( ivec2( x, y ) );
+    p[ s.getRedOffset() ] = c.r;
+    p[ s.getGreenOffset() ] = c.g;
+    p[ s.getBlueOffset() ] = c.b;
+    if ( s.hasAlpha() ) p[ s.getAlphaOffset() ] = c.a;
+}
+
+//! Writes \a fn( uv ) to every pixel of \a dst on the ThreadPool.
+template< typename Fn >
+void forEachPixel( Surface32f & dst, Fn fn )
+{
+    vec2 size( dst.getSize() );
+    ThreadPool::instance().parallelFor( dst.getHeight(), ROW_GRAIN, [&]( size_t begin, size_t end ) {
+        for ( size_t y = begin; y < end; ++y ) {
+            for ( int x = 0; x < dst.getWidth(); ++x ) {
+                writePixel( dst, x, (int)y, fn( vec2( x + 0.5f, y + 0.5f ) / size ) );
+            }
+        }
+    } );
+}
+
+//! How a blur is split into passes
+struct BlurPlan {
+    int             levels = 0;
+    vector< float > offsets;
+    vector< float > weights;
+};
+
+BlurPlan planBlur( const BlurNode::Format & format )
+{
+    BlurPlan plan;
+    float radius = std::max( format.getRadius(), 0.f );
+    float maxRadius = std::max( format.getMaxPassRadius(), 1.f );
+    while ( radius > maxRadius ) {
+        radius *= 0.5f;
+        ++plan.levels;
+    }
+
+    auto kernel = format.getKernel() == BlurNode::Kernel::BOX ? boxKernel( radius ) : gaussianKernel( radius );
+    linearKernel( kernel, &plan.offsets, &plan.weights );
+    return plan;
+}
+
+SharedProgramRef finalBlurShader( const BlurNode::Format & format )
+{
+    auto plan = planBlur( format );
+    if ( plan.levels > 0 ) return upsampleShader( false );
+    return blurShader( plan.offsets, plan.weights, false );
+}
+
+} // anonymous namespace
+
+////////////////////////////////////////////////////////////////////////////////
+// Kernels
+
+vector< float > frame_graph::gaussianKernel( float radius )
+{
+    int taps = std::max( 0, (int)std::ceil( radius ) );
+    float sigma = std::max( radius / 3.f, 1e-3f );
+
+    vector< float > kernel( taps + 1 );
+    float sum = 0.f;
+    for ( int i = 0; i <= taps; ++i ) {
+        kernel[ i ] = std::exp( -0.5f * i * i / ( sigma * sigma ) );
+        sum += i ? 2.f * kernel[ i ] : kernel[ i ];
+    }
+    for ( auto & w : kernel ) w /= sum;
+    return kernel;
+}
+
+vector< float > frame_graph::boxKernel( float radius )
+{
+    int taps = std::max( 0, (int)std::round( radius ) );
+    return vector< float >( taps + 1, 1.f / ( 2 * taps + 1 ) );
+}
+
+void frame_graph::linearKernel( const vector< float > & kernel, vector< float > * offsets, vector< float > * weights )
+{
+    offsets->assign( 1, 0.f );
+    weights->assign( 1, kernel.at( 0 ) );
+
+    for ( size_t i = 1; i < kernel.size(); i += 2 ) {
+        if ( i + 1 < kernel.size() ) {
+            float w = kernel[ i ] + kernel[ i + 1 ];
+            offsets->push_back( ( i * kernel[ i ] + ( i + 1 ) * kernel[ i + 1 ] ) / w );
+            weights->push_back( w );
+        }
+        else {
+            offsets->push_back( (float)i );
+            weights->push_back( kernel[ i ] );
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// CPU reference
+
+vec4 frame_graph::sampleBilinear( const Surface32f & surface, const vec2 & uv )
+{
+    vec2 p = uv * vec2( surface.getSize() ) - 0.5f;
+    vec2 f = p - glm::floor( p );
+    int maxX = surface.getWidth() - 1;
+    int maxY = surface.getHeight() - 1;
+    int x0 = std::min( std::max( (int)std::floor( p.x ), 0 ), maxX );
+    int y0 = std::min( std::max( (int)std::floor( p.y ), 0 ), maxY );
+    int x1 = std::min( std::max( (int)std::floor( p.x ) + 1, 0 ), maxX );
+    int y1 = std::min( std::max( (int)std::floor( p.y ) + 1, 0 ), maxY );
+
+    vec4 top = glm::mix( readPixel( surface, x0, y0 ), readPixel( surface, x1, y0 ), f.x );
+    vec4 bottom = glm::mix( readPixel( surface, x0, y1 ), readPixel( surface, x1, y1 ), f.x );
+    return glm::mix( top, bottom, f.y );
+}
+
+Surface32f frame_graph::convolveSurface( const Surface32f & surface, const vector< float > & offsets, const vector< float > & weights, const vec2 & step )
+{
+    Surface32f result( surface.getWidth(), surface.getHeight(), true );
+    forEachPixel( result, [&]( const vec2 & uv ) {
+        vec4 c = sampleBilinear( surface, uv ) * weights[ 0 ];
+        for ( size_t i = 1; i < offsets.size(); ++i ) {
+            vec2 d = step * offsets[ i ];
+            c += ( sampleBilinear( surface, uv + d ) + sampleBilinear( surface, uv - d ) ) * weights[ i ];
+        }
+        return c;
+    } );
+    return result;
+}
+
+Surface32f frame_graph::downsampleSurface( const Surface32f & surface )
+{
+    Surface32f result( std::max( 1, surface.getWidth() / 2 ), std::max( 1, surface.getHeight() / 2 ), true );
+    vec2 t = vec2( 1.f ) / vec2( surface.getSize() );
+    forEachPixel( result, [&]( const vec2 & uv ) {
+        vec4 c = sampleBilinear( surface, uv + t * vec2( -1.f, -1.f ) )
+               + sampleBilinear( surface, uv + t * vec2(  1.f, -1.f ) )
+               + sampleBilinear( surface, uv + t * vec2( -1.f,  1.f ) )
+               + sampleBilinear( surface, uv + t * vec2(  1.f,  1.f ) );
+        return c * 0.25f;
+    } );
+    return result;
+}
+
+void frame_graph::thresholdSurface( Surface32f & surface, float threshold )
+{
+    int inc = surface.getPixelInc();
+    int r = surface.getRedOffset(), g = surface.getGreenOffset(), b = surface.getBlueOffset();
+    ThreadPool::instance().parallelFor( surface.getHeight(), ROW_GRAIN, [&]( size_t begin, size_t end ) {
+        for ( size_t y = begin; y < end; ++y ) {
+            float * p = surface.getData( ivec2( 0, (int)y ) );
+            for ( int x = 0; x < surface.getWidth(); ++x, p += inc ) {
+                float brightness = std::max( p[ r ], std::max( p[ g ], p[ b ] ) );
+                float scale = std::max( brightness - threshold, 0.f ) / std::max( brightness, 1e-5f );
+                p[ r ] *= scale; p[ g ] *= scale; p[ b ] *= scale;
+            }
+        }
+    } );
+}
+
+Surface32f frame_graph::upsampleSurface( const Surface32f & base, const Surface32f & low, float baseWeight, float intensity, bool keepBaseAlpha )
+{
+    Surface32f result( base.getWidth(), base.getHeight(), true );
+    vec2 t = vec2( 1.f ) / vec2( low.getSize() );
+    forEachPixel( result, [&]( const vec2 & uv ) {
+        vec4 c = sampleBilinear( low, uv ) * 4.f;
+        c += ( sampleBilinear( low, uv + vec2( t.x, 0.f ) ) + sampleBilinear( low, uv - vec2( t.x, 0.f ) )
+             + sampleBilinear( low, uv + vec2( 0.f, t.y ) ) + sampleBilinear( low, uv - vec2( 0.f, t.y ) ) ) * 2.f;
+        c += sampleBilinear( low, uv + t ) + sampleBilinear( low, uv - t )
+           + sampleBilinear( low, uv + vec2( t.x, -t.y ) ) + sampleBilinear( low, uv + vec2( -t.x, t.y ) );
+
+        vec4 b = sampleBilinear( base, uv );
+        vec4 r = b * baseWeight + c * ( intensity / 16.f );
+        if ( keepBaseAlpha ) r.a = b.a;
+        return r;
+    } );
+    return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// BlurNode
+
+//! Without downsampling the vertical pass is the final one, otherwise the
+//! final pass upsamples the blurred copy.
+BlurNode::BlurNode( const Format & format ) :
+FullScreenQuadRenderer< 2 >( finalBlurShader( format ), ivec2( 0 ) ),
+mFormat( format )
+{
+    auto plan = planBlur( mFormat );
+    mOffsets = plan.offsets;
+    mWeights = plan.weights;
+
+    auto down = downsampleShader( false );
+    for ( int i = 0; i < plan.levels; ++i ) {
+        mDownsample.emplace_back( new FilterPass<>( down, 0.5f ) );
+    }
+
+    mBlurH.reset( new FilterPass<>( blurShader( mOffsets, mWeights, true ) ) );
+    if ( plan.levels > 0 ) {
+        mBlurV.reset( new FilterPass<>( blurShader( mOffsets, mWeights, false ) ) );
+        setUniform( "uBaseWeight", 0.f );
+        setUniform( "uIntensity", 1.f );
+    }
+
+    in< 0 >().onReceive( [&]( const gl::Texture2dRef & tex ) {
+        update( tex );
+    } );
+}
+
+void BlurNode::setOutputFormat( RenderFormat format )
+{
+    FullScreenQuadRenderer< 2 >::setOutputFormat( format );
+    for ( auto & pass : mDownsample ) pass->setOutputFormat( format );
+    mBlurH->setOutputFormat( format );
+    if ( mBlurV ) mBlurV->setOutputFormat( format );
+}
+
+void BlurNode::update( const gl::Texture2dRef & texture )
+{
+    ivec2 fullSize = ProxyScale::instance().getFullSize( texture );
+    setInputMargin( mFormat.getRadius() / std::max( fullSize.x, 1 ) );
+
+    auto tex = texture;
+    for ( auto & pass : mDownsample ) tex = pass->apply( { tex } );
+    tex = mBlurH->apply( { tex } );
+
+    if ( ! mBlurV ) {
+        setTexture( 0, tex );
+        setUniform( "uFullTexelSize", vec2( 1.f ) / vec2( ProxyScale::instance().getFullSize( tex ) ) );
+    }
+    else {
+        tex = mBlurV->apply( { tex } );
+        setTexture( 0, texture );
+        setTexture( 1, tex );
+    }
+
+    out< 0 >().update( render() );
+}
+
+Surface32f BlurNode::process( const Surface32f & image ) const
+{
+    Surface32f s = image;
+    for ( size_t i = 0; i < mDownsample.size(); ++i ) s = downsampleSurface( s );
+
+    s = convolveSurface( s, mOffsets, mWeights, vec2( 1.f / s.getWidth(), 0.f ) );
+    s = convolveSurface( s, mOffsets, mWeights, vec2( 0.f, 1.f / s.getHeight() ) );
+
+    if ( mDownsample.empty() ) return s;
+    return upsampleSurface( image, s, 0.f, 1.f );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// PyramidNode
+
+PyramidNode::PyramidNode( int levels )
+{
+    auto shader = downsampleShader( false );
+    for ( int i = 0; i < levels; ++i ) {
+        mPasses.emplace_back( new FilterPass<>( shader, 0.5f ) );
+    }
+    mLevels.resize( mPasses.size() );
+
+    in< 0 >().onReceive( [&]( const gl::Texture2dRef & tex ) {
+        update( tex );
+    } );
+}
+
+void PyramidNode::setOutputFormat( RenderFormat format )
+{
+    RenderStage::setOutputFormat( format );
+    for ( auto & pass : mPasses ) pass->setOutputFormat( format );
+}
+
+void PyramidNode::update( const gl::Texture2dRef & texture )
+{
+    auto tex = texture;
+    for ( size_t i = 0; i < mPasses.size(); ++i ) {
+        tex = mPasses[ i ]->apply( { tex } );
+        mLevels[ i ] = tex;
+    }
+
+    out< 0 >().update( mLevels );
+}
+
+vector< Surface32f > PyramidNode::process( const Surface32f & image ) const
+{
+    vector< Surface32f > levels;
+    for ( size_t i = 0; i < mPasses.size(); ++i ) {
+        levels.push_back( downsampleSurface( levels.empty() ? image : levels.back() ) );
+    }
+    return levels;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// UpsampleNode
+
+UpsampleNode::UpsampleNode( float baseWeight ) :
+FullScreenQuadRenderer< 2 >( upsampleShader( false ), ivec2( 0 ) ),
+mBaseWeight( baseWeight )
+{
+    setUniform( "uBaseWeight", mBaseWeight );
+    setUniform( "uIntensity", mIntensity );
+
+    in< 0 >().onReceive( [&]( const gl::Texture2dRef & tex ) {
+        setTexture( 0, tex );
+    } );
+    in< 1 >().onReceive( [&]( const gl::Texture2dRef & tex ) {
+        setTexture( 1, tex );
+        update();
+    } );
+    in< 2 >().onReceive( [&]( const float & intensity ) {
+        mIntensity = intensity;
+        setUniform( "uIntensity", mIntensity );
+    } );
+}
+
+void UpsampleNode::update()
+{
+    out< 0 >().update( render() );
+}
+
+Surface32f UpsampleNode::process( const Surface32f & base, const Surface32f & low ) const
+{
+    return upsampleSurface( base, low, mBaseWeight, mIntensity );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// BloomNode
+
+BloomNode::BloomNode( const Format & format ) :
+FullScreenQuadRenderer< 2 >( upsampleShader( true ), ivec2( 0 ) ),
+mFormat( format )
+{
+    // bright parts go above 1 but need no alpha or precision
+    setInputPrecision( Precision::HDR_PACKED );
+
+    int levels = std::max( mFormat.getLevels(), 1 );
+    mPrefilter.reset( new FilterPass<>( downsampleShader( true ), 0.5f ) );
+    mPrefilter->setUniform( "uThreshold", mFormat.getThreshold() );
+    mPrefilter->setOutputFormat( RenderFormat::R11G11B10F );
+
+    auto down = downsampleShader( false );
+    auto up = upsampleShader( false );
+    for ( int i = 1; i < levels; ++i ) {
+        mDownsample.emplace_back( new FilterPass<>( down, 0.5f ) );
+        mDownsample.back()->setOutputFormat( RenderFormat::R11G11B10F );
+        mUpsample.emplace_back( new FilterPass< 2 >( up ) );
+        mUpsample.back()->setOutputFormat( RenderFormat::R11G11B10F );
+        mUpsample.back()->setUniform( "uBaseWeight", 1.f );
+        mUpsample.back()->setUniform( "uIntensity", 1.f );
+    }
+
+    setUniform( "uBaseWeight", 1.f );
+    setUniform( "uIntensity", mFormat.getIntensity() );
+
+    in< 0 >().onReceive( [&]( const gl::Texture2dRef & tex ) {
+        update( tex );
+    } );
+    in< 1 >().onReceive( [&]( const float & intensity ) {
+        mFormat.intensity( intensity );
+        setUniform( "uIntensity", intensity );
+    } );
+    in< 2 >().onReceive( [&]( const float & threshold ) {
+        mFormat.threshold( threshold );
+        mPrefilter->setUniform( "uThreshold", threshold );
+    } );
+}
+
+void BloomNode::update( const gl::Texture2dRef & texture )
+{
+    vector< gl::Texture2dRef > levels{ mPrefilter->apply( { texture } ) };
+    for ( auto & pass : mDownsample ) levels.push_back( pass->apply( { levels.back() } ) );
+
+    // collapse from the smallest level up, adding each level on the way
+    auto tex = levels.back();
+    for ( size_t i = mUpsample.size(); i-- > 0; ) {
+        tex = mUpsample[ i ]->apply( { levels[ i ], tex } );
+    }
+
+    setTexture( 0, texture );
+    setTexture( 1, tex );
+    out< 0 >().update( render() );
+}
+
+Surface32f BloomNode::process( const Surface32f & image ) const
+{
+    vector< Surface32f > levels{ downsampleSurface( image ) };
+    thresholdSurface( levels.back(), mFormat.getThreshold() );
+    for ( size_t i = 0; i < mDownsample.size(); ++i ) levels.push_back( downsampleSurface( levels.back() ) );
+
+    Surface32f s = levels.back();
+    for ( size_t i = mUpsample.size(); i-- > 0; ) {
+        s = upsampleSurface( levels[ i ], s, 1.f, 1.f );
+    }
+    return upsampleSurface( image, s, 1.f, mFormat.getIntensity(), true );
+}
@@ -0,0 +1,217 @@
+#include "cinder/framegraph/FrameCache.hpp"
+#include "cinder/framegraph/DiskFrameCache.hpp"
+#include "cinder/gl/scoped.h"
+#include <algorithm>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+
+//! Readbacks in flight before new frames are left uncached rather than
+//! stalling
+const size_t MAX_PENDING = 3;
+
+}
+
+FrameCacheNode::FrameCacheNode( const Format & format ) :
+        mFormat( format )
+{
+    in< 0 >().onReceive( [&]( const gl::Texture2dRef & texture ) {
+        if ( ! texture ) return;
+        poll();
+        if ( ! contains( mKey ) && ! isPending( mKey ) ) store( texture );
+        out< 0 >().update( texture );
+    } );
+}
+
+GLenum FrameCacheNode::getDataType() const
+{
+    switch ( mFormat.getStorage() ) {
+        case Storage::FLOAT: return GL_FLOAT;
+        case Storage::HALF: return GL_HALF_FLOAT;
+        case Storage::BYTE: return GL_UNSIGNED_BYTE;
+    }
+    return GL_FLOAT;
+}
+
+size_t FrameCacheNode::getBytesPerPixel() const
+{
+    switch ( mFormat.getStorage() ) {
+        case Storage::FLOAT: return 16;
+        case Storage::HALF: return 8;
+        case Storage::BYTE: return 4;
+    }
+    return 16;
+}
+
+bool FrameCacheNode::present()
+{
+    poll();
+    auto it = mIndex.find( mKey );
+
+    // frames stored at another proxy scale are rendered again
+    if ( it != mIndex.end() && ProxyScale::instance().getScaledSize( it->second->fullSize ) != it->second->size ) {
+        mBytes -= it->second->data.size();
+        mFrames.erase( it->second );
+        mIndex.erase( it );
+        it = mIndex.end();
+    }
+
+    if ( it == mIndex.end() ) {
+        if ( presentFromDisk() ) {
+            ++mStats.diskHits;
+            return true;
+        }
+        ++mStats.misses;
+        return false;
+    }
+    ++mStats.hits;
+
+    mFrames.splice( mFrames.begin(), mFrames, it->second );
+    const Frame & frame = mFrames.front();
+    upload( frame.data.data(), frame.size, frame.fullSize, frame.topDown );
+
+    out< 0 >().update( mTexture );
+    return true;
+}
+
+bool FrameCacheNode::presentFromDisk()
+{
+    const DiskFrameCacheRef & disk = mFormat.getDisk();
+    if ( ! disk ) return false;
+
+    // uploaded straight from the mapping
+    bool hit = disk->read( mKey, [&]( const DiskFrameCache::Entry & entry, const uint8_t * data ) {
+        if ( entry.storage != (uint8_t)mFormat.getStorage() ) return false;
+        if ( ProxyScale::instance().getScaledSize( entry.fullSize ) != entry.size ) return false;
+        upload( data, entry.size, entry.fullSize, entry.topDown );
+        return true;
+    } );
+    if ( hit ) out< 0 >().update( mTexture );
+    return hit;
+}
+
+void FrameCacheNode::upload( const uint8_t * data, const ivec2 & size, const ivec2 & fullSize, bool topDown )
+{
+    // one texture for every hit, reallocated only when the size changes
+    if ( ! mTexture || mTexture->getSize() != size ) {
+        GLint internalFormat = mFormat.getStorage() == Storage::BYTE ? GL_RGBA8 : mFormat.getStorage() == Storage::HALF ? GL_RGBA16F : GL_RGBA32F;
+        mTexture = gl::Texture2d::create( size.x, size.y, gl::Texture2d::Format().internalFormat( internalFormat ).dataType( getDataType() ) );
+    }
+    mTexture->update( data, GL_RGBA, getDataType(), 0, size.x, size.y );
+    mTexture->setTopDown( topDown );
+    ProxyScale::instance().registerTexture( mTexture, fullSize );
+}
+
+void FrameCacheNode::store( const gl::Texture2dRef & texture )
+{
+    if ( mPending.size() >= MAX_PENDING ) return;
+
+    ivec2 size = texture->getSize();
+    size_t bytes = (size_t)size.x * size.y * getBytesPerPixel();
+    if ( bytes > mFormat.getBudget() ) return;
+
+    Frame frame;
+    frame.key = mKey;
+    frame.size = size;
+    frame.fullSize = ProxyScale::instance().getFullSize( texture );
+    frame.topDown = texture->isTopDown();
+
+    // a free buffer large enough, or a new one
+    gl::PboRef pbo;
+    auto it = find_if( mFreePbos.begin(), mFreePbos.end(), [bytes]( const gl::PboRef & p ) { return p->getSize() >= bytes; } );
+    if ( it != mFreePbos.end() ) {
+        pbo = *it;
+        mFreePbos.erase( it );
+    }
+    else {
+        pbo = gl::Pbo::create( GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ );
+    }
+
+    // the driver converts to the storage type while reading back, into the
+    // buffer without waiting for it
+    {
+        gl::ScopedTextureBind scp_tex( texture, 0 );
+        gl::ScopedBuffer scp_pbo( pbo );
+        glGetTexImage( texture->getTarget(), 0, GL_RGBA, getDataType(), nullptr );
+    }
+    mPending.push_back( { move( frame ), pbo, gl::Sync::create() } );
+}
+
+bool FrameCacheNode::isPending( const Key & key ) const
+{
+    return any_of( mPending.begin(), mPending.end(), [&key]( const Readback & r ) { return r.frame.key == key; } );
+}
+
+void FrameCacheNode::poll()
+{
+    while ( ! mPending.empty() ) {
+        Readback & readback = mPending.front();
+        GLenum status = readback.sync->clientWaitSync();
+        if ( status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED ) break;
+
+        Frame & frame = readback.frame;
+        size_t bytes = (size_t)frame.size.x * frame.size.y * getBytesPerPixel();
+        auto data = (const uint8_t *)readback.pbo->mapBufferRange( 0, bytes, GL_MAP_READ_BIT );
+        if ( data ) frame.data.assign( data, data + bytes );
+        readback.pbo->unmap();
+
+        if ( data && ! contains( frame.key ) ) insert( move( frame ) );
+
+        mFreePbos.push_back( readback.pbo );
+        mPending.pop_front();
+    }
+
+    // buffers beyond those in flight are only kept for reuse
+    while ( mFreePbos.size() > MAX_PENDING ) mFreePbos.erase( mFreePbos.begin() );
+}
+
+void FrameCacheNode::insert( Frame frame )
+{
+    size_t bytes = frame.data.size();
+    if ( bytes > mFormat.getBudget() ) return;
+    evict( mFormat.getBudget() - bytes );
+
+    Key key = frame.key;
+    mFrames.push_front( move( frame ) );
+    mIndex[ key ] = mFrames.begin();
+    mBytes += bytes;
+}
+
+void FrameCacheNode::evict( size_t bytes )
+{
+    while ( mBytes > bytes && ! mFrames.empty() ) {
+        Frame & frame = mFrames.back();
+        mBytes -= frame.data.size();
+        mIndex.erase( frame.key );
+
+        if ( mFormat.getDisk() ) {
+            DiskFrameCache::Entry entry;
+            entry.key = frame.key;
+            entry.size = frame.size;
+            entry.fullSize = frame.fullSize;
+            entry.topDown = frame.topDown;
+            entry.storage = (uint8_t)mFormat.getStorage();
+            mFormat.getDisk()->write( entry, move( frame.data ) );
+        }
+
+        mFrames.pop_back();
+        ++mStats.evictions;
+    }
+}
+
+void FrameCacheNode::setBudget( size_t bytes )
+{
+    mFormat.budget( bytes );
+    evict( bytes );
+}
+
+void FrameCacheNode::clear()
+{
+    mPending.clear();
+    mFrames.clear();
+    mIndex.clear();
+    mBytes = 0;
+}
@@ -0,0 +1,141 @@
+#include "cinder/framegraph/FrameHistory.hpp"
+#include "cinder/framegraph/SurfacePool.hpp"
+#include "cinder/gl/scoped.h"
+#include <algorithm>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+// FrameHistoryNode
+
+FrameHistoryNode::FrameHistoryNode( size_t frames ) :
+        mCapacity( std::max< size_t >( frames, 1 ) )
+{
+    clear();
+    setOutputFormat( RenderFormat::RGBA16F );
+
+    in< 0 >().onReceive( [&]( const gl::Texture2dRef & texture ) {
+        if ( ! texture ) return;
+        push( texture );
+        out< 0 >().update( texture );
+    } );
+}
+
+FrameHistoryNode::~FrameHistoryNode()
+{
+    if ( mReadFbo ) glDeleteFramebuffers( 1, &mReadFbo );
+    if ( mDrawFbo ) glDeleteFramebuffers( 1, &mDrawFbo );
+}
+
+void FrameHistoryNode::clear()
+{
+    // the first push lands in layer 0
+    mHead = mCapacity - 1;
+    mCount = 0;
+}
+
+void FrameHistoryNode::setOutputFormat( RenderFormat format )
+{
+    if ( format == getOutputFormat() && mTexture ) return;
+    RenderStage::setOutputFormat( format );
+    if ( mTexture ) allocate( mSize );
+}
+
+void FrameHistoryNode::allocate( const ivec2 & size )
+{
+    gl::Texture3d::Format fmt;
+    fmt.target( GL_TEXTURE_2D_ARRAY );
+    fmt.internalFormat( getInternalFormat( getOutputFormat() ) );
+    fmt.minFilter( GL_LINEAR );
+    fmt.magFilter( GL_LINEAR );
+    fmt.wrap( GL_CLAMP_TO_EDGE );
+
+    mSize = size;
+    mTexture = gl::Texture3d::create( size.x, size.y, (GLint)mCapacity, fmt );
+    if ( ! mReadFbo ) glGenFramebuffers( 1, &mReadFbo );
+    if ( ! mDrawFbo ) glGenFramebuffers( 1, &mDrawFbo );
+    clear();
+}
+
+void FrameHistoryNode::push( const gl::Texture2dRef & texture )
+{
+    ivec2 size = texture->getSize();
+    if ( ! mTexture || size != mSize ) allocate( size );
+
+    mHead = ( mHead + 1 ) % mCapacity;
+    mCount = std::min( mCount + 1, mCapacity );
+
+    {
+        gl::ScopedFramebuffer scp_read( GL_READ_FRAMEBUFFER, mReadFbo );
+        gl::ScopedFramebuffer scp_draw( GL_DRAW_FRAMEBUFFER, mDrawFbo );
+        glFramebufferTexture2D( GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture->getTarget(), texture->getId(), 0 );
+        glFramebufferTextureLayer( GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mTexture->getId(), 0, (GLint)mHead );
+
+        // flip bottom up inputs so every layer samples like a render target
+        GLint y0 = texture->isTopDown() ? 0 : size.y;
+        GLint y1 = texture->isTopDown() ? size.y : 0;
+        glBlitFramebuffer( 0, 0, size.x, size.y, 0, y0, size.x, y1, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+
+        // don't keep the input alive in the framebuffer
+        glFramebufferTexture2D( GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture->getTarget(), 0, 0 );
+    }
+
+    for ( auto & attachment : mAttachments ) attachment();
+}
+
+string FrameHistoryNode::getGlsl( const string & name, const string & function )
+{
+    return
+        "uniform sampler2DArray " + name + ";\n"
+        "uniform int " + name + "Head;\n"
+        "uniform int " + name + "Count;\n"
+        "uniform int " + name + "Size;\n"
+        "vec4 " + function + "( vec2 uv, int age ) {\n"
+        "    age = clamp( age, 0, max( " + name + "Count - 1, 0 ) );\n"
+        "    int layer = ( " + name + "Head - age + " + name + "Size ) % " + name + "Size;\n"
+        "    return texture( " + name + ", vec3( uv, float( layer ) ) );\n"
+        "}\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SurfaceHistoryNode
+
+SurfaceHistoryNode::SurfaceHistoryNode( size_t frames ) :
+        mRing( std::max< size_t >( frames, 1 ) )
+{
+    clear();
+
+    in< 0 >().onReceive( [&]( const Surface32fRef & surface ) {
+        if ( ! surface ) return;
+        push( surface );
+        out< 0 >().update( surface );
+    } );
+}
+
+void SurfaceHistoryNode::clear()
+{
+    mHead = mRing.size() - 1;
+    mCount = 0;
+}
+
+void SurfaceHistoryNode::push( const Surface32fRef & surface )
+{
+    const Surface32fRef & first = mRing.front();
+    if ( ! first || first->getSize() != surface->getSize() || first->hasAlpha() != surface->hasAlpha() ) {
+        for ( auto & slot : mRing ) slot = SurfacePool::instance().get( surface->getWidth(), surface->getHeight(), surface->hasAlpha() );
+        clear();
+    }
+
+    mHead = ( mHead + 1 ) % mRing.size();
+    mCount = std::min( mCount + 1, mRing.size() );
+    mRing[ mHead ]->copyFrom( *surface, surface->getBounds() );
+}
+
+Surface32fRef SurfaceHistoryNode::get( size_t age ) const
+{
+    if ( mCount == 0 ) return nullptr;
+    age = std::min( age, mCount - 1 );
+    return mRing[ ( mHead + mRing.size() - age ) % mRing.size() ];
+}
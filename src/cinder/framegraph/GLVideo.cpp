@@ -1,4 +1,6 @@
 #include "cinder/framegraph/GLVideo.hpp"
+#include <algorithm>
+#include <cmath>
 
 using namespace glvideo;
 using namespace cinder;
@@ -6,34 +8,186 @@ using namespace std;
 using namespace frame_graph;
 
 
+namespace {
+
+double toSeconds( double secs ) { return secs; }
+
+template< typename Rep, typename Period >
+double toSeconds( const std::chrono::duration< Rep, Period > & secs )
+{
+    return std::chrono::duration< double >( secs ).count();
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// GLVideoSource
+
+GLVideoSource::GLVideoSource( const glvideo::Movie::ref & movie ) :
+    mMovie( movie )
+{
+}
+
+void GLVideoSource::update()
+{
+    mMovie->update();
+    auto frame = mMovie->getCurrentFrame();
+    if ( ! frame || ( ! mFrames.empty() && mFrames.back().frame == frame ) ) return;
+
+    // stream time follows playback, and steps on by a frame across loops
+    // and seeks so the cache stays ordered
+    double elapsed = toSeconds( mMovie->getElapsedTime() );
+    double step = elapsed - mLastElapsed;
+    if ( ! mFrames.empty() ) {
+        if ( step > 0.0 && step < 1.0 ) mLastStep = step;
+        mStreamTime += mLastStep;
+    }
+    mLastElapsed = elapsed;
+
+    auto tex = gl::Texture2d::create( frame->getTextureTarget(), frame->getTextureId(), mMovie->getWidth(), mMovie->getHeight(), true /* doNotDispose */ );
+    tex->setTopDown( true );
+    mFrames.push_back( { mStreamTime, frame, tex } );
+
+    // keep one frame from before the history so its start has a frame
+    while ( mFrames.size() > 1 && mFrames[ 1 ].time <= mStreamTime - mHistory ) mFrames.pop_front();
+}
+
+void GLVideoSource::setPlayhead( const void * playhead, double position )
+{
+    auto it = find_if( mPlayheads.begin(), mPlayheads.end(), [playhead]( const pair< const void *, double > & p ) { return p.first == playhead; } );
+    if ( it != mPlayheads.end() ) it->second = position;
+    else                          mPlayheads.emplace_back( playhead, position );
+
+    // the trailing playheads read this far behind the decode
+    double lowest = position;
+    for ( auto & p : mPlayheads ) lowest = std::min( lowest, p.second );
+    reserveHistory( getLeadPosition() - lowest );
+}
+
+void GLVideoSource::removePlayhead( const void * playhead )
+{
+    mPlayheads.erase( remove_if( mPlayheads.begin(), mPlayheads.end(), [playhead]( const pair< const void *, double > & p ) { return p.first == playhead; } ), mPlayheads.end() );
+}
+
+double GLVideoSource::getLeadPosition() const
+{
+    if ( mPlayheads.empty() ) return 0.0;
+    double lead = mPlayheads.front().second;
+    for ( auto & p : mPlayheads ) lead = std::max( lead, p.second );
+    return lead;
+}
+
+bool GLVideoSource::beginSync( int64_t vsync )
+{
+    if ( vsync == mSyncedVsync ) return false;
+    mSyncedVsync = vsync;
+    return true;
+}
+
+gl::Texture2dRef GLVideoSource::getFrame( double time ) const
+{
+    if ( mFrames.empty() ) return nullptr;
+
+    auto it = upper_bound( mFrames.begin(), mFrames.end(), time, []( double t, const CachedFrame & f ) { return t < f.time; } );
+    if ( it != mFrames.begin() ) --it;
+    return it->texture;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// GLVideoINode
+
 GLVideoINode::GLVideoINode( const glvideo::Context::ref & context, const fs::path & path, bool playImmediately ) :
-	mMovie( Movie::create( context, path.string(), Movie::Options().cpuBufferSize( 2 ).prebuffer( false ) ) )
+	GLVideoINode( Movie::create( context, path.string(), Movie::Options().cpuBufferSize( 2 ).prebuffer( false ) ) )
 {
 	if ( playImmediately ) mMovie->play();
 
 }
 
 GLVideoINode::GLVideoINode( const glvideo::Movie::ref & movie ) :
-    mMovie( movie )
+    GLVideoINode( GLVideoSource::create( movie ) )
+{
+}
+
+GLVideoINode::GLVideoINode( const GLVideoSourceRef & source ) :
+    mSource( source ),
+    mMovie( source->getMovie() )
 {
 }
 
 GLVideoINode::GLVideoINode( const GLVideoINode & original ) :
-    mMovie( Movie::create( *original.getMovie() ) )
+    mSource( original.mSource ),
+    mMovie( original.mMovie ),
+    mDelay( original.mDelay ),
+    mClock( original.mClock ),
+    mClockOffset( original.mClockOffset )
+{
+    registerPlayhead();
+}
+
+GLVideoINode::~GLVideoINode()
 {
+    mSource->removePlayhead( this );
+}
 
+GLVideoINode & GLVideoINode::syncTo( PresentationClock * clock, double offset )
+{
+    mClock = clock;
+    mClockOffset = offset;
+    registerPlayhead();
+    return *this;
+}
+
+GLVideoINode & GLVideoINode::setDelay( double seconds )
+{
+    mDelay = seconds;
+    mSource->reserveHistory( seconds );
+    registerPlayhead();
+    return *this;
+}
+
+void GLVideoINode::registerPlayhead()
+{
+    if ( mClock ) mSource->setPlayhead( this, mClockOffset - mDelay );
+    else          mSource->removePlayhead( this );
 }
 
 void GLVideoINode::update()
 {
-    mMovie->update();
-	auto frame = mMovie->getCurrentFrame();
-	if ( frame ) {
-		auto tex = gl::Texture2d::create( frame->getTextureTarget(), frame->getTextureId(), mMovie->getWidth(), mMovie->getHeight(), true /* doNotDispose */ );
-		tex->setTopDown( true );
-		//frame->setOwnsTexture( false );
-		TextureINode::update( tex );
-	}
+    double delay = mDelay;
+    if ( mClock ) {
+        // a repeated frame shows what the last one showed
+        if ( mClock->getAdvance() == 0 ) return;
+
+        // the movie follows the playhead furthest ahead, once per frame,
+        // and the others show the frames it decoded a little earlier
+        double lead = mSource->getLeadPosition();
+        if ( mSource->beginSync( mClock->getVsync() ) ) syncToClock( lead );
+        delay = lead - ( mClockOffset - mDelay );
+    }
+
+    mSource->update();
+    auto tex = mSource->getFrame( mSource->getTime() - delay );
+    if ( tex ) TextureINode::update( tex );
+}
+
+void GLVideoINode::syncToClock( double position )
+{
+    double duration = toSeconds( getDuration() );
+    double target = position + mClock->getTime() * getPlaybackRate();
+
+    if ( mSource->isLooping() && duration > 0.0 ) {
+        target = fmod( target, duration );
+        if ( target < 0.0 ) target += duration;
+    }
+    else {
+        target = glm::clamp( target, 0.0, duration );
+    }
+
+    // decoding keeps pace by itself, so only seek when it has fallen behind
+    // or run ahead of the clock
+    if ( std::abs( toSeconds( getElapsedTime() ) - target ) > 1.5 * mClock->getPeriod() ) {
+        mMovie->seek( glvideo::seconds( target ) );
+    }
 }
 
 
@@ -72,6 +226,6 @@ void main( void ) {
 
 
 GLVideoHapQDecodeShaderIONode::GLVideoHapQDecodeShaderIONode( const ci::ivec2 & size ) :
-TextureShaderIONode( gl::GlslProg::create( gl::GlslProg::Format().vertex( vertex ).fragment( fragmentYCoCg ) ), size )
+TextureShaderIONode( gl::GlslProg::Format().vertex( vertex ).fragment( fragmentYCoCg ), size )
 {
 }
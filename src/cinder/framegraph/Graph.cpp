@@ -0,0 +1,469 @@
+#include "cinder/framegraph/Graph.hpp"
+#include "cinder/framegraph/AsyncTexture.hpp"
+#include "cinder/framegraph/ColorGradeNode.hpp"
+#include "cinder/framegraph/Filters.hpp"
+#include "cinder/framegraph/LUTFile.hpp"
+#include "cinder/framegraph/LUTNode.hpp"
+#include "cinder/framegraph/Scopes.hpp"
+#include "cinder/framegraph/VecNode.hpp"
+#include "cinder/app/App.h"
+#include "cinder/ImageIo.h"
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <sstream>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+
+template< typename T >
+T param( const JsonTree & params, const string & key, const T & defaultValue )
+{
+    return params.hasChild( key ) ? params.getValueForKey< T >( key ) : defaultValue;
+}
+
+ivec2 sizeParam( const JsonTree & params )
+{
+    if ( ! params.hasChild( "size" ) ) return ivec2( 0 );
+    const JsonTree & size = params.getChild( "size" );
+    return ivec2( size.getValueAtIndex< int >( 0 ), size.getValueAtIndex< int >( 1 ) );
+}
+
+vec3 vec3Param( const JsonTree & params, const string & key, const vec3 & defaultValue )
+{
+    if ( ! params.hasChild( key ) ) return defaultValue;
+    const JsonTree & v = params.getChild( key );
+    return vec3( v.getValueAtIndex< float >( 0 ), v.getValueAtIndex< float >( 1 ), v.getValueAtIndex< float >( 2 ) );
+}
+
+//! Paths are tried as assets first, so graphs can ship alongside them.
+fs::path pathParam( const JsonTree & params, const string & key )
+{
+    fs::path path = params.getValueForKey( key );
+    if ( path.is_relative() ) {
+        fs::path asset = app::getAssetPath( path );
+        if ( ! asset.empty() ) return asset;
+    }
+    return path;
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// NodeFactory
+
+NodeFactory & NodeFactory::instance()
+{
+    static NodeFactory factory;
+    return factory;
+}
+
+NodeFactory::NodeFactory()
+{
+    addSource< TextureINode >( "TextureINode", []( const JsonTree & params ) {
+        return TextureINode::create( loadImage( pathParam( params, "path" ) ) );
+    } );
+    addSource< AsyncTextureINode >( "AsyncTextureINode", []( const JsonTree & params ) {
+        return AsyncTextureINode::create( pathParam( params, "path" ) );
+    } );
+    addSource< nodes::ValueNodef >( "float", []( const JsonTree & params ) {
+        return make_shared< nodes::ValueNodef >( param( params, "value", 0.f ) );
+    } );
+    addSource< Vec3Node<> >( "vec3", []( const JsonTree & params ) {
+        return make_shared< Vec3Node<> >( vec3Param( params, "value", vec3( 0 ) ) );
+    } );
+
+    add< TextureONode >( "TextureONode", []( const JsonTree & ) {
+        return TextureONode::create();
+    } );
+    add< ColorGradeNode >( "ColorGradeNode", []( const JsonTree & params ) {
+        return make_shared< ColorGradeNode >( sizeParam( params ) );
+    } );
+    add< LUTNode >( "LUTNode", []( const JsonTree & params ) {
+        LUTNode::Format format;
+        format.size( param( params, "lutSize", 64 ) );
+        if ( param< string >( params, "interpolation", "trilinear" ) == "tetrahedral" ) {
+            format.interpolation( LUTNode::Interpolation::TETRAHEDRAL );
+        }
+        if ( ! params.hasChild( "file" ) ) return LUTNode::create( sizeParam( params ), format );
+
+        Lut3d lut = loadLut( pathParam( params, "file" ) );
+        auto node = LUTNode::create( sizeParam( params ), format.texture3d() );
+        node->setLUT( lut );
+        return node;
+    } );
+    add< BlurNode >( "BlurNode", []( const JsonTree & params ) {
+        BlurNode::Format format;
+        format.radius( param( params, "radius", format.getRadius() ) );
+        if ( param< string >( params, "kernel", "gaussian" ) == "box" ) {
+            format.kernel( BlurNode::Kernel::BOX );
+        }
+        return BlurNode::create( format );
+    } );
+    add< PyramidNode >( "PyramidNode", []( const JsonTree & params ) {
+        return PyramidNode::create( param( params, "levels", 6 ) );
+    } );
+    add< UpsampleNode >( "UpsampleNode", []( const JsonTree & params ) {
+        return UpsampleNode::create( param( params, "baseWeight", 1.f ) );
+    } );
+    add< BloomNode >( "BloomNode", []( const JsonTree & params ) {
+        BloomNode::Format format;
+        format.levels( param( params, "levels", format.getLevels() ) )
+              .intensity( param( params, "intensity", format.getIntensity() ) )
+              .threshold( param( params, "threshold", format.getThreshold() ) );
+        return BloomNode::create( format );
+    } );
+    add< ScopeNode >( "ScopeNode", []( const JsonTree & params ) {
+        ScopeNode::Format format;
+        string type = param< string >( params, "type", "histogram" );
+        if ( type == "waveform" )           format.type( ScopeType::WAVEFORM );
+        else if ( type == "vectorscope" )   format.type( ScopeType::VECTORSCOPE );
+        return ScopeNode::create( format );
+    } );
+}
+
+const NodeType & NodeFactory::get( const string & name ) const
+{
+    auto it = mTypes.find( name );
+    if ( it == mTypes.end() ) throw GraphExc( "Unknown node type: " + name );
+    return it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// GraphDesc
+
+size_t GraphDesc::indexOf( const string & id ) const
+{
+    for ( size_t i = 0; i < nodes.size(); ++i ) {
+        if ( nodes[ i ].id == id ) return i;
+    }
+    throw GraphExc( "Unknown node: " + id );
+}
+
+GraphDesc GraphDesc::fromJson( const JsonTree & json )
+{
+    GraphDesc desc;
+    for ( const auto & node : json.getChild( "nodes" ).getChildren() ) {
+        NodeDesc n;
+        n.id = node.getValueForKey( "id" );
+        n.type = node.getValueForKey( "type" );
+        n.params = node.hasChild( "params" ) ? node.getChild( "params" ) : JsonTree::makeObject( "params" );
+        n.active = param( node, "active", false );
+
+        for ( const auto & other : desc.nodes ) {
+            if ( other.id == n.id ) throw GraphExc( "Duplicate node: " + n.id );
+        }
+        desc.nodes.push_back( n );
+    }
+
+    if ( json.hasChild( "connections" ) ) {
+        for ( const auto & connection : json.getChild( "connections" ).getChildren() ) {
+            Connection c;
+            c.from = desc.indexOf( connection.getValueForKey( "from" ) );
+            c.outlet = param( connection, "outlet", 0 );
+            c.to = desc.indexOf( connection.getValueForKey( "to" ) );
+            c.inlet = param( connection, "inlet", 0 );
+            desc.connections.push_back( c );
+        }
+    }
+    return desc;
+}
+
+JsonTree GraphDesc::toJson() const
+{
+    JsonTree jsonNodes = JsonTree::makeArray( "nodes" );
+    for ( const auto & n : nodes ) {
+        JsonTree node = JsonTree::makeObject();
+        node.addChild( JsonTree( "id", n.id ) )
+            .addChild( JsonTree( "type", n.type ) );
+        if ( n.params.hasChildren() ) node.addChild( n.params );
+        if ( n.active ) node.addChild( JsonTree( "active", true ) );
+        jsonNodes.addChild( node );
+    }
+
+    JsonTree jsonConnections = JsonTree::makeArray( "connections" );
+    for ( const auto & c : connections ) {
+        JsonTree connection = JsonTree::makeObject();
+        connection.addChild( JsonTree( "from", nodes[ c.from ].id ) );
+        if ( c.outlet ) connection.addChild( JsonTree( "outlet", (uint32_t)c.outlet ) );
+        connection.addChild( JsonTree( "to", nodes[ c.to ].id ) );
+        if ( c.inlet ) connection.addChild( JsonTree( "inlet", (uint32_t)c.inlet ) );
+        jsonConnections.addChild( connection );
+    }
+
+    JsonTree json = JsonTree::makeObject();
+    json.addChild( jsonNodes ).addChild( jsonConnections );
+    return json;
+}
+
+namespace {
+
+// the binary form: a magic, then counted nodes and connections. Strings are
+// length-prefixed and integers little-endian, as on every host we run on.
+const char BINARY_MAGIC[ 4 ] = { 'F', 'G', 'B', '1' };
+
+// the fewest bytes each record can take, to check counts against the file
+const size_t MIN_TREE_BYTES = 1 + 4;
+const size_t MIN_NODE_BYTES = 4 + 4 + 1 + MIN_TREE_BYTES;
+const size_t MIN_CONNECTION_BYTES = 4 * 4;
+
+// params nest a few levels in practice; deeper files are corrupt or hostile
+const int MAX_TREE_DEPTH = 64;
+
+enum class Kind : uint8_t {
+    OBJECT, ARRAY, BOOL, INT, DOUBLE, STRING
+};
+
+void writeU32( ostream & out, uint32_t v )
+{
+    out.write( reinterpret_cast< const char * >( &v ), sizeof( v ) );
+}
+
+void writeString( ostream & out, const string & s )
+{
+    writeU32( out, (uint32_t)s.size() );
+    out.write( s.data(), s.size() );
+}
+
+template< typename T >
+T read( istream & in )
+{
+    T v;
+    if ( ! in.read( reinterpret_cast< char * >( &v ), sizeof( v ) ) ) throw GraphExc( "Truncated graph file" );
+    return v;
+}
+
+//! The bytes left in \a in, or as many as a size_t holds when the stream
+//! can't seek.
+size_t remaining( istream & in )
+{
+    auto pos = in.tellg();
+    if ( pos < 0 ) return numeric_limits< size_t >::max();
+    in.seekg( 0, ios::end );
+    auto end = in.tellg();
+    in.seekg( pos );
+    return end < pos ? 0 : (size_t)( end - pos );
+}
+
+//! Reads a count of records of at least \a minBytes each, checked against
+//! the bytes left so a corrupt count can't trigger a huge allocation.
+uint32_t readCount( istream & in, size_t minBytes )
+{
+    uint32_t count = read< uint32_t >( in );
+    if ( count > remaining( in ) / minBytes ) throw GraphExc( "Truncated graph file" );
+    return count;
+}
+
+string readString( istream & in )
+{
+    string s( readCount( in, 1 ), '\0' );
+    if ( ! s.empty() && ! in.read( &s[ 0 ], s.size() ) ) throw GraphExc( "Truncated graph file" );
+    return s;
+}
+
+void writeTree( ostream & out, const JsonTree & tree )
+{
+    Kind kind = Kind::OBJECT;
+    if ( tree.getNodeType() == JsonTree::NODE_ARRAY ) {
+        kind = Kind::ARRAY;
+    }
+    else if ( tree.getNodeType() == JsonTree::NODE_VALUE ) {
+        switch ( tree.getValueType() ) {
+            case JsonTree::VALUE_BOOL: kind = Kind::BOOL; break;
+            case JsonTree::VALUE_INT:
+            case JsonTree::VALUE_UINT: kind = Kind::INT; break;
+            case JsonTree::VALUE_DOUBLE: kind = Kind::DOUBLE; break;
+            default: kind = Kind::STRING; break;
+        }
+    }
+
+    // nulls are written as empty objects
+    out.put( (char)kind );
+    writeString( out, tree.getKey() );
+    switch ( kind ) {
+        case Kind::OBJECT:
+        case Kind::ARRAY: {
+            const auto & children = tree.getNodeType() == JsonTree::NODE_NULL ? JsonTree::Container() : tree.getChildren();
+            writeU32( out, (uint32_t)children.size() );
+            for ( const auto & child : children ) writeTree( out, child );
+            break;
+        }
+        case Kind::BOOL: out.put( tree.getValue< bool >() ? 1 : 0 ); break;
+        case Kind::INT: {
+            int64_t v = tree.getValue< int64_t >();
+            out.write( reinterpret_cast< const char * >( &v ), sizeof( v ) );
+            break;
+        }
+        case Kind::DOUBLE: {
+            double v = tree.getValue< double >();
+            out.write( reinterpret_cast< const char * >( &v ), sizeof( v ) );
+            break;
+        }
+        case Kind::STRING: writeString( out, tree.getValue() ); break;
+    }
+}
+
+JsonTree readTree( istream & in, int depth = 0 )
+{
+    if ( depth > MAX_TREE_DEPTH ) throw GraphExc( "Corrupt graph file, parameters nest too deeply" );
+
+    Kind kind = (Kind)read< uint8_t >( in );
+    string key = readString( in );
+    switch ( kind ) {
+        case Kind::OBJECT:
+        case Kind::ARRAY: {
+            JsonTree tree = kind == Kind::OBJECT ? JsonTree::makeObject( key ) : JsonTree::makeArray( key );
+            uint32_t count = readCount( in, MIN_TREE_BYTES );
+            for ( uint32_t i = 0; i < count; ++i ) tree.addChild( readTree( in, depth + 1 ) );
+            return tree;
+        }
+        case Kind::BOOL: return JsonTree( key, read< uint8_t >( in ) != 0 );
+        case Kind::INT: return JsonTree( key, read< int64_t >( in ) );
+        case Kind::DOUBLE: return JsonTree( key, read< double >( in ) );
+        case Kind::STRING: return JsonTree( key, readString( in ) );
+    }
+    throw GraphExc( "Corrupt graph file" );
+}
+
+}
+
+GraphDesc GraphDesc::load( const DataSourceRef & source )
+{
+    BufferRef buffer = source->getBuffer();
+    if ( buffer->getSize() >= sizeof( BINARY_MAGIC ) && ! memcmp( buffer->getData(), BINARY_MAGIC, sizeof( BINARY_MAGIC ) ) ) {
+        istringstream in( string( static_cast< const char * >( buffer->getData() ), buffer->getSize() ) );
+        return readBinary( in );
+    }
+    return fromJson( JsonTree( source ) );
+}
+
+void GraphDesc::writeBinary( ostream & out ) const
+{
+    out.write( BINARY_MAGIC, sizeof( BINARY_MAGIC ) );
+
+    writeU32( out, (uint32_t)nodes.size() );
+    for ( const auto & n : nodes ) {
+        writeString( out, n.id );
+        writeString( out, n.type );
+        out.put( n.active ? 1 : 0 );
+        writeTree( out, n.params );
+    }
+
+    writeU32( out, (uint32_t)connections.size() );
+    for ( const auto & c : connections ) {
+        writeU32( out, (uint32_t)c.from );
+        writeU32( out, (uint32_t)c.outlet );
+        writeU32( out, (uint32_t)c.to );
+        writeU32( out, (uint32_t)c.inlet );
+    }
+}
+
+GraphDesc GraphDesc::readBinary( istream & in )
+{
+    char magic[ sizeof( BINARY_MAGIC ) ];
+    if ( ! in.read( magic, sizeof( magic ) ) || memcmp( magic, BINARY_MAGIC, sizeof( magic ) ) ) {
+        throw GraphExc( "Not a binary graph file" );
+    }
+
+    GraphDesc desc;
+    desc.nodes.resize( readCount( in, MIN_NODE_BYTES ) );
+    for ( auto & n : desc.nodes ) {
+        n.id = readString( in );
+        n.type = readString( in );
+        n.active = read< uint8_t >( in ) != 0;
+        n.params = readTree( in );
+    }
+
+    desc.connections.resize( readCount( in, MIN_CONNECTION_BYTES ) );
+    for ( auto & c : desc.connections ) {
+        c.from = read< uint32_t >( in );
+        c.outlet = read< uint32_t >( in );
+        c.to = read< uint32_t >( in );
+        c.inlet = read< uint32_t >( in );
+        if ( c.from >= desc.nodes.size() || c.to >= desc.nodes.size() ) throw GraphExc( "Corrupt graph file" );
+    }
+    return desc;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Graph
+
+Graph::Graph( const GraphDesc & desc ) :
+        mDesc( desc ),
+        mNodes( desc.nodes.size() )
+{
+    // resolve every type up front so a bad file fails on load, not on activation
+    for ( const auto & n : mDesc.nodes ) {
+        mTypes.push_back( &NodeFactory::instance().get( n.type ) );
+    }
+
+    for ( const auto & n : mDesc.nodes ) {
+        if ( n.active ) activate( n.id );
+    }
+}
+
+void Graph::create( size_t i, vector< bool > & visiting, vector< size_t > * created )
+{
+    if ( mNodes[ i ] || visiting[ i ] ) return;
+    visiting[ i ] = true;
+
+    for ( const auto & c : mDesc.connections ) {
+        if ( c.to == i ) create( c.from, visiting, created );
+    }
+
+    mNodes[ i ] = mTypes[ i ]->create( mDesc.nodes[ i ].params );
+    created->push_back( i );
+}
+
+void Graph::activate( const string & id )
+{
+    vector< bool > visiting( mNodes.size() );
+    vector< size_t > created;
+    create( mDesc.indexOf( id ), visiting, &created );
+    if ( created.empty() ) return;
+
+    for ( const auto & c : mDesc.connections ) {
+        // connections into nodes that existed already were made when they were
+        if ( ! visiting[ c.to ] || ! mNodes[ c.from ] ) continue;
+
+        const NodeType & from = *mTypes[ c.from ];
+        const NodeType & to = *mTypes[ c.to ];
+        if ( ! from.connect( mNodes[ c.from ].get(), c.outlet, to, mNodes[ c.to ].get(), c.inlet ) ) {
+            throw GraphExc( "Can't connect " + mDesc.nodes[ c.from ].id + ":" + to_string( c.outlet )
+                            + " to " + mDesc.nodes[ c.to ].id + ":" + to_string( c.inlet ) );
+        }
+
+        RenderStage * producer = from.stage( mNodes[ c.from ].get() );
+        RenderStage * consumer = to.stage( mNodes[ c.to ].get() );
+        if ( producer && consumer ) mStages.link( *producer, *consumer );
+    }
+    mStages.negotiateFormats();
+
+    // sources emit once so the new nodes have something to work on
+    for ( size_t i : created ) {
+        if ( mTypes[ i ]->update ) {
+            mSources.push_back( i );
+            mTypes[ i ]->update( mNodes[ i ].get() );
+        }
+    }
+}
+
+size_t Graph::getNumActive() const
+{
+    size_t n = 0;
+    for ( const auto & node : mNodes ) {
+        if ( node ) ++n;
+    }
+    return n;
+}
+
+void Graph::update()
+{
+    for ( size_t i : mSources ) {
+        mTypes[ i ]->update( mNodes[ i ].get() );
+    }
+}
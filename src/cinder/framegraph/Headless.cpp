@@ -0,0 +1,121 @@
+#include "cinder/framegraph/Headless.hpp"
+#include "cinder/gl/Environment.h"
+#include "cinder/gl/gl.h"
+#include <EGL/eglext.h>
+#include <cstring>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+
+bool hasExtension( const char * extensions, const char * name )
+{
+    if ( ! extensions ) return false;
+
+    size_t length = strlen( name );
+    for ( const char * p = strstr( extensions, name ); p; p = strstr( p + length, name ) ) {
+        bool starts = p == extensions || p[ -1 ] == ' ';
+        bool ends = p[ length ] == ' ' || p[ length ] == '\0';
+        if ( starts && ends ) return true;
+    }
+    return false;
+}
+
+EGLDisplay getDisplay()
+{
+    // the client extensions are only queryable without a display
+    const char * clientExtensions = eglQueryString( EGL_NO_DISPLAY, EGL_EXTENSIONS );
+    if ( hasExtension( clientExtensions, "EGL_MESA_platform_surfaceless" ) ) {
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+        if ( getPlatformDisplay ) {
+            EGLDisplay display = getPlatformDisplay( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr );
+            if ( display != EGL_NO_DISPLAY ) return display;
+        }
+    }
+    return eglGetDisplay( EGL_DEFAULT_DISPLAY );
+}
+
+}
+
+HeadlessContextRef HeadlessContext::create()
+{
+    return make_shared< HeadlessContext >();
+}
+
+HeadlessContext::HeadlessContext()
+{
+    mDisplay = getDisplay();
+    if ( mDisplay == EGL_NO_DISPLAY || ! eglInitialize( mDisplay, nullptr, nullptr ) ) {
+        throw HeadlessContextExc( "Unable to initialize an EGL display" );
+    }
+    if ( ! eglBindAPI( EGL_OPENGL_API ) ) {
+        throw HeadlessContextExc( "EGL display doesn't support desktop OpenGL" );
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if ( ! eglChooseConfig( mDisplay, configAttribs, &config, 1, &numConfigs ) || numConfigs == 0 ) {
+        throw HeadlessContextExc( "No EGL config for offscreen OpenGL rendering" );
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    mEglContext = eglCreateContext( mDisplay, config, EGL_NO_CONTEXT, contextAttribs );
+    if ( mEglContext == EGL_NO_CONTEXT ) {
+        throw HeadlessContextExc( "Unable to create an OpenGL 3.3 core context" );
+    }
+
+    // everything renders to FBOs, so a surface is only needed without
+    // surfaceless support
+    if ( ! hasExtension( eglQueryString( mDisplay, EGL_EXTENSIONS ), "EGL_KHR_surfaceless_context" ) ) {
+        const EGLint surfaceAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        mSurface = eglCreatePbufferSurface( mDisplay, config, surfaceAttribs );
+        if ( mSurface == EGL_NO_SURFACE ) {
+            throw HeadlessContextExc( "Unable to create an EGL pbuffer" );
+        }
+    }
+
+    if ( ! eglMakeCurrent( mDisplay, mSurface, mSurface, mEglContext ) ) {
+        throw HeadlessContextExc( "Unable to make the EGL context current" );
+    }
+
+    gl::Environment::setCore();
+    gl::env()->initializeFunctionPointers();
+
+    auto platformData = make_shared< gl::PlatformDataLinux >( mEglContext, mDisplay, mSurface, config );
+    mContext = gl::Context::createFromExisting( platformData );
+    mContext->makeCurrent();
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    mContext.reset();
+
+    if ( mDisplay == EGL_NO_DISPLAY ) return;
+
+    eglMakeCurrent( mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+    if ( mSurface != EGL_NO_SURFACE ) eglDestroySurface( mDisplay, mSurface );
+    if ( mEglContext != EGL_NO_CONTEXT ) eglDestroyContext( mDisplay, mEglContext );
+    eglTerminate( mDisplay );
+}
+
+string HeadlessContext::getRenderer() const
+{
+    const GLubyte * renderer = glGetString( GL_RENDERER );
+    return renderer ? string( reinterpret_cast< const char * >( renderer ) ) : string();
+}
@@ -0,0 +1,511 @@
+#include "cinder/framegraph/LUTFile.hpp"
+#include "cinder/framegraph/ThreadPool.hpp"
+#include "cinder/Log.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////
+// Text parsing
+
+//! Lines are split serially, then data lines are parsed in chunks of this
+//! many on the thread pool.
+const size_t PARSE_GRAIN = 8192;
+
+struct Line {
+    const char * begin;
+    const char * end;
+};
+
+//! Splits \a text into lines, stripping comments, surrounding whitespace and
+//! empty lines.
+vector< Line > splitLines( const string & text )
+{
+    vector< Line > lines;
+    const char * p = text.data();
+    const char * end = p + text.size();
+
+    while ( p < end ) {
+        const char * eol = (const char *)memchr( p, '\n', end - p );
+        if ( ! eol ) eol = end;
+
+        const char * comment = (const char *)memchr( p, '#', eol - p );
+        const char * e = comment ? comment : eol;
+
+        while ( p < e && isspace( (unsigned char)*p ) ) ++p;
+        while ( e > p && isspace( (unsigned char)e[ -1 ] ) ) --e;
+        if ( p < e ) lines.push_back( { p, e } );
+
+        p = eol + 1;
+    }
+
+    return lines;
+}
+
+//! Parses a decimal float the way strtof does in the "C" locale, whatever
+//! the global locale is, reading no further than \a end. Returns the
+//! position after the number, or \a p if there is none.
+const char * parseFloat( const char * p, const char * end, float * out )
+{
+    const char * start = p;
+    while ( p < end && isspace( (unsigned char)*p ) ) ++p;
+
+    bool negative = false;
+    if ( p < end && ( *p == '+' || *p == '-' ) ) negative = *p++ == '-';
+
+    // up to 19 significant digits fit the mantissa, more can't change a float
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    bool any = false;
+    for ( ; p < end && isdigit( (unsigned char)*p ); ++p ) {
+        any = true;
+        if ( digits < 19 ) {
+            mantissa = mantissa * 10 + ( *p - '0' );
+            if ( mantissa ) ++digits;
+        }
+        else ++exponent;
+    }
+    if ( p < end && *p == '.' ) {
+        for ( ++p; p < end && isdigit( (unsigned char)*p ); ++p ) {
+            any = true;
+            if ( digits < 19 ) {
+                mantissa = mantissa * 10 + ( *p - '0' );
+                if ( mantissa ) ++digits;
+                --exponent;
+            }
+        }
+    }
+    if ( ! any ) return start;
+
+    if ( p < end && ( *p == 'e' || *p == 'E' ) ) {
+        const char * e = p + 1;
+        bool negativeExponent = false;
+        if ( e < end && ( *e == '+' || *e == '-' ) ) negativeExponent = *e++ == '-';
+        if ( e < end && isdigit( (unsigned char)*e ) ) {
+            int value = 0;
+            for ( ; e < end && isdigit( (unsigned char)*e ); ++e ) value = std::min( value * 10 + ( *e - '0' ), 100000 );
+            exponent += negativeExponent ? -value : value;
+            p = e;
+        }
+    }
+
+    double value = (double)mantissa * std::pow( 10.0, exponent );
+    *out = (float)( negative ? -value : value );
+    return p;
+}
+
+//! Returns true if the first token of \a line is a number, so that keywords
+//! like "3DMESH" are not mistaken for data.
+bool isNumeric( const Line & line )
+{
+    float v;
+    const char * next = parseFloat( line.begin, line.end, &v );
+    return next != line.begin && ( next == line.end || isspace( (unsigned char)*next ) );
+}
+
+//! Parses up to \a n floats from \a line, returning how many were read.
+int parseFloats( const Line & line, float * out, int n )
+{
+    const char * p = line.begin;
+    int i = 0;
+    for ( ; i < n; ++i ) {
+        const char * next = parseFloat( p, line.end, out + i );
+        if ( next == p ) break;
+        p = next;
+    }
+    return i;
+}
+
+int countFloats( const Line & line )
+{
+    int count = 0;
+    const char * p = line.begin;
+    for ( ;; ) {
+        float v;
+        const char * next = parseFloat( p, line.end, &v );
+        if ( next == p ) break;
+        ++count;
+        p = next;
+    }
+    return count;
+}
+
+//! Returns the bit depth of unsigned integers up to \a maxValue.
+int getBitDepth( float maxValue )
+{
+    int bits = 1;
+    while ( bits < 32 && maxValue > (float)( ( uint64_t( 1 ) << bits ) - 1 ) ) ++bits;
+    return bits;
+}
+
+string keyword( const Line & line )
+{
+    const char * e = line.begin;
+    while ( e < line.end && ! isspace( (unsigned char)*e ) ) ++e;
+    return string( line.begin, e );
+}
+
+Line afterKeyword( const Line & line )
+{
+    const char * p = line.begin;
+    while ( p < line.end && ! isspace( (unsigned char)*p ) ) ++p;
+    return { p, line.end };
+}
+
+//! Parses RGB triplets from \a lines[ first, first + count ) in parallel,
+//! storing each at the lattice index returned by \a index.
+template< typename IndexFn >
+void parseTriplets( const vector< Line > & lines, size_t first, size_t count, Lut3d & lut, IndexFn index )
+{
+    float * data = lut.getData().data();
+    atomic< size_t > badLine{ 0 };
+
+    ThreadPool::instance().parallelFor( count, PARSE_GRAIN, [&]( size_t begin, size_t end ) {
+        for ( size_t i = begin; i < end; ++i ) {
+            if ( parseFloats( lines[ first + i ], data + index( i ), 3 ) != 3 ) {
+                badLine = first + i + 1;
+            }
+        }
+    } );
+
+    if ( badLine ) {
+        throw LUTFileExc( "Malformed LUT entry on data line " + to_string( badLine ) );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Binary cache
+
+const char      CACHE_MAGIC[ 8 ] = { 'F', 'G', 'L', 'U', 'T', '3', 'D', '\0' };
+const uint32_t  CACHE_VERSION = 1;
+//! Larger lattices in a cache header are taken as corruption.
+const uint32_t  CACHE_MAX_SIZE = 256;
+
+struct CacheHeader {
+    char        magic[ 8 ];
+    uint32_t    version;
+    uint32_t    size;
+    uint64_t    sourceSize;
+    int64_t     sourceModified;
+    uint64_t    sourceHash;
+    float       domainMin[ 3 ];
+    float       domainMax[ 3 ];
+};
+
+struct FileStat {
+    uint64_t    size;
+    int64_t     modified;
+};
+
+bool statFile( const fs::path & path, FileStat * fileStat )
+{
+    struct stat st;
+    if ( ::stat( path.string().c_str(), &st ) != 0 ) return false;
+    fileStat->size = (uint64_t)st.st_size;
+    fileStat->modified = (int64_t)st.st_mtime;
+    return true;
+}
+
+// FNV-1a
+uint64_t hashBytes( const char * data, size_t size )
+{
+    uint64_t h = 14695981039346656037ULL;
+    for ( size_t i = 0; i < size; ++i ) {
+        h ^= (uint8_t)data[ i ];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+fs::path cachePathFor( const fs::path & path, const fs::path & cacheDirectory )
+{
+    string name = path.filename().string();
+    if ( cacheDirectory.empty() ) return path.parent_path() / ( name + ".lutcache" );
+
+    // disambiguate same-named LUTs from different directories
+    string source = fs::absolute( path ).string();
+    ostringstream os;
+    os << name << "." << hex << hashBytes( source.data(), source.size() ) << ".lutcache";
+    return cacheDirectory / os.str();
+}
+
+bool readCacheHeader( ifstream & in, CacheHeader * header )
+{
+    in.read( reinterpret_cast< char * >( header ), sizeof( CacheHeader ) );
+    return in && memcmp( header->magic, CACHE_MAGIC, sizeof( CACHE_MAGIC ) ) == 0 && header->version == CACHE_VERSION;
+}
+
+bool readCacheData( ifstream & in, const CacheHeader & header, Lut3d * lut )
+{
+    // check the header against the file before trusting it with an allocation
+    if ( header.size < 2 || header.size > CACHE_MAX_SIZE ) return false;
+    uint64_t bytes = (uint64_t)header.size * header.size * header.size * 3 * sizeof( float );
+    streampos start = in.tellg();
+    in.seekg( 0, ios::end );
+    streampos end = in.tellg();
+    in.seekg( start );
+    if ( ! in || start < 0 || (uint64_t)( end - start ) < bytes ) return false;
+
+    Lut3d result( (int)header.size );
+    auto & data = result.getData();
+    in.read( reinterpret_cast< char * >( data.data() ), data.size() * sizeof( float ) );
+    if ( ! in ) return false;
+
+    result.setDomain( vec3( header.domainMin[ 0 ], header.domainMin[ 1 ], header.domainMin[ 2 ] ),
+                      vec3( header.domainMax[ 0 ], header.domainMax[ 1 ], header.domainMax[ 2 ] ) );
+    *lut = move( result );
+    return true;
+}
+
+void writeCache( const fs::path & cachePath, const FileStat & fileStat, uint64_t hash, const Lut3d & lut )
+{
+    CacheHeader header;
+    memcpy( header.magic, CACHE_MAGIC, sizeof( CACHE_MAGIC ) );
+    header.version = CACHE_VERSION;
+    header.size = (uint32_t)lut.getSize();
+    header.sourceSize = fileStat.size;
+    header.sourceModified = fileStat.modified;
+    header.sourceHash = hash;
+    for ( int i = 0; i < 3; ++i ) {
+        header.domainMin[ i ] = lut.getDomainMin()[ i ];
+        header.domainMax[ i ] = lut.getDomainMax()[ i ];
+    }
+
+    // write to a temporary and rename, so a reader never sees a partial file
+    fs::path tmpPath = cachePath;
+    tmpPath += ".tmp";
+    {
+        ofstream out( tmpPath.string(), ios::binary | ios::trunc );
+        if ( ! out ) {
+            CI_LOG_W( "Unable to write LUT cache: " << cachePath );
+            return;
+        }
+        out.write( reinterpret_cast< const char * >( &header ), sizeof( header ) );
+        out.write( reinterpret_cast< const char * >( lut.getData().data() ), lut.getData().size() * sizeof( float ) );
+        out.close();
+        if ( ! out ) {
+            CI_LOG_W( "Unable to write LUT cache: " << cachePath );
+            std::remove( tmpPath.string().c_str() );
+            return;
+        }
+    }
+
+    try {
+        fs::rename( tmpPath, cachePath );
+    }
+    catch ( const std::exception & e ) {
+        CI_LOG_EXCEPTION( "Unable to write LUT cache: " << cachePath, e );
+        std::remove( tmpPath.string().c_str() );
+    }
+}
+
+string readText( const fs::path & path )
+{
+    ifstream in( path.string(), ios::binary );
+    if ( ! in ) throw LUTFileExc( "Unable to open LUT file: " + path.string() );
+    ostringstream os;
+    os << in.rdbuf();
+    return os.str();
+}
+
+Lut3d parseLut( const fs::path & path, const string & text )
+{
+    string ext = path.extension().string();
+    transform( ext.begin(), ext.end(), ext.begin(), ::tolower );
+
+    if ( ext == ".cube" ) return parseCubeLut( text );
+    if ( ext == ".3dl" ) return parse3dlLut( text );
+
+    throw LUTFileExc( "Unsupported LUT format: " + path.string() );
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Parsers
+
+Lut3d frame_graph::parseCubeLut( const string & text )
+{
+    vector< Line > lines = splitLines( text );
+
+    int size = 0;
+    vec3 domainMin( 0.f ), domainMax( 1.f );
+    size_t first = lines.size();
+
+    for ( size_t i = 0; i < lines.size(); ++i ) {
+        const Line & line = lines[ i ];
+        if ( isNumeric( line ) ) {
+            first = i;
+            break;
+        }
+
+        string key = keyword( line );
+        Line args = afterKeyword( line );
+        float v[ 3 ];
+
+        if ( key == "LUT_3D_SIZE" && parseFloats( args, v, 1 ) == 1 ) {
+            size = (int)v[ 0 ];
+        }
+        else if ( key == "LUT_1D_SIZE" ) {
+            throw LUTFileExc( "1D .cube LUTs are not supported" );
+        }
+        else if ( key == "DOMAIN_MIN" && parseFloats( args, v, 3 ) == 3 ) {
+            domainMin = vec3( v[ 0 ], v[ 1 ], v[ 2 ] );
+        }
+        else if ( key == "DOMAIN_MAX" && parseFloats( args, v, 3 ) == 3 ) {
+            domainMax = vec3( v[ 0 ], v[ 1 ], v[ 2 ] );
+        }
+        else if ( key == "LUT_3D_INPUT_RANGE" && parseFloats( args, v, 2 ) == 2 ) {
+            domainMin = vec3( v[ 0 ] );
+            domainMax = vec3( v[ 1 ] );
+        }
+    }
+
+    if ( size < 2 ) throw LUTFileExc( "Missing or invalid LUT_3D_SIZE" );
+
+    size_t count = (size_t)size * size * size;
+    if ( lines.size() - first != count ) {
+        throw LUTFileExc( "Expected " + to_string( count ) + " LUT entries, found " + to_string( lines.size() - first ) );
+    }
+
+    // red varies fastest, matching Lut3d
+    Lut3d lut( size );
+    lut.setDomain( domainMin, domainMax );
+    parseTriplets( lines, first, count, lut, []( size_t i ) { return 3 * i; } );
+    return lut;
+}
+
+Lut3d frame_graph::parse3dlLut( const string & text )
+{
+    vector< Line > lines = splitLines( text );
+
+    // skip keywords such as "3DMESH", reading the output bit depth from a
+    // "Mesh <input bits> <output bits>" header
+    int outputBits = 0;
+    size_t first = 0;
+    for ( ; first < lines.size() && ! isNumeric( lines[ first ] ); ++first ) {
+        float v[ 2 ];
+        if ( keyword( lines[ first ] ) == "Mesh" && parseFloats( afterKeyword( lines[ first ] ), v, 2 ) == 2 ) {
+            outputBits = (int)v[ 1 ];
+        }
+    }
+    if ( first == lines.size() ) throw LUTFileExc( "No LUT entries found" );
+
+    // an optional shaper line lists the input values of each lattice point,
+    // and is only ambiguous with an entry for a 3x3x3 LUT
+    int size = 0;
+    float shaperMax = 0.f;
+    int shaperCount = countFloats( lines[ first ] );
+    if ( shaperCount != 3 || lines.size() - first == 28 ) {
+        size = shaperCount;
+        vector< float > shaper( shaperCount );
+        parseFloats( lines[ first ], shaper.data(), shaperCount );
+        shaperMax = *max_element( shaper.begin(), shaper.end() );
+        ++first;
+    }
+
+    size_t count = lines.size() - first;
+    if ( size == 0 ) size = (int)std::round( std::cbrt( (double)count ) );
+    if ( size < 2 || (size_t)size * size * size != count ) {
+        throw LUTFileExc( "Expected a cube of LUT entries, found " + to_string( count ) );
+    }
+
+    // blue varies fastest
+    Lut3d lut( size );
+    size_t n = size;
+    parseTriplets( lines, first, count, lut, [n]( size_t i ) {
+        size_t r = i / ( n * n ), g = ( i / n ) % n, b = i % n;
+        return 3 * ( ( b * n + g ) * n + r );
+    } );
+
+    // entries are integers at the file's output bit depth. Without a Mesh
+    // header the shaper's range gives the depth, unless the entries exceed
+    // it, as for 10-bit in, 12-bit out LUTs. Only a file with neither is
+    // left to guess from its largest entry.
+    auto & data = lut.getData();
+    float maxValue = *max_element( data.begin(), data.end() );
+    int bits = outputBits;
+    if ( bits <= 0 && shaperMax > 1.f ) {
+        bits = getBitDepth( shaperMax );
+        if ( maxValue > (float)( ( uint64_t( 1 ) << bits ) - 1 ) ) bits = 0;
+    }
+    if ( bits <= 0 && maxValue > 1.f ) {
+        bits = 8;
+        while ( bits < 16 && maxValue > (float)( ( 1u << bits ) - 1 ) ) bits += 2;
+    }
+
+    if ( bits > 0 ) {
+        float scale = 1.f / (float)( ( uint64_t( 1 ) << std::min( bits, 32 ) ) - 1 );
+
+        ThreadPool::instance().parallelFor( data.size(), PARSE_GRAIN * 3, [&]( size_t begin, size_t end ) {
+            for ( size_t i = begin; i < end; ++i ) data[ i ] *= scale;
+        } );
+    }
+
+    return lut;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Loading
+
+Lut3d frame_graph::loadLut( const fs::path & path, const fs::path & cacheDirectory )
+{
+    FileStat fileStat;
+    if ( ! statFile( path, &fileStat ) ) throw LUTFileExc( "Unable to open LUT file: " + path.string() );
+
+    fs::path cachePath = cachePathFor( path, cacheDirectory );
+    ifstream cache( cachePath.string(), ios::binary );
+    CacheHeader header;
+    bool hasCache = cache && readCacheHeader( cache, &header );
+
+    // fast path, the source is unchanged so it does not need to be read at all
+    Lut3d lut;
+    if ( hasCache && header.sourceSize == fileStat.size && header.sourceModified == fileStat.modified ) {
+        if ( readCacheData( cache, header, &lut ) ) return lut;
+        hasCache = false;
+    }
+
+    string text = readText( path );
+    uint64_t hash = hashBytes( text.data(), text.size() );
+
+    // the source was touched or copied but its contents are the same
+    if ( hasCache && header.sourceSize == fileStat.size && header.sourceHash == hash && readCacheData( cache, header, &lut ) ) {
+        cache.close();
+        writeCache( cachePath, fileStat, hash, lut );
+        return lut;
+    }
+    cache.close();
+
+    lut = parseLut( path, text );
+    writeCache( cachePath, fileStat, hash, lut );
+    return lut;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// LUTFileINode
+
+LUTFileINode::LUTFileINode( const fs::path & path, const Format & format ) :
+mLut( make_shared< Lut3d >( loadLut( path, format.getCacheDirectory() ) ) )
+{
+    if ( format.hasTexture() ) mTexture = mLut->createTexture( format.getInternalFormat() );
+}
+
+void LUTFileINode::update()
+{
+    if ( mTexture ) out< 0 >().update( mTexture );
+    out< 1 >().update( mLut );
+}
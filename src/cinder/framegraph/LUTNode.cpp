@@ -1,4 +1,5 @@
 #include "cinder/framegraph/LUTNode.hpp"
+#include "cinder/Log.h"
 
 using namespace std;
 using namespace cinder;
@@ -21,69 +22,244 @@ void main( void ) {
 )EOF";
 
 
-// based on https://github.com/mattdesl/glsl-lut
-// (c) @mattdesl, MIT License
 static const string FRAG = R"EOF(
 #version 410
 
 uniform sampler2D   uTexSrc;
+#ifdef LUT_3D
+uniform sampler3D   uTexLUT;
+#else
 uniform sampler2D   uTexLUT;
+#endif
+uniform vec3        uLUTDomainMin;
+uniform vec3        uLUTDomainMax;
 
 in vec2 uv;
 out vec4 oColor;
 
-vec4 lookup( in vec4 textureColor, in sampler2D lookupTable ) {
-#ifndef LUT_NO_CLAMP
-    textureColor = clamp(textureColor, 0.0, 1.0);
-#endif
+const float N = float( LUT_SIZE );
 
-    mediump float blueColor = textureColor.b * 63.0;
+#ifdef LUT_3D
 
-    mediump vec2 quad1;
-    quad1.y = floor(floor(blueColor) / 8.0);
-    quad1.x = floor(blueColor) - (quad1.y * 8.0);
+vec3 fetchLattice( in ivec3 p )
+{
+    return texelFetch( uTexLUT, p, 0 ).rgb;
+}
 
-    mediump vec2 quad2;
-    quad2.y = floor(ceil(blueColor) / 8.0);
-    quad2.x = ceil(blueColor) - (quad2.y * 8.0);
+vec3 sampleTrilinear( in vec3 x )
+{
+    return texture( uTexLUT, ( x + 0.5 ) / N ).rgb;
+}
 
-    highp vec2 texPos1;
-    texPos1.x = (quad1.x * 0.125) + 0.5/512.0 + ((0.125 - 1.0/512.0) * textureColor.r);
-    texPos1.y = (quad1.y * 0.125) + 0.5/512.0 + ((0.125 - 1.0/512.0) * textureColor.g);
+#else
 
+vec3 fetchLattice( in ivec3 p )
+{
+    ivec2 atlasSize = textureSize( uTexLUT, 0 );
+    int columns = atlasSize.x / LUT_SIZE;
+    ivec2 t = ivec2( ( p.b % columns ) * LUT_SIZE + p.r, ( p.b / columns ) * LUT_SIZE + p.g );
 #ifdef LUT_FLIP_Y
-    texPos1.y = 1.0-texPos1.y;
+    t.y = atlasSize.y - 1 - t.y;
 #endif
+    return texelFetch( uTexLUT, t, 0 ).rgb;
+}
+
+// based on https://github.com/mattdesl/glsl-lut
+// (c) @mattdesl, MIT License
+vec3 sampleTrilinear( in vec3 x )
+{
+    vec2 atlasSize = vec2( textureSize( uTexLUT, 0 ) );
+    float columns = floor( atlasSize.x / N );
+    vec2 tile = N / atlasSize;
+    vec2 texel = 1.0 / atlasSize;
+    vec2 rg = x.rg / ( N - 1.0 );
+
+    vec2 quad1;
+    quad1.y = floor( floor( x.b ) / columns );
+    quad1.x = floor( x.b ) - ( quad1.y * columns );
 
-    highp vec2 texPos2;
-    texPos2.x = (quad2.x * 0.125) + 0.5/512.0 + ((0.125 - 1.0/512.0) * textureColor.r);
-    texPos2.y = (quad2.y * 0.125) + 0.5/512.0 + ((0.125 - 1.0/512.0) * textureColor.g);
+    vec2 quad2;
+    quad2.y = floor( ceil( x.b ) / columns );
+    quad2.x = ceil( x.b ) - ( quad2.y * columns );
+
+    vec2 texPos1 = quad1 * tile + 0.5 * texel + ( tile - texel ) * rg;
+    vec2 texPos2 = quad2 * tile + 0.5 * texel + ( tile - texel ) * rg;
 
 #ifdef LUT_FLIP_Y
-    texPos2.y = 1.0-texPos2.y;
+    texPos1.y = 1.0 - texPos1.y;
+    texPos2.y = 1.0 - texPos2.y;
+#endif
+
+    return mix( texture( uTexLUT, texPos1 ).rgb, texture( uTexLUT, texPos2 ).rgb, fract( x.b ) );
+}
+
 #endif
 
-    lowp vec4 newColor1 = texture(lookupTable, texPos1);
-    lowp vec4 newColor2 = texture(lookupTable, texPos2);
+vec3 sampleTetrahedral( in vec3 x )
+{
+    vec3 i0 = clamp( floor( x ), 0.0, N - 2.0 );
+    vec3 f = x - i0;
+    ivec3 p0 = ivec3( i0 );
+    ivec3 p1 = p0 + ivec3( 1 );
+
+    vec3 c000 = fetchLattice( p0 );
+    vec3 c111 = fetchLattice( p1 );
 
-    lowp vec4 newColor = mix(newColor1, newColor2, fract(blueColor));
-    return newColor;
+    if ( f.r > f.g ) {
+        if ( f.g > f.b ) {
+            return ( 1.0 - f.r ) * c000 + ( f.r - f.g ) * fetchLattice( ivec3( p1.r, p0.g, p0.b ) ) + ( f.g - f.b ) * fetchLattice( ivec3( p1.r, p1.g, p0.b ) ) + f.b * c111;
+        }
+        else if ( f.r > f.b ) {
+            return ( 1.0 - f.r ) * c000 + ( f.r - f.b ) * fetchLattice( ivec3( p1.r, p0.g, p0.b ) ) + ( f.b - f.g ) * fetchLattice( ivec3( p1.r, p0.g, p1.b ) ) + f.g * c111;
+        }
+        else {
+            return ( 1.0 - f.b ) * c000 + ( f.b - f.r ) * fetchLattice( ivec3( p0.r, p0.g, p1.b ) ) + ( f.r - f.g ) * fetchLattice( ivec3( p1.r, p0.g, p1.b ) ) + f.g * c111;
+        }
+    }
+    else {
+        if ( f.b > f.g ) {
+            return ( 1.0 - f.b ) * c000 + ( f.b - f.g ) * fetchLattice( ivec3( p0.r, p0.g, p1.b ) ) + ( f.g - f.r ) * fetchLattice( ivec3( p0.r, p1.g, p1.b ) ) + f.r * c111;
+        }
+        else if ( f.b > f.r ) {
+            return ( 1.0 - f.g ) * c000 + ( f.g - f.b ) * fetchLattice( ivec3( p0.r, p1.g, p0.b ) ) + ( f.b - f.r ) * fetchLattice( ivec3( p0.r, p1.g, p1.b ) ) + f.r * c111;
+        }
+        else {
+            return ( 1.0 - f.g ) * c000 + ( f.g - f.r ) * fetchLattice( ivec3( p0.r, p1.g, p0.b ) ) + ( f.r - f.b ) * fetchLattice( ivec3( p1.r, p1.g, p0.b ) ) + f.b * c111;
+        }
+    }
+}
+
+vec3 lookup( in vec3 c )
+{
+    c = ( c - uLUTDomainMin ) / ( uLUTDomainMax - uLUTDomainMin );
+#ifndef LUT_NO_CLAMP
+    c = clamp( c, 0.0, 1.0 );
+#endif
+    vec3 x = c * ( N - 1.0 );
+
+#ifdef LUT_TETRAHEDRAL
+    return sampleTetrahedral( x );
+#else
+    return sampleTrilinear( x );
+#endif
 }
 
 void main() {
     vec4 c_src = texture( uTexSrc, uv );
-    vec4 c_lut = lookup( c_src, uTexLUT );
-    oColor = c_lut;
+    oColor = vec4( lookup( c_src.rgb ), c_src.a );
 }
 )EOF";
 
-LUTNode::LUTNode( const ivec2 & size ) :
-TextureShaderIONode( gl::GlslProg::create( gl::GlslProg::Format()
-                                           .fragment( FRAG )
-                                           .vertex( VERT )
-                                           .define( "LUT_FLIP_Y" )
-                                         ), size )
+static gl::GlslProg::Format shaderFormat( const LUTNode::Format & format )
+{
+    auto fmt = gl::GlslProg::Format()
+            .fragment( FRAG )
+            .vertex( VERT )
+            .define( "LUT_SIZE", to_string( format.getSize() ) );
+
+    if ( format.isTexture3d() ) fmt.define( "LUT_3D" );
+    else                        fmt.define( "LUT_FLIP_Y" );
+
+    if ( format.getInterpolation() == LUTNode::Interpolation::TETRAHEDRAL ) fmt.define( "LUT_TETRAHEDRAL" );
+
+    return fmt;
+}
+
+LUTNode::LUTNode( const ivec2 & size, const Format & format ) :
+FullScreenQuadRenderer< 2 >( shaderFormat( format ), size ),
+mFormat( format )
 {
     setTextureName( 0, "uTexSrc" );
     setTextureName( 1, "uTexLUT" );
+    setUniform( "uLUTDomainMin", vec3( 0.f ) );
+    setUniform( "uLUTDomainMax", vec3( 1.f ) );
+    if ( mFormat.isTexture3d() ) setUniform( "uTexLUT", 1 );
+
+    in< 0 >().onReceive( [&]( const gl::Texture2dRef & tex ) {
+        updateSource( tex );
+    } );
+    in< 1 >().onReceive( [&]( const gl::Texture2dRef & tex ) {
+        updateAtlas( tex );
+    } );
+    in< 2 >().onReceive( [&]( const Lut3dRef & lut ) {
+        // LUT sources re-emit the same LUT every frame, so only upload new ones
+        if ( ! lut || lut == mReceived ) return;
+        mReceived = lut;
+        setLUT( *lut );
+    } );
+}
+
+void LUTNode::setLUT( const Lut3d & lut )
+{
+    if ( ! mFormat.isTexture3d() ) {
+        CI_LOG_W( "LUTNode::setLUT requires a 3D texture format" );
+        return;
+    }
+
+    if ( lut.getSize() != mFormat.getSize() ) {
+        CI_LOG_W( "LUT size " << lut.getSize() << " does not match LUTNode size " << mFormat.getSize() );
+        return;
+    }
+
+    setLUT( lut.createTexture( mFormat.getInternalFormat() ), lut.getDomainMin(), lut.getDomainMax() );
+}
+
+void LUTNode::setLUT( const gl::Texture3dRef & lut, const vec3 & domainMin, const vec3 & domainMax )
+{
+    if ( ! mFormat.isTexture3d() ) {
+        CI_LOG_W( "LUTNode::setLUT requires a 3D texture format" );
+        return;
+    }
+
+    // the shader's lattice size is compiled in
+    int size = mFormat.getSize();
+    if ( lut && ( lut->getWidth() != size || lut->getHeight() != size || lut->getDepth() != size ) ) {
+        CI_LOG_W( "LUT texture size " << lut->getWidth() << "x" << lut->getHeight() << "x" << lut->getDepth() << " does not match LUTNode size " << size );
+        return;
+    }
+
+    if ( lut == mLUT3d && domainMin == mDomainMin && domainMax == mDomainMax ) return;
+    mLUT3d = lut;
+    mDomainMin = domainMin;
+    mDomainMax = domainMax;
+    setUniform( "uLUTDomainMin", domainMin );
+    setUniform( "uLUTDomainMax", domainMax );
+    if ( mSource && mLUT3d ) update();
+}
+
+void LUTNode::updateSource( const gl::Texture2dRef & texture )
+{
+    mSource = texture;
+    setTexture( 0, texture );
+    if ( hasLUT() ) update();
+}
+
+void LUTNode::updateAtlas( const gl::Texture2dRef & atlas )
+{
+    // atlas sources usually re-emit the same texture every frame, so only
+    // re-render (and, for 3D LUTs, re-convert) when it actually changes
+    if ( atlas == mAtlas ) return;
+    mAtlas = atlas;
+
+    if ( mFormat.isTexture3d() ) {
+        Surface32f surface( atlas->createSource() );
+        setLUT( Lut3d::createFromAtlas( surface, mFormat.getSize() ) );
+        return;
+    }
+
+    setTexture( 1, atlas );
+    if ( mSource ) update();
+}
+
+void LUTNode::update()
+{
+    out< 0 >().update( render() );
+}
+
+gl::Texture2dRef LUTNode::render()
+{
+    if ( ! mFormat.isTexture3d() ) return FullScreenQuadRenderer< 2 >::render();
+
+    gl::ScopedTextureBind scp_lut( mLUT3d, 1 );
+    return FullScreenQuadRenderer< 2 >::render();
 }
@@ -0,0 +1,200 @@
+#include "cinder/framegraph/Lut.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+
+//! Clamps to [0, 1], mapping NaN to 0. glm::clamp passes NaN through, and
+//! casting it to a lattice index is undefined.
+vec3 clampUnit( const vec3 & x )
+{
+    vec3 c( x.r == x.r ? x.r : 0.f, x.g == x.g ? x.g : 0.f, x.b == x.b ? x.b : 0.f );
+    return glm::clamp( c, vec3( 0.f ), vec3( 1.f ) );
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Lut3d
+
+Lut3d Lut3d::createIdentity( int size )
+{
+    Lut3d lut( size );
+    float scale = 1.f / (float)( size - 1 );
+    for ( int b = 0; b < size; ++b ) {
+        for ( int g = 0; g < size; ++g ) {
+            for ( int r = 0; r < size; ++r ) {
+                lut.set( r, g, b, vec3( r, g, b ) * scale );
+            }
+        }
+    }
+    return lut;
+}
+
+Lut3d Lut3d::createFromAtlas( const Surface32f & atlas, int size )
+{
+    Lut3d lut( size );
+    int columns = std::max( 1, atlas.getWidth() / size );
+    for ( int b = 0; b < size; ++b ) {
+        ivec2 origin( ( b % columns ) * size, ( b / columns ) * size );
+        for ( int g = 0; g < size; ++g ) {
+            for ( int r = 0; r < size; ++r ) {
+                ColorAf c = atlas.getPixel( origin + ivec2( r, g ) );
+                lut.set( r, g, b, vec3( c.r, c.g, c.b ) );
+            }
+        }
+    }
+    return lut;
+}
+
+Lut3d::Lut3d( int size ) :
+mSize( size ),
+mData( 3 * (size_t)size * size * size, 0.f )
+{
+}
+
+Lut3d::Lut3d( int size, vector< float > data ) :
+mSize( size ),
+mData( move( data ) )
+{
+    CI_ASSERT( mData.size() == 3 * (size_t)size * size * size );
+}
+
+vec3 Lut3d::toLattice( const vec3 & c ) const
+{
+    return clampUnit( ( c - mDomainMin ) / ( mDomainMax - mDomainMin ) ) * (float)( mSize - 1 );
+}
+
+vec3 Lut3d::lookup( const vec3 & c, Interpolation interpolation ) const
+{
+    return interpolation == Interpolation::TETRAHEDRAL ? lookupTetrahedral( c ) : lookupTrilinear( c );
+}
+
+vec3 Lut3d::lookupTrilinear( const vec3 & c ) const
+{
+    vec3 x = toLattice( c );
+    ivec3 i0 = glm::min( ivec3( glm::floor( x ) ), ivec3( mSize - 2 ) );
+    ivec3 i1 = i0 + ivec3( 1 );
+    vec3 f = x - vec3( i0 );
+
+    vec3 c00 = glm::mix( at( i0.r, i0.g, i0.b ), at( i1.r, i0.g, i0.b ), f.r );
+    vec3 c10 = glm::mix( at( i0.r, i1.g, i0.b ), at( i1.r, i1.g, i0.b ), f.r );
+    vec3 c01 = glm::mix( at( i0.r, i0.g, i1.b ), at( i1.r, i0.g, i1.b ), f.r );
+    vec3 c11 = glm::mix( at( i0.r, i1.g, i1.b ), at( i1.r, i1.g, i1.b ), f.r );
+
+    return glm::mix( glm::mix( c00, c10, f.g ), glm::mix( c01, c11, f.g ), f.b );
+}
+
+vec3 Lut3d::lookupTetrahedral( const vec3 & c ) const
+{
+    vec3 x = toLattice( c );
+    ivec3 i0 = glm::min( ivec3( glm::floor( x ) ), ivec3( mSize - 2 ) );
+    ivec3 i1 = i0 + ivec3( 1 );
+    vec3 f = x - vec3( i0 );
+
+    // Split the cube into six tetrahedra along its main diagonal and
+    // interpolate between the four corners of the one containing f.
+    vec3 c000 = at( i0.r, i0.g, i0.b );
+    vec3 c111 = at( i1.r, i1.g, i1.b );
+
+    if ( f.r > f.g ) {
+        if ( f.g > f.b ) {
+            return ( 1.f - f.r ) * c000 + ( f.r - f.g ) * at( i1.r, i0.g, i0.b ) + ( f.g - f.b ) * at( i1.r, i1.g, i0.b ) + f.b * c111;
+        }
+        else if ( f.r > f.b ) {
+            return ( 1.f - f.r ) * c000 + ( f.r - f.b ) * at( i1.r, i0.g, i0.b ) + ( f.b - f.g ) * at( i1.r, i0.g, i1.b ) + f.g * c111;
+        }
+        else {
+            return ( 1.f - f.b ) * c000 + ( f.b - f.r ) * at( i0.r, i0.g, i1.b ) + ( f.r - f.g ) * at( i1.r, i0.g, i1.b ) + f.g * c111;
+        }
+    }
+    else {
+        if ( f.b > f.g ) {
+            return ( 1.f - f.b ) * c000 + ( f.b - f.g ) * at( i0.r, i0.g, i1.b ) + ( f.g - f.r ) * at( i0.r, i1.g, i1.b ) + f.r * c111;
+        }
+        else if ( f.b > f.r ) {
+            return ( 1.f - f.g ) * c000 + ( f.g - f.b ) * at( i0.r, i1.g, i0.b ) + ( f.b - f.r ) * at( i0.r, i1.g, i1.b ) + f.r * c111;
+        }
+        else {
+            return ( 1.f - f.g ) * c000 + ( f.g - f.r ) * at( i0.r, i1.g, i0.b ) + ( f.r - f.b ) * at( i1.r, i1.g, i0.b ) + f.b * c111;
+        }
+    }
+}
+
+void Lut3d::apply( Surface32f & surface, Interpolation interpolation ) const
+{
+    uint8_t inc = surface.getPixelInc();
+    uint8_t ro = surface.getRedOffset();
+    uint8_t go = surface.getGreenOffset();
+    uint8_t bo = surface.getBlueOffset();
+
+    for ( int32_t y = 0; y < surface.getHeight(); ++y ) {
+        float * p = surface.getData( ivec2( 0, y ) );
+        for ( int32_t x = 0; x < surface.getWidth(); ++x, p += inc ) {
+            vec3 c = lookup( vec3( p[ ro ], p[ go ], p[ bo ] ), interpolation );
+            p[ ro ] = c.r; p[ go ] = c.g; p[ bo ] = c.b;
+        }
+    }
+}
+
+gl::Texture3dRef Lut3d::createTexture( GLint internalFormat ) const
+{
+    gl::Texture3d::Format fmt;
+    fmt.minFilter( GL_LINEAR ).magFilter( GL_LINEAR ).wrap( GL_CLAMP_TO_EDGE );
+    fmt.setDataType( GL_FLOAT );
+    fmt.setInternalFormat( internalFormat );
+    return gl::Texture3d::create( mData.data(), GL_RGB, mSize, mSize, mSize, fmt );
+}
+
+void Lut3d::updateTexture( const gl::Texture3dRef & texture ) const
+{
+    texture->update( mData.data(), GL_RGB, GL_FLOAT, 0, mSize, mSize, mSize );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Lut1d
+
+Lut1d::Lut1d( int size ) :
+mSize( size ),
+mData( 3 * (size_t)size, 0.f )
+{
+}
+
+Lut1d::Lut1d( int size, vector< float > data ) :
+mSize( size ),
+mData( move( data ) )
+{
+    CI_ASSERT( mData.size() == 3 * (size_t)size );
+}
+
+vec3 Lut1d::lookup( const vec3 & c ) const
+{
+    vec3 x = clampUnit( ( c - mDomainMin ) / ( mDomainMax - mDomainMin ) ) * (float)( mSize - 1 );
+    vec3 o;
+    for ( int i = 0; i < 3; ++i ) {
+        int i0 = std::min( (int)x[ i ], mSize - 2 );
+        float f = x[ i ] - (float)i0;
+        o[ i ] = glm::mix( mData[ 3 * i0 + i ], mData[ 3 * ( i0 + 1 ) + i ], f );
+    }
+    return o;
+}
+
+void Lut1d::apply( Surface32f & surface ) const
+{
+    uint8_t inc = surface.getPixelInc();
+    uint8_t ro = surface.getRedOffset();
+    uint8_t go = surface.getGreenOffset();
+    uint8_t bo = surface.getBlueOffset();
+
+    for ( int32_t y = 0; y < surface.getHeight(); ++y ) {
+        float * p = surface.getData( ivec2( 0, y ) );
+        for ( int32_t x = 0; x < surface.getWidth(); ++x, p += inc ) {
+            vec3 c = lookup( vec3( p[ ro ], p[ go ], p[ bo ] ) );
+            p[ ro ] = c.r; p[ go ] = c.g; p[ bo ] = c.b;
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "cinder/framegraph/OCIO.hpp"
+#include "cinder/framegraph/SurfacePool.hpp"
 #include "cinder/Log.h"
 
 using namespace ci;
@@ -57,11 +58,20 @@ mConfig( config )
 
 void ProcessIONode::update( const Surface32fRef & image )
 {
-	core::PackedImageDesc pid( image->getData(), image->getWidth(), image->getHeight(), image->hasAlpha() ? 4 : 3 );
+	// processes a pooled copy rather than the input, which other nodes may
+	// hold, reusing the last output unless something downstream kept it
+	if ( ! mOutput || mOutput.use_count() > 1 || mOutput->getSize() != image->getSize() || mOutput->hasAlpha() != image->hasAlpha() ) {
+		mOutput = SurfacePool::instance().get( image->getWidth(), image->getHeight(), image->hasAlpha() );
+	}
+	mOutput->copyFrom( *image, image->getBounds() );
+
+	int channels = mOutput->hasAlpha() ? 4 : 3;
+	core::PackedImageDesc pid( mOutput->getData(), mOutput->getWidth(), mOutput->getHeight(), channels,
+							   sizeof( float ), channels * sizeof( float ), mOutput->getRowBytes() );
 
 	mProcessor->apply( pid );
 
-	out< 0 >().update( image );
+	out< 0 >().update( mOutput );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -69,7 +79,6 @@ void ProcessIONode::update( const Surface32fRef & image )
 
 static const std::string FRAG_SHADER_HEADER =
 CI_GLSL(150,
-		vec4 texture3D( sampler3D s, vec3 p ) { return texture(s, p); }
 		vec4 texture2D( sampler2D s, vec2 p ) { return texture(s, p); }
 		uniform RAW_SAMPLER uRawTex;
 		uniform sampler3D uLUTTex;
@@ -78,6 +87,42 @@ CI_GLSL(150,
 		out vec4 oColor;
 		);
 
+// OCIO samples its LUT through texture3D(), so interpolation is selected by
+// swapping in one of these definitions.
+static const std::string FRAG_SHADER_LUT_TRILINEAR = R"EOF(
+vec4 texture3D( sampler3D s, vec3 p ) { return texture( s, p ); }
+)EOF";
+
+static const std::string FRAG_SHADER_LUT_TETRAHEDRAL = R"EOF(
+vec4 texture3D( sampler3D s, vec3 p )
+{
+	int n = textureSize( s, 0 ).x;
+	// OCIO offsets by half a texel, undo that to get lattice coordinates
+	vec3 x = clamp( p * float( n ) - 0.5, 0.0, float( n - 1 ) );
+	vec3 i0 = min( floor( x ), float( n - 2 ) );
+	vec3 f = x - i0;
+	ivec3 p0 = ivec3( i0 );
+	ivec3 p1 = p0 + ivec3( 1 );
+
+	vec3 c000 = texelFetch( s, p0, 0 ).rgb;
+	vec3 c111 = texelFetch( s, p1, 0 ).rgb;
+	vec3 c;
+
+	if ( f.r > f.g ) {
+		if ( f.g > f.b )		c = ( 1.0 - f.r ) * c000 + ( f.r - f.g ) * texelFetch( s, ivec3( p1.r, p0.g, p0.b ), 0 ).rgb + ( f.g - f.b ) * texelFetch( s, ivec3( p1.r, p1.g, p0.b ), 0 ).rgb + f.b * c111;
+		else if ( f.r > f.b )	c = ( 1.0 - f.r ) * c000 + ( f.r - f.b ) * texelFetch( s, ivec3( p1.r, p0.g, p0.b ), 0 ).rgb + ( f.b - f.g ) * texelFetch( s, ivec3( p1.r, p0.g, p1.b ), 0 ).rgb + f.g * c111;
+		else					c = ( 1.0 - f.b ) * c000 + ( f.b - f.r ) * texelFetch( s, ivec3( p0.r, p0.g, p1.b ), 0 ).rgb + ( f.r - f.g ) * texelFetch( s, ivec3( p1.r, p0.g, p1.b ), 0 ).rgb + f.g * c111;
+	}
+	else {
+		if ( f.b > f.g )		c = ( 1.0 - f.b ) * c000 + ( f.b - f.g ) * texelFetch( s, ivec3( p0.r, p0.g, p1.b ), 0 ).rgb + ( f.g - f.r ) * texelFetch( s, ivec3( p0.r, p1.g, p1.b ), 0 ).rgb + f.r * c111;
+		else if ( f.b > f.r )	c = ( 1.0 - f.g ) * c000 + ( f.g - f.b ) * texelFetch( s, ivec3( p0.r, p1.g, p0.b ), 0 ).rgb + ( f.b - f.r ) * texelFetch( s, ivec3( p0.r, p1.g, p1.b ), 0 ).rgb + f.r * c111;
+		else					c = ( 1.0 - f.g ) * c000 + ( f.g - f.r ) * texelFetch( s, ivec3( p0.r, p1.g, p0.b ), 0 ).rgb + ( f.r - f.b ) * texelFetch( s, ivec3( p1.r, p1.g, p0.b ), 0 ).rgb + f.b * c111;
+	}
+
+	return vec4( c, 1.0 );
+}
+)EOF";
+
 static const std::string FRAG_SHADER_MAIN =
 CI_GLSL(150,
 		void main()
@@ -110,6 +155,9 @@ mConfig( config )
 	mCSView = mConfig->getDefaultView( mCSDisplay.c_str() );
 
 	mProcessorNeedsUpdate = true;
+
+	// scene-linear input goes above 1
+	setInputPrecision( Precision::HDR_HALF );
 }
 
 void ProcessGPUIONode::setInputColorSpace( const string &inputName )
@@ -141,6 +189,25 @@ void ProcessGPUIONode::setExposureFStop( float exposure )
 	mProcessorNeedsUpdate = true;
 }
 
+void ProcessGPUIONode::setLUTSize( int size )
+{
+	if ( size == mLUTSize ) return;
+	mLUTSize = size;
+	mLUTTex = nullptr;
+	mProcessorNeedsUpdate = true;
+}
+void ProcessGPUIONode::setLUTInternalFormat( GLint internalFormat )
+{
+	if ( internalFormat == mLUTInternalFormat ) return;
+	mLUTInternalFormat = internalFormat;
+	mLUTTex = nullptr;
+	mProcessorNeedsUpdate = true;
+}
+void ProcessGPUIONode::setLUTInterpolation( Lut3d::Interpolation interpolation )
+{
+	mLUTInterpolation = interpolation;
+}
+
 void ProcessGPUIONode::updateProcessor()
 {
 	if ( ! mProcessorNeedsUpdate ) return;
@@ -199,64 +266,67 @@ void ProcessGPUIONode::updateProcessor()
 
 	// Compute the LUT and store it in a texture.
 
-	static const int sSize = 32;
-
 	mShaderDesc.setLanguage( core::GPU_LANGUAGE_GLSL_1_3 );
 	mShaderDesc.setFunctionName( "OCIODisplay" );
-	mShaderDesc.setLut3DEdgeLen( sSize );
+	mShaderDesc.setLut3DEdgeLen( mLUTSize );
 
-	int num3Dentries = 3 * sSize * sSize * sSize;
-	vector< float > g_lut3d;
-	g_lut3d.resize(num3Dentries);
-	mProcessor->getGpuLut3D( &g_lut3d[0], mShaderDesc );
+	Lut3d lut( mLUTSize );
+	mProcessor->getGpuLut3D( lut.getData().data(), mShaderDesc );
 
 	{
 		if ( mLUTTex ) {
-			mLUTTex->update( g_lut3d.data(), GL_RGB, GL_FLOAT, 0, sSize, sSize, sSize );
+			lut.updateTexture( mLUTTex );
 		} else {
-			gl::Texture3d::Format fmt;
-			fmt.minFilter( GL_LINEAR ).magFilter( GL_LINEAR ).wrap( GL_CLAMP_TO_EDGE );
-			fmt.setDataType( GL_FLOAT );
-			fmt.setInternalFormat( GL_RGB16F_ARB );
-			mLUTTex = gl::Texture3d::create( g_lut3d.data(), GL_RGB, sSize, sSize, sSize, fmt );
+			mLUTTex = lut.createTexture( mLUTInternalFormat );
 		}
 	}
 
 
 	mProcessorNeedsUpdate = false;
+	mBatchNeedsUpdate = true;
 }
 
 
 void ProcessGPUIONode::updateBatch( const BatchFormat & fmt )
 {
-	if ( mBatchFormat == fmt ) return;
-	mBatchFormat = fmt;
+	if ( ! ( mBatchFormat == fmt ) || mBatchNeedsUpdate ) {
+		// a batch for another sampler type can't draw this texture, wait for
+		// the new program then; otherwise keep drawing with the last one
+		if ( mBatchFormat.getTextureTarget() != fmt.getTextureTarget() ) mBatch = nullptr;
+		mBatchFormat = fmt;
+		mBatchNeedsUpdate = false;
 
 
-	std::ostringstream os;
-	os << FRAG_SHADER_HEADER << mProcessor->getGpuShaderText( mShaderDesc ) << FRAG_SHADER_MAIN;
+		std::ostringstream os;
+		os << FRAG_SHADER_HEADER;
+		os << ( mBatchFormat.getLUTInterpolation() == Lut3d::Interpolation::TETRAHEDRAL ? FRAG_SHADER_LUT_TETRAHEDRAL : FRAG_SHADER_LUT_TRILINEAR );
+		os << mProcessor->getGpuShaderText( mShaderDesc ) << FRAG_SHADER_MAIN;
 
-	gl::GlslProg::Format shaderFmt;
-	shaderFmt.vertex( VERT_SHADER ).fragment( os.str() );
+		gl::GlslProg::Format shaderFmt;
+		shaderFmt.vertex( VERT_SHADER ).fragment( os.str() );
 
-	string sampler( "sampler2D" );
-	if ( mBatchFormat.getTextureTarget() == GL_TEXTURE_RECTANGLE_ARB )
-		sampler = "sampler2DRect";
+		string sampler( "sampler2D" );
+		if ( mBatchFormat.getTextureTarget() == GL_TEXTURE_RECTANGLE_ARB )
+			sampler = "sampler2DRect";
 
-	shaderFmt.define( "RAW_SAMPLER", sampler );
+		shaderFmt.define( "RAW_SAMPLER", sampler );
 
+		// compiles in the background and through the binary cache, shared
+		// with any other node generating the same shader
+		mProgram = ProgramRegistry::instance().get( shaderFmt );
+		mProgramChanged = true;
+	}
 
-	auto shader = gl::GlslProg::create( shaderFmt );
-	shader->uniform( "uRawTex", 0 );
-	shader->uniform( "uLUTTex", 1 );
 
-	vec2 texCoordScale( 1.f, 1.f );
-	if ( mBatchFormat.getTextureTarget() == GL_TEXTURE_RECTANGLE_ARB )
-		texCoordScale = mBatchFormat.getTextureSize();
+	mProgram->update();
+	if ( mBatch && ! mProgramChanged && mProgram->getVersion() == mProgramVersion ) return;
 
-	shader->uniform( "uTexCoordScale", texCoordScale );
+	const GlslProgFuture & program = mProgram->getProgram();
+	if ( mBatch && program.wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready ) return;
 
-	mBatch = gl::Batch::create( geom::Rect(), shader );
+	mProgramVersion = mProgram->getVersion();
+	mProgramChanged = false;
+	mBatch = gl::Batch::create( geom::Rect(), program.get() );
 }
 
 void ProcessGPUIONode::update( const gl::Texture2dRef & texture )
@@ -265,12 +335,16 @@ void ProcessGPUIONode::update( const gl::Texture2dRef & texture )
 	if ( ! mProcessor ) return;
 
 
-	if ( ! mFbo || mFbo->getWidth() != texture->getWidth() || mFbo->getHeight() != texture->getHeight() ) {
-		mFbo = gl::Fbo::create( texture->getWidth(), texture->getHeight() );
+	ivec2 fullSize = ProxyScale::instance().getFullSize( texture );
+	ivec2 size = ProxyScale::instance().getScaledSize( fullSize );
+
+	if ( ! mFbo || mFbo->getSize() != size
+		|| mFbo->getColorTexture()->getInternalFormat() != getInternalFormat( getOutputFormat() ) ) {
+		mFbo = gl::Fbo::create( size.x, size.y, getFboFormat( getOutputFormat() ) );
 		mModelMatrix = scale( vec3( mFbo->getSize(), 1.f ) ) * translate( vec3( 0.5f, 0.5f, 0.f ) );
 	}
 
-	updateBatch( BatchFormat().textureTarget( texture->getTarget() ).textureSize( texture->getSize() ) );
+	updateBatch( BatchFormat().textureTarget( texture->getTarget() ).textureSize( texture->getSize() ).lutInterpolation( mLUTInterpolation ) );
 
 	{
 		gl::ScopedFramebuffer scp_fbo( mFbo );
@@ -283,9 +357,20 @@ void ProcessGPUIONode::update( const gl::Texture2dRef & texture )
 		gl::multModelMatrix( mModelMatrix );
 		gl::clear();
 
+		// the program may be shared, so set uniforms on every draw
+		auto shader = mBatch->getGlslProg();
+		shader->uniform( "uRawTex", 0 );
+		shader->uniform( "uLUTTex", 1 );
+
+		vec2 texCoordScale( 1.f, 1.f );
+		if ( mBatchFormat.getTextureTarget() == GL_TEXTURE_RECTANGLE_ARB )
+			texCoordScale = mBatchFormat.getTextureSize();
+		shader->uniform( "uTexCoordScale", texCoordScale );
+
 		mBatch->draw();
 	}
 
+	ProxyScale::instance().registerTexture( mFbo->getColorTexture(), fullSize );
 	TextureIONode::update( mFbo->getColorTexture() );
 }
 
@@ -0,0 +1,123 @@
+#include "cinder/framegraph/PresentationClock.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace cinder;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+
+//! How quickly the render estimate follows the measured render times.
+const double RENDER_SMOOTHING = 0.1;
+//! How quickly the vsync phase follows vsync-locked frame starts.
+const double PHASE_SMOOTHING = 0.05;
+//! Frame-start intervals within this many periods of a whole number are
+//! taken as vsync-locked and steer the phase.
+const double LOCK_TOLERANCE = 0.15;
+//! How far, in periods, a frame must land beyond the vsync after the
+//! previous frame's before it repeats or drops, so timer jitter around a
+//! boundary doesn't alternate between the two.
+const double HYSTERESIS = 0.25;
+
+//! Returns \a x wrapped to [-period / 2, period / 2).
+double wrap( double x, double period )
+{
+    return x - period * floor( x / period + 0.5 );
+}
+
+}
+
+PresentationClock & PresentationClock::instance()
+{
+    static PresentationClock presentationClock;
+    return presentationClock;
+}
+
+PresentationClock::PresentationClock( const Format & format ) :
+        mFormat( format )
+{
+    start();
+}
+
+void PresentationClock::start()
+{
+    mStart = clock::now();
+    mBeginTime = 0.0;
+    mPhase = 0.0;
+    mVsync = 0;
+    mAdvance = 0;
+    mFirst = true;
+    mRenderEstimate = 0.0;
+    mRenderTotal = 0.0;
+    mStats = Stats();
+}
+
+double PresentationClock::now() const
+{
+    return chrono::duration< double >( clock::now() - mStart ).count();
+}
+
+void PresentationClock::beginFrame()
+{
+    double previousBegin = mBeginTime;
+    mBeginTime = now();
+    double period = getPeriod();
+
+    // a vsync-locked loop starts its frames at a fixed offset from the
+    // display's vsync, so frame starts that are a whole number of periods
+    // apart pull the grid onto that phase
+    if ( mFirst ) {
+        mPhase = fmod( mBeginTime, period );
+    }
+    else {
+        double interval = ( mBeginTime - previousBegin ) / period;
+        if ( interval > 0.5 && std::abs( interval - round( interval ) ) < LOCK_TOLERANCE ) {
+            mPhase += PHASE_SMOOTHING * wrap( mBeginTime - mPhase, period );
+        }
+    }
+
+    // the first vsync the frame can be ready for
+    double lead = std::max( mFormat.getLatencyBudget(), mRenderEstimate );
+    double target = ( mBeginTime + lead - mPhase ) / period;
+    int64_t vsync = (int64_t)ceil( target );
+
+    if ( mFirst ) {
+        mAdvance = 1;
+        mFirst = false;
+    }
+    else {
+        // stay on the next vsync unless clearly early or clearly late
+        int64_t next = mVsync + 1;
+        if ( target > next - 1 - HYSTERESIS && target <= next + HYSTERESIS ) vsync = next;
+
+        if ( vsync <= mVsync ) {
+            vsync = mVsync;
+            mAdvance = 0;
+            ++mStats.repeated;
+        }
+        else {
+            mAdvance = vsync - mVsync;
+            mStats.dropped += mAdvance - 1;
+        }
+    }
+
+    mVsync = vsync;
+    ++mStats.frames;
+}
+
+void PresentationClock::endFrame()
+{
+    double end = now();
+    double render = end - mBeginTime;
+
+    mRenderEstimate = mRenderEstimate == 0.0 ? render : mRenderEstimate + RENDER_SMOOTHING * ( render - mRenderEstimate );
+    // plan for spikes straight away, recover slowly
+    mRenderEstimate = std::max( mRenderEstimate, render );
+
+    if ( end > mPhase + getTime() ) ++mStats.late;
+
+    mRenderTotal += render;
+    mStats.meanRenderTime = mRenderTotal / mStats.frames;
+    mStats.maxRenderTime = std::max( mStats.maxRenderTime, render );
+}
@@ -0,0 +1,228 @@
+#include "cinder/framegraph/ProgramBinaryCache.hpp"
+#include "cinder/framegraph/ProgramRegistry.hpp"
+#include "cinder/gl/gl.h"
+#include "cinder/Log.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+
+const char      BINARY_MAGIC[ 8 ] = { 'F', 'G', 'G', 'L', 'B', 'I', 'N', '\0' };
+const uint32_t  BINARY_VERSION = 1;
+
+//! Larger binaries in a header are taken as corruption.
+const uint64_t  BINARY_MAX_SIZE = 64 << 20;
+
+const char *    STUB_VERTEX = "#version 150\nvoid main() { gl_Position = vec4( 0.0 ); }\n";
+
+struct BinaryHeader {
+    char        magic[ 8 ];
+    uint32_t    version;
+    uint32_t    binaryFormat;
+    uint64_t    size;
+};
+
+// FNV-1a
+uint64_t hashBytes( const char * data, size_t size, uint64_t h = 14695981039346656037ULL )
+{
+    for ( size_t i = 0; i < size; ++i ) {
+        h ^= (uint8_t)data[ i ];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+string getString( GLenum name )
+{
+    auto str = (const char *)glGetString( name );
+    return str ? str : "";
+}
+
+bool readBinary( const fs::path & path, GLenum * binaryFormat, vector< uint8_t > * binary )
+{
+    ifstream in( path.string(), ios::binary );
+    if ( ! in ) return false;
+
+    BinaryHeader header;
+    in.read( reinterpret_cast< char * >( &header ), sizeof( header ) );
+    if ( ! in || memcmp( header.magic, BINARY_MAGIC, sizeof( BINARY_MAGIC ) ) != 0 || header.version != BINARY_VERSION ) return false;
+    if ( header.size == 0 || header.size > BINARY_MAX_SIZE ) return false;
+
+    binary->resize( (size_t)header.size );
+    in.read( reinterpret_cast< char * >( binary->data() ), binary->size() );
+    if ( ! in ) return false;
+
+    *binaryFormat = header.binaryFormat;
+    return true;
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// BinaryGlslProg
+
+gl::GlslProgRef BinaryGlslProg::create( const Format & format, GLenum binaryFormat, const vector< uint8_t > & binary )
+{
+    auto program = shared_ptr< BinaryGlslProg >( new BinaryGlslProg( format, binaryFormat, binary ) );
+    return program->mLoaded ? program : nullptr;
+}
+
+BinaryGlslProg::BinaryGlslProg( const Format & format, GLenum binaryFormat, const vector< uint8_t > & binary ) :
+        GlslProg( getStubFormat( format ) )
+{
+    // relinking from the binary replaces the stub, locations included
+    glProgramBinary( mHandle, binaryFormat, binary.data(), (GLsizei)binary.size() );
+    GLint status = GL_FALSE;
+    glGetProgramiv( mHandle, GL_LINK_STATUS, &status );
+    if ( status != GL_TRUE ) return;
+
+    cacheActiveAttribs();
+    cacheActiveUniforms();
+    cacheActiveUniformBlocks();
+    mLoaded = true;
+}
+
+gl::GlslProg::Format BinaryGlslProg::getStubFormat( const Format & format )
+{
+    // keeps the semantics, defines and label of the original
+    Format stub = format;
+    stub.vertex( STUB_VERTEX )
+        .fragment( string() )
+        .geometry( string() )
+        .tessellationCtrl( string() )
+        .tessellationEval( string() );
+    return stub;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ProgramBinaryCache
+
+ProgramBinaryCache & ProgramBinaryCache::instance()
+{
+    static ProgramBinaryCache cache;
+    return cache;
+}
+
+void ProgramBinaryCache::setDirectory( const fs::path & dir )
+{
+    if ( ! dir.empty() ) {
+        try {
+            fs::create_directories( dir );
+        }
+        catch ( const std::exception & e ) {
+            CI_LOG_EXCEPTION( "Unable to create program binary cache: " << dir, e );
+        }
+    }
+
+    lock_guard< mutex > lock( mMutex );
+    mDirectory = dir;
+}
+
+fs::path ProgramBinaryCache::getDirectory() const
+{
+    lock_guard< mutex > lock( mMutex );
+    return mDirectory;
+}
+
+fs::path ProgramBinaryCache::getPath( const gl::GlslProg::Format & format )
+{
+    lock_guard< mutex > lock( mMutex );
+    if ( mDirectory.empty() ) return fs::path();
+
+    // formats with transform feedback can't be rebuilt from the stub
+    if ( ! format.getVaryings().empty() ) return fs::path();
+
+    if ( mDriver.empty() ) {
+        GLint formats = 0;
+        glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &formats );
+        if ( formats == 0 ) {
+            CI_LOG_W( "The driver has no program binary formats, compiling every launch" );
+            mDirectory.clear();
+            return fs::path();
+        }
+        mDriver = getString( GL_VENDOR ) + '\0' + getString( GL_RENDERER ) + '\0' + getString( GL_VERSION );
+    }
+
+    // locations bound before linking are part of the binary
+    ostringstream os;
+    os << ProgramRegistry::getKey( format ) << '\0'
+       << format.getTessellationCtrl() << '\0'
+       << format.getTessellationEval() << '\0';
+    for ( auto & location : format.getAttribNameLocations() ) os << location.first << ' ' << location.second << '\0';
+    for ( auto & location : format.getFragDataLocations() ) os << location.first << ' ' << location.second << '\0';
+    string key = os.str();
+
+    uint64_t hash = hashBytes( key.data(), key.size(), hashBytes( mDriver.data(), mDriver.size() ) );
+    ostringstream name;
+    name << hex << hash << ".glbin";
+    return mDirectory / name.str();
+}
+
+gl::GlslProgRef ProgramBinaryCache::create( const gl::GlslProg::Format & format )
+{
+    fs::path path = getPath( format );
+    if ( path.empty() ) return gl::GlslProg::create( format );
+
+    GLenum binaryFormat = 0;
+    vector< uint8_t > binary;
+    if ( readBinary( path, &binaryFormat, &binary ) ) {
+        if ( auto program = BinaryGlslProg::create( format, binaryFormat, binary ) ) return program;
+        CI_LOG_W( "Program binary rejected, compiling: " << path );
+    }
+
+    auto program = gl::GlslProg::create( format );
+    store( path, program );
+    return program;
+}
+
+void ProgramBinaryCache::store( const fs::path & path, const gl::GlslProgRef & program )
+{
+    GLint length = 0;
+    glGetProgramiv( program->getHandle(), GL_PROGRAM_BINARY_LENGTH, &length );
+    if ( length <= 0 ) return;
+
+    vector< uint8_t > binary( (size_t)length );
+    GLsizei written = 0;
+    GLenum binaryFormat = 0;
+    glGetProgramBinary( program->getHandle(), length, &written, &binaryFormat, binary.data() );
+    if ( written <= 0 ) return;
+
+    BinaryHeader header;
+    memcpy( header.magic, BINARY_MAGIC, sizeof( BINARY_MAGIC ) );
+    header.version = BINARY_VERSION;
+    header.binaryFormat = binaryFormat;
+    header.size = (uint64_t)written;
+
+    // write to a temporary and rename, so a reader never sees a partial file
+    fs::path tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        ofstream out( tmpPath.string(), ios::binary | ios::trunc );
+        if ( ! out ) {
+            CI_LOG_W( "Unable to write program binary: " << path );
+            return;
+        }
+        out.write( reinterpret_cast< const char * >( &header ), sizeof( header ) );
+        out.write( reinterpret_cast< const char * >( binary.data() ), written );
+        out.close();
+        if ( ! out ) {
+            CI_LOG_W( "Unable to write program binary: " << path );
+            std::remove( tmpPath.string().c_str() );
+            return;
+        }
+    }
+
+    try {
+        fs::rename( tmpPath, path );
+    }
+    catch ( const std::exception & e ) {
+        CI_LOG_EXCEPTION( "Unable to write program binary: " << path, e );
+        std::remove( tmpPath.string().c_str() );
+    }
+}
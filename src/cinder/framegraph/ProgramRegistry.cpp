@@ -0,0 +1,136 @@
+#include "cinder/framegraph/ProgramRegistry.hpp"
+#include "cinder/Log.h"
+#include <sstream>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+// SharedProgram
+
+SharedProgramRef SharedProgram::create( const gl::GlslProgRef & program )
+{
+    promise< gl::GlslProgRef > result;
+    result.set_value( program );
+
+    auto shared = make_shared< SharedProgram >();
+    shared->mProgram = result.get_future().share();
+    return shared;
+}
+
+void SharedProgram::update()
+{
+    if ( ! mReload.valid() || mReload.wait_for( chrono::seconds( 0 ) ) != future_status::ready ) return;
+
+    GlslProgFuture reload = move( mReload );
+    mReload = GlslProgFuture();
+    try {
+        reload.get();
+    }
+    catch( const std::exception & e ) {
+        CI_LOG_EXCEPTION( "Error reloading shader: " << mFormat.getVertexPath() << ", " << mFormat.getFragmentPath(), e );
+        return;
+    }
+
+    mProgram = reload;
+    ++mVersion;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// ProgramRegistry
+
+ProgramRegistry & ProgramRegistry::instance()
+{
+    static ProgramRegistry registry;
+    return registry;
+}
+
+string ProgramRegistry::getKey( const gl::GlslProg::Format & format, bool withPaths )
+{
+    // sources are separated by a character that can't appear in them
+    ostringstream os;
+    os << format.getVersion() << '\0'
+       << format.getVertex() << '\0'
+       << format.getFragment() << '\0'
+       << format.getGeometry() << '\0';
+    for ( auto & define : format.getDefines() ) {
+        os << define.first << ' ' << define.second << '\0';
+    }
+    if ( withPaths ) {
+        os << format.getVertexPath().string() << '\0'
+           << format.getFragmentPath().string() << '\0';
+    }
+    return os.str();
+}
+
+SharedProgramRef ProgramRegistry::get( const gl::GlslProg::Format & format )
+{
+    return get( getKey( format ), format );
+}
+
+SharedProgramRef ProgramRegistry::get( const string & key, const gl::GlslProg::Format & format )
+{
+    auto it = mPrograms.find( key );
+    if ( it != mPrograms.end() ) {
+        if ( auto program = it->second.lock() ) return program;
+    }
+
+    auto program = make_shared< SharedProgram >();
+    program->mFormat = format;
+    program->mProgram = ShaderCompiler::instance().compileAsync( format );
+    mPrograms[ key ] = program;
+
+    // forget programs nobody uses any more
+    for ( auto it = mPrograms.begin(); it != mPrograms.end(); ) {
+        if ( it->second.expired() ) it = mPrograms.erase( it );
+        else                        ++it;
+    }
+
+    return program;
+}
+
+SharedProgramRef ProgramRegistry::watch( const gl::GlslProg::Format & format )
+{
+    // the same sources loaded from different files must be watched apart
+    auto program = get( getKey( format, true ), format );
+    if ( program->mWatched ) return program;
+    program->mWatched = true;
+
+    CI_LOG_I( "WATCH SHADER " << format.getVertexPath() );
+
+    weak_ptr< SharedProgram > weakProgram = program;
+    vector< fs::path > paths{ format.getVertexPath(), format.getFragmentPath() };
+    FileWatcher::instance().watch( paths, [weakProgram]( const WatchEvent & event ) {
+        auto program = weakProgram.lock();
+        if ( ! program ) return;
+
+        program->mSignalChanged.emit( event );
+
+        const auto & format = program->mFormat;
+        try {
+            auto fmt = format;
+            fmt.vertex( DataSourcePath::create( format.getVertexPath() ) );
+            fmt.fragment( DataSourcePath::create( format.getFragmentPath() ) );
+            // swapped in by update() once it has compiled, replacing any
+            // earlier reload still in flight
+            program->mReload = ShaderCompiler::instance().compileAsync( fmt );
+
+            CI_LOG_I( "Reloading shader: " << format.getVertexPath() << ", " << format.getFragmentPath() );
+        }
+        catch( const std::exception & e ) {
+            CI_LOG_EXCEPTION( "Error reloading shader: " << format.getVertexPath() << ", " << format.getFragmentPath(), e );
+        }
+    } );
+
+    return program;
+}
+
+size_t ProgramRegistry::getNumPrograms() const
+{
+    size_t n = 0;
+    for ( auto & entry : mPrograms ) {
+        if ( ! entry.second.expired() ) ++n;
+    }
+    return n;
+}
@@ -0,0 +1,78 @@
+#include "cinder/framegraph/ProxyScale.hpp"
+#include <algorithm>
+#include <cmath>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+// ProxyScale
+
+ProxyScale & ProxyScale::instance()
+{
+    static ProxyScale proxyScale;
+    return proxyScale;
+}
+
+void ProxyScale::setProxyScale( float scale )
+{
+    scale = glm::clamp( scale, 0.01f, 1.f );
+    if ( scale == mProxyScale ) return;
+
+    mProxyScale = scale;
+    if ( mProxy ) mSignalScaleChanged.emit( getScale() );
+}
+
+void ProxyScale::interact()
+{
+    mLastInteraction = clock::now();
+    setProxy( true );
+}
+
+void ProxyScale::update()
+{
+    if ( ! mProxy ) return;
+
+    chrono::duration< double > idle = clock::now() - mLastInteraction;
+    if ( idle.count() >= mIdleTimeout ) setProxy( false );
+}
+
+void ProxyScale::setProxy( bool proxy )
+{
+    if ( proxy == mProxy ) return;
+
+    mProxy = proxy;
+    if ( mProxyScale < 1.f ) mSignalScaleChanged.emit( getScale() );
+}
+
+ivec2 ProxyScale::getScaledSize( const ivec2 & fullSize ) const
+{
+    float scale = getScale();
+    if ( scale == 1.f ) return fullSize;
+
+    return ivec2( std::max( 1, (int)std::lround( fullSize.x * scale ) ),
+                  std::max( 1, (int)std::lround( fullSize.y * scale ) ) );
+}
+
+void ProxyScale::registerTexture( const gl::Texture2dRef & texture, const ivec2 & fullSize )
+{
+    if ( ! texture ) return;
+
+    // render targets are replaced when they are resized, drop the old ones
+    for ( auto it = mFullSizes.begin(); it != mFullSizes.end(); ) {
+        if ( it->second.texture.expired() ) it = mFullSizes.erase( it );
+        else ++it;
+    }
+
+    mFullSizes[ texture.get() ] = { texture, fullSize };
+}
+
+ivec2 ProxyScale::getFullSize( const gl::Texture2dRef & texture ) const
+{
+    auto it = mFullSizes.find( texture.get() );
+    if ( it != mFullSizes.end() && it->second.texture.lock() == texture ) {
+        return it->second.fullSize;
+    }
+    return texture->getSize();
+}
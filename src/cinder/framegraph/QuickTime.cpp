@@ -1,4 +1,5 @@
 #include "cinder/framegraph/QuickTime.hpp"
+#include <cmath>
 
 using namespace cinder;
 using namespace frame_graph;
@@ -13,10 +14,36 @@ mMovie( qtime::MovieGl::create( path ) )
 
 void QTMovieGlINode::update()
 {
+	if ( mClock ) {
+		// a repeated frame shows what the last one showed
+		if ( mClock->getAdvance() == 0 ) return;
+		syncToClock();
+	}
+
 	auto tex = mMovie->getTexture();
 	if ( tex ) TextureINode::update( tex );
 }
 
+void QTMovieGlINode::syncToClock()
+{
+	float duration = getDuration();
+	float target = mClockOffset + (float)mClock->getTime() * mRate;
+
+	if ( mLooping && duration > 0.f ) {
+		target = fmod( target, duration );
+		if ( target < 0.f ) target += duration;
+	}
+	else {
+		target = glm::clamp( target, 0.f, duration );
+	}
+
+	// playback keeps pace by itself, so only seek when it has fallen behind
+	// or run ahead of the clock
+	if ( std::abs( getCurrentTime() - target ) > 1.5f * (float)mClock->getPeriod() ) {
+		mMovie->seekToTime( target );
+	}
+}
+
 
 
 
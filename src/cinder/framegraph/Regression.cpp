@@ -0,0 +1,190 @@
+#include "cinder/framegraph/Regression.hpp"
+#include "cinder/gl/gl.h"
+#include "cinder/ImageIo.h"
+#include "cinder/Json.h"
+#include "cinder/Log.h"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+ImageDiff frame_graph::compareImages( const Surface32f & result, const Surface32f & golden, float tolerance )
+{
+    ImageDiff diff;
+    if ( result.getSize() != golden.getSize() ) {
+        diff.sizeMismatch = true;
+        diff.maxError = 1.f;
+        diff.meanError = 1.f;
+        diff.numFailing = (size_t)result.getWidth() * result.getHeight();
+        return diff;
+    }
+
+    bool alpha = result.hasAlpha() && golden.hasAlpha();
+    double sum = 0.0;
+    auto r = result.getIter();
+    auto g = golden.getIter();
+    while ( r.line() && g.line() ) {
+        while ( r.pixel() && g.pixel() ) {
+            float error = max( { abs( r.r() - g.r() ), abs( r.g() - g.g() ), abs( r.b() - g.b() ) } );
+            if ( alpha ) error = max( error, abs( r.a() - g.a() ) );
+
+            diff.maxError = max( diff.maxError, error );
+            sum += error;
+            if ( error > tolerance ) ++diff.numFailing;
+        }
+    }
+    diff.meanError = (float)( sum / ( (double)result.getWidth() * result.getHeight() ) );
+    return diff;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// RegressionSuite
+
+namespace {
+
+map< string, double > loadBaseline( const fs::path & path )
+{
+    map< string, double > baseline;
+    if ( path.empty() || ! fs::exists( path ) ) return baseline;
+
+    try {
+        JsonTree json( loadFile( path ) );
+        for ( const auto & c : json.getChild( "cases" ).getChildren() ) {
+            baseline[ c.getValueForKey( "name" ) ] = c.getValueForKey< double >( "medianMs" );
+        }
+    }
+    catch ( const std::exception & e ) {
+        CI_LOG_EXCEPTION( "Unable to read timing baseline: " << path, e );
+    }
+    return baseline;
+}
+
+}
+
+RegressionSuite::RegressionSuite( const Format & format ) :
+        mFormat( format )
+{
+}
+
+void RegressionSuite::add( const string & name, const RenderFn & render )
+{
+    mCases.push_back( { name, render } );
+}
+
+bool RegressionSuite::run()
+{
+    auto baseline = loadBaseline( mFormat.getBaseline() );
+
+    mResults.clear();
+    bool passed = true;
+    for ( const auto & c : mCases ) {
+        mResults.push_back( run( c, baseline ) );
+        passed = passed && mResults.back().passed();
+    }
+    return passed;
+}
+
+RegressionSuite::Result RegressionSuite::run( const Case & c, const map< string, double > & baseline )
+{
+    typedef chrono::steady_clock clock;
+
+    Result result;
+    result.name = c.name;
+
+    gl::Texture2dRef texture;
+    for ( int i = 0; i < mFormat.getWarmup(); ++i ) texture = c.render();
+
+    // finishing makes the wall time the render time, exactly so on software
+    // renderers, which is what CI runs
+    vector< double > times;
+    for ( int i = 0; i < mFormat.getIterations(); ++i ) {
+        glFinish();
+        auto start = clock::now();
+        texture = c.render();
+        glFinish();
+        chrono::duration< double, milli > elapsed = clock::now() - start;
+        times.push_back( elapsed.count() );
+    }
+    if ( ! times.empty() ) {
+        sort( times.begin(), times.end() );
+        result.minMs = times.front();
+        result.medianMs = times[ times.size() / 2 ];
+        result.meanMs = accumulate( times.begin(), times.end(), 0.0 ) / times.size();
+    }
+
+    auto it = baseline.find( c.name );
+    if ( it != baseline.end() ) {
+        result.baselineMs = it->second;
+        result.timePassed = result.medianMs <= it->second * mFormat.getSlack();
+    }
+
+    if ( ! texture ) {
+        CI_LOG_E( c.name << ": rendered nothing" );
+        return result;
+    }
+
+    Surface32f image( texture->createSource() );
+    fs::path goldenPath = mFormat.getGoldens() / ( c.name + ".png" );
+    if ( mFormat.getUpdateGoldens() ) {
+        writeImage( goldenPath, image );
+        result.recorded = true;
+        result.imagePassed = true;
+    }
+    else if ( ! fs::exists( goldenPath ) ) {
+        // a missing golden would otherwise pass anything
+        fs::path failures = mFormat.getFailures().empty() ? mFormat.getGoldens() : mFormat.getFailures();
+        writeImage( failures / ( c.name + ".failed.png" ), image );
+        CI_LOG_E( c.name << ": no golden image at " << goldenPath << ", record one with updateGoldens()" );
+        return result;
+    }
+    else {
+        Surface32f golden( loadImage( goldenPath ) );
+        result.diff = compareImages( image, golden, mFormat.getTolerance() );
+
+        size_t allowed = (size_t)( mFormat.getMaxFailingFraction() * image.getWidth() * image.getHeight() );
+        result.imagePassed = ! result.diff.sizeMismatch && result.diff.numFailing <= allowed;
+
+        if ( ! result.imagePassed ) {
+            fs::path failures = mFormat.getFailures().empty() ? mFormat.getGoldens() : mFormat.getFailures();
+            writeImage( failures / ( c.name + ".failed.png" ), image );
+        }
+    }
+
+    if ( result.passed() ) {
+        CI_LOG_I( c.name << ": passed, " << result.medianMs << " ms" << ( result.recorded ? " (golden recorded)" : "" ) );
+    }
+    if ( ! result.imagePassed ) {
+        CI_LOG_E( c.name << ": " << result.diff.numFailing << " pixels over tolerance, max error " << result.diff.maxError );
+    }
+    if ( ! result.timePassed ) {
+        CI_LOG_E( c.name << ": " << result.medianMs << " ms against a baseline of " << result.baselineMs << " ms" );
+    }
+    return result;
+}
+
+void RegressionSuite::writeTimings( const fs::path & path ) const
+{
+    JsonTree cases = JsonTree::makeArray( "cases" );
+    for ( const auto & r : mResults ) {
+        JsonTree c = JsonTree::makeObject();
+        c.addChild( JsonTree( "name", r.name ) )
+         .addChild( JsonTree( "passed", r.passed() ) )
+         .addChild( JsonTree( "maxError", r.diff.maxError ) )
+         .addChild( JsonTree( "meanError", r.diff.meanError ) )
+         .addChild( JsonTree( "minMs", r.minMs ) )
+         .addChild( JsonTree( "medianMs", r.medianMs ) )
+         .addChild( JsonTree( "meanMs", r.meanMs ) );
+        cases.addChild( c );
+    }
+
+    const GLubyte * renderer = glGetString( GL_RENDERER );
+
+    JsonTree json = JsonTree::makeObject();
+    json.addChild( JsonTree( "renderer", renderer ? string( reinterpret_cast< const char * >( renderer ) ) : string() ) )
+        .addChild( JsonTree( "iterations", mFormat.getIterations() ) )
+        .addChild( cases );
+    json.write( path );
+}
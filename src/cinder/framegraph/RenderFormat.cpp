@@ -0,0 +1,51 @@
+#include "cinder/framegraph/RenderFormat.hpp"
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+// RenderFormat
+
+GLint frame_graph::getInternalFormat( RenderFormat format )
+{
+    switch ( format ) {
+        case RenderFormat::R11G11B10F: return GL_R11F_G11F_B10F;
+        case RenderFormat::RGBA16F: return GL_RGBA16F;
+        case RenderFormat::RGBA32F: return GL_RGBA32F;
+        default: return GL_RGBA8;
+    }
+}
+
+size_t frame_graph::getBytesPerPixel( RenderFormat format )
+{
+    switch ( format ) {
+        case RenderFormat::RGBA16F: return 8;
+        case RenderFormat::RGBA32F: return 16;
+        default: return 4;
+    }
+}
+
+bool frame_graph::hasAlpha( RenderFormat format )
+{
+    return format != RenderFormat::R11G11B10F;
+}
+
+RenderFormat frame_graph::getCheapestFormat( Precision precision, bool alpha )
+{
+    switch ( precision ) {
+        case Precision::LDR: return RenderFormat::RGBA8;
+        case Precision::HDR_PACKED: return alpha ? RenderFormat::RGBA16F : RenderFormat::R11G11B10F;
+        case Precision::HDR_HALF: return RenderFormat::RGBA16F;
+        default: return RenderFormat::RGBA32F;
+    }
+}
+
+gl::Fbo::Format frame_graph::getFboFormat( RenderFormat format )
+{
+    auto texFormat = gl::Texture2d::Format()
+        .internalFormat( getInternalFormat( format ) )
+        .minFilter( GL_LINEAR )
+        .magFilter( GL_LINEAR );
+    return gl::Fbo::Format().colorTexture( texFormat );
+}
@@ -0,0 +1,92 @@
+#include "cinder/framegraph/RenderStage.hpp"
+#include <algorithm>
+#include <map>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+// StageGraph
+
+StageGraph & StageGraph::link( RenderStage & producer, RenderStage & consumer )
+{
+    mLinks.push_back( { &producer, &consumer } );
+    return *this;
+}
+
+void StageGraph::negotiateFormats()
+{
+    struct Requirement {
+        Precision   precision = Precision::LDR;
+        bool        alpha = false;
+    };
+
+    // what each producer must deliver; consumers that forward precision pass
+    // their own requirement on to their inputs, so iterate until nothing
+    // changes. Each pass can only raise requirements, so this terminates.
+    map< RenderStage *, Requirement > required;
+    for ( auto & l : mLinks ) required[ l.producer ];
+
+    bool changed = true;
+    while ( changed ) {
+        changed = false;
+        for ( auto & l : mLinks ) {
+            Requirement need{ l.consumer->getInputPrecision(), l.consumer->needsInputAlpha() };
+            auto downstream = required.find( l.consumer );
+            if ( l.consumer->forwardsPrecision() && downstream != required.end() ) {
+                need.precision = std::max( need.precision, downstream->second.precision );
+                need.alpha = need.alpha || downstream->second.alpha;
+            }
+
+            auto & r = required[ l.producer ];
+            if ( need.precision > r.precision || ( need.alpha && ! r.alpha ) ) {
+                r.precision = std::max( r.precision, need.precision );
+                r.alpha = r.alpha || need.alpha;
+                changed = true;
+            }
+        }
+    }
+
+    for ( auto & kv : required ) {
+        kv.first->setOutputFormat( getCheapestFormat( kv.second.precision, kv.second.alpha ) );
+    }
+}
+
+void StageGraph::propagateRegions()
+{
+    // producers read nothing until a consumer asks for it; regions only
+    // grow, so iterate until nothing changes
+    map< RenderStage *, Rectf > regions;
+    for ( auto & l : mLinks ) regions[ l.producer ] = Rectf( 0.f, 0.f, 0.f, 0.f );
+
+    auto regionOf = [&]( RenderStage * stage ) {
+        auto it = regions.find( stage );
+        return it != regions.end() ? it->second : stage->getRegionOfInterest();
+    };
+
+    bool changed = true;
+    while ( changed ) {
+        changed = false;
+        for ( auto & l : mLinks ) {
+            Rectf need = regionOf( l.consumer );
+            if ( need.getWidth() <= 0.f || need.getHeight() <= 0.f ) continue;
+
+            float margin = l.consumer->getInputMargin();
+            need = Rectf( need.x1 - margin, need.y1 - margin, need.x2 + margin, need.y2 + margin );
+            need.clipBy( Rectf( 0.f, 0.f, 1.f, 1.f ) );
+
+            Rectf & r = regions[ l.producer ];
+            Rectf grown = r.getWidth() > 0.f && r.getHeight() > 0.f ? r : need;
+            grown.include( need );
+            if ( grown.x1 != r.x1 || grown.y1 != r.y1 || grown.x2 != r.x2 || grown.y2 != r.y2 ) {
+                r = grown;
+                changed = true;
+            }
+        }
+    }
+
+    for ( auto & kv : regions ) {
+        kv.first->setRegionOfInterest( kv.second );
+    }
+}
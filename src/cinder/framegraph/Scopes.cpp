@@ -0,0 +1,352 @@
+#include "cinder/framegraph/Scopes.hpp"
+#include "cinder/framegraph/ThreadPool.hpp"
+#include "cinder/gl/gl.h"
+#include <mutex>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+#include <immintrin.h>
+#if defined( __GNUC__ ) || defined( __clang__ )
+#define FG_SCOPES_AVX2 1
+#define FG_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#elif defined( __AVX2__ )
+#define FG_SCOPES_AVX2 1
+#define FG_TARGET_AVX2
+#endif
+#endif
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+
+//! Readbacks in flight before new frames are skipped rather than stalling
+const size_t MAX_PENDING = 3;
+
+const string VERT = R"EOF(
+#version 150
+
+uniform sampler2D   uTex;
+uniform ivec2       uSampleCount;
+uniform int         uStep;
+uniform vec2        uRange;
+uniform ivec2       uScopeSize;
+
+out vec4 vColor;
+
+const vec3 LUMA = vec3( 0.2126, 0.7152, 0.0722 );
+
+float bin( in float v, in int bins )
+{
+    float f = ( v - uRange.x ) * uRange.y * float( bins );
+    return f > 0. ? floor( min( f, float( bins - 1 ) ) ) : 0.;
+}
+
+void main( void ) {
+    // one point per channel of each sampled pixel, added into the cell
+    // holding its value
+    int channel = gl_VertexID % CHANNELS;
+    int i = gl_VertexID / CHANNELS;
+    ivec2 p = ivec2( i % uSampleCount.x, i / uSampleCount.x ) * uStep;
+    vec4 c = texelFetch( uTex, p, 0 );
+
+#if defined( VECTORSCOPE )
+    vec2 cbcr = vec2( dot( c.rgb, vec3( -0.1146, -0.3854, 0.5 ) ), dot( c.rgb, vec3( 0.5, -0.4542, -0.0458 ) ) );
+    vec2 cell = vec2( bin( cbcr.x, uScopeSize.x ), bin( cbcr.y, uScopeSize.y ) );
+    vColor = vec4( 1., 0., 0., 0. );
+#else
+    float v = channel == 3 ? dot( c.rgb, LUMA ) : c[ channel ];
+#if defined( WAVEFORM )
+    vec2 cell = vec2( floor( float( p.x * uScopeSize.x ) / float( textureSize( uTex, 0 ).x ) ), bin( v, uScopeSize.y ) );
+#else
+    vec2 cell = vec2( bin( v, uScopeSize.x ), 0. );
+#endif
+    vColor = vec4( 0. );
+    vColor[ channel ] = 1.;
+#endif
+
+    gl_Position = vec4( ( cell + 0.5 ) / vec2( uScopeSize ) * 2. - 1., 0., 1. );
+}
+)EOF";
+
+const string FRAG = R"EOF(
+#version 150
+
+in vec4 vColor;
+out vec4 oColor;
+
+void main( void ) {
+    oColor = vColor;
+}
+)EOF";
+
+const vec3 LUMA( 0.2126f, 0.7152f, 0.0722f );
+const vec3 CB( -0.1146f, -0.3854f, 0.5f );
+const vec3 CR( 0.5f, -0.4542f, -0.0458f );
+
+inline int32_t bin( float v, float min, float scale, int32_t bins )
+{
+    float f = ( v - min ) * scale;
+    return f > 0.f ? (int32_t)std::min( f, (float)( bins - 1 ) ) : 0;
+}
+
+//! Writes the R, G, B and luminance bins of \a count pixels, \a step pixels
+//! apart, to \a out. \a offsets are the red, green and blue channel offsets.
+void binPixels( const float * p, int count, int inc, const ivec3 & offsets, int step, float min, float scale, int32_t bins, int32_t * out )
+{
+    for ( int i = 0; i < count; ++i, p += inc * step, out += 4 ) {
+        float r = p[ offsets.r ], g = p[ offsets.g ], b = p[ offsets.b ];
+        float luma = r * LUMA.r + g * LUMA.g + b * LUMA.b;
+        out[ 0 ] = bin( r, min, scale, bins );
+        out[ 1 ] = bin( g, min, scale, bins );
+        out[ 2 ] = bin( b, min, scale, bins );
+        out[ 3 ] = bin( luma, min, scale, bins );
+    }
+}
+
+#if defined( FG_SCOPES_AVX2 )
+
+bool hasAvx2()
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return __builtin_cpu_supports( "avx2" );
+#else
+    return true;
+#endif
+}
+
+//! binPixels for contiguous RGBA pixels, two at a time. Luminance replaces
+//! alpha in each pixel's lane.
+FG_TARGET_AVX2 void binPixelsAvx2( const float * p, int count, float min, float scale, int32_t bins, int32_t * out )
+{
+    const __m256 luma = _mm256_setr_ps( LUMA.r, LUMA.g, LUMA.b, 0.f, LUMA.r, LUMA.g, LUMA.b, 0.f );
+    const __m256 vMin = _mm256_set1_ps( min );
+    const __m256 vScale = _mm256_set1_ps( scale );
+    const __m256 vMax = _mm256_set1_ps( (float)( bins - 1 ) );
+    const __m256 zero = _mm256_setzero_ps();
+
+    int i = 0;
+    for ( ; i + 2 <= count; i += 2, p += 8, out += 8 ) {
+        __m256 c = _mm256_loadu_ps( p );
+        // dot product of RGB into element 3 of each 128 bit lane
+        __m256 l = _mm256_dp_ps( c, luma, 0x78 );
+        c = _mm256_blend_ps( c, l, 0x88 );
+
+        __m256 f = _mm256_mul_ps( _mm256_sub_ps( c, vMin ), vScale );
+        f = _mm256_min_ps( _mm256_max_ps( f, zero ), vMax );
+        _mm256_storeu_si256( (__m256i *)out, _mm256_cvttps_epi32( f ) );
+    }
+
+    binPixels( p, count - i, 4, ivec3( 0, 1, 2 ), 1, min, scale, bins, out );
+}
+
+#endif
+
+} // anonymous namespace
+
+////////////////////////////////////////////////////////////////////////////////
+// ScopeNode
+
+ScopeNode::Format::Format( ScopeType type ) :
+mType( type )
+{
+    bool histogram = type == ScopeType::HISTOGRAM;
+    bool vectorscope = type == ScopeType::VECTORSCOPE;
+    mWidth = 256;
+    mHeight = histogram ? 1 : 256;
+    mMin = vectorscope ? -0.5f : 0.f;
+    mMax = vectorscope ? 0.5f : 1.f;
+}
+
+ScopeNode::ScopeNode( const Format & format ) :
+mFormat( format )
+{
+    in< 0 >().onReceive( [&]( const Surface32fRef & image ) {
+        update( image );
+    } );
+    in< 1 >().onReceive( [&]( const gl::Texture2dRef & tex ) {
+        update( tex );
+    } );
+}
+
+ScopeRef ScopeNode::analyze( const Surface32f & image, const Format & format )
+{
+    auto scope = make_shared< Scope >();
+    scope->type = format.getType();
+    scope->width = std::max( format.getWidth(), 1 );
+    scope->height = format.getType() == ScopeType::HISTOGRAM ? 1 : std::max( format.getHeight(), 1 );
+    scope->channels = format.getType() == ScopeType::VECTORSCOPE ? 1 : 4;
+    scope->counts.assign( (size_t)scope->channels * scope->width * scope->height, 0 );
+
+    const ScopeType type = scope->type;
+    const int width = scope->width;
+    const int height = scope->height;
+    const int32_t bins = type == ScopeType::HISTOGRAM ? width : height;
+    const int step = std::max( format.getStep(), 1 );
+    const int inc = image.getPixelInc();
+    const ivec3 offsets( image.getRedOffset(), image.getGreenOffset(), image.getBlueOffset() );
+    const int samples = ( image.getWidth() + step - 1 ) / step;
+    const float min = format.getMin();
+    const float scale = bins / std::max( format.getMax() - format.getMin(), 1e-6f );
+    const size_t n = scope->counts.size();
+
+#if defined( FG_SCOPES_AVX2 )
+    // the vector path loads whole pixels, so only in RGBA order
+    const bool simd = inc == 4 && offsets == ivec3( 0, 1, 2 ) && step == 1 && hasAvx2();
+#endif
+
+    size_t rows = ( image.getHeight() + step - 1 ) / step;
+    size_t grain = std::max< size_t >( 1, rows / ( 4 * ( ThreadPool::instance().getNumThreads() + 1 ) ) );
+    mutex lock;
+
+    ThreadPool::instance().parallelFor( rows, grain, [&]( size_t begin, size_t end ) {
+        // two copies, alternating by pixel, so consecutive equal values
+        // don't serialize on the same counter
+        vector< uint32_t > local( 2 * n, 0 );
+        vector< int32_t > pixelBins( 4 * (size_t)samples );
+
+        for ( size_t r = begin; r < end; ++r ) {
+            const float * p = image.getData( ivec2( 0, (int)( r * step ) ) );
+
+            if ( type == ScopeType::VECTORSCOPE ) {
+                for ( int i = 0; i < samples; ++i, p += inc * step ) {
+                    vec3 c( p[ offsets.r ], p[ offsets.g ], p[ offsets.b ] );
+                    int32_t x = bin( glm::dot( c, CB ), min, scale * width / bins, width );
+                    int32_t y = bin( glm::dot( c, CR ), min, scale, height );
+                    ++local[ ( i & 1 ) * n + (size_t)y * width + x ];
+                }
+                continue;
+            }
+
+#if defined( FG_SCOPES_AVX2 )
+            if ( simd ) binPixelsAvx2( p, samples, min, scale, bins, pixelBins.data() );
+            else
+#endif
+            binPixels( p, samples, inc, offsets, step, min, scale, bins, pixelBins.data() );
+
+            const int32_t * b = pixelBins.data();
+            for ( int i = 0; i < samples; ++i, b += 4 ) {
+                uint32_t * counts = &local[ ( i & 1 ) * n ];
+                if ( type == ScopeType::HISTOGRAM ) {
+                    for ( int c = 0; c < 4; ++c ) ++counts[ c * width + b[ c ] ];
+                }
+                else {
+                    int column = (int)( (int64_t)i * step * width / image.getWidth() );
+                    for ( int c = 0; c < 4; ++c ) ++counts[ ( (size_t)c * height + b[ c ] ) * width + column ];
+                }
+            }
+        }
+
+        lock_guard< mutex > guard( lock );
+        for ( size_t i = 0; i < n; ++i ) scope->counts[ i ] += local[ i ] + local[ n + i ];
+    } );
+
+    return scope;
+}
+
+void ScopeNode::update( const Surface32fRef & image )
+{
+    out< 0 >().update( analyze( *image, mFormat ) );
+}
+
+void ScopeNode::setupGpu()
+{
+    auto fmt = gl::GlslProg::Format().vertex( VERT ).fragment( FRAG );
+    switch ( mFormat.getType() ) {
+        case ScopeType::HISTOGRAM: fmt.define( "CHANNELS", "4" ); break;
+        case ScopeType::WAVEFORM: fmt.define( "CHANNELS", "4" ).define( "WAVEFORM" ); break;
+        case ScopeType::VECTORSCOPE: fmt.define( "CHANNELS", "1" ).define( "VECTORSCOPE" ); break;
+    }
+    mShader = gl::GlslProg::create( fmt );
+    mVao = gl::Vao::create();
+
+    int width = std::max( mFormat.getWidth(), 1 );
+    int height = mFormat.getType() == ScopeType::HISTOGRAM ? 1 : std::max( mFormat.getHeight(), 1 );
+    auto texFormat = gl::Texture2d::Format()
+        .internalFormat( GL_RGBA32F )
+        .minFilter( GL_NEAREST )
+        .magFilter( GL_NEAREST );
+    mFbo = gl::Fbo::create( width, height, gl::Fbo::Format().colorTexture( texFormat ).disableDepth() );
+
+    // each axis has as many bins as the scope has pixels along it
+    mShader->uniform( "uTex", 0 );
+    mShader->uniform( "uRange", vec2( mFormat.getMin(), 1.f / std::max( mFormat.getMax() - mFormat.getMin(), 1e-6f ) ) );
+    mShader->uniform( "uScopeSize", ivec2( width, height ) );
+}
+
+void ScopeNode::update( const gl::Texture2dRef & texture )
+{
+    poll();
+    if ( mPending.size() >= MAX_PENDING ) return;
+    if ( ! mFbo ) setupGpu();
+
+    int step = std::max( mFormat.getStep(), 1 );
+    ivec2 samples = ( texture->getSize() + ivec2( step - 1 ) ) / step;
+    int channels = mFormat.getType() == ScopeType::VECTORSCOPE ? 1 : 4;
+
+    {
+        gl::ScopedFramebuffer scp_fbo( mFbo );
+        gl::ScopedViewport scp_viewport( mFbo->getSize() );
+        gl::ScopedBlend scp_blend( GL_ONE, GL_ONE );
+        gl::ScopedDepth scp_depth( false );
+        gl::ScopedGlslProg scp_shader( mShader );
+        gl::ScopedVao scp_vao( mVao );
+        gl::ScopedTextureBind scp_tex( texture, 0 );
+
+        mShader->uniform( "uSampleCount", samples );
+        mShader->uniform( "uStep", step );
+
+        gl::clear( ColorA( 0.f, 0.f, 0.f, 0.f ) );
+        gl::drawArrays( GL_POINTS, 0, samples.x * samples.y * channels );
+    }
+
+    // read the result into a buffer without waiting for it
+    size_t bytes = mFbo->getWidth() * mFbo->getHeight() * 4 * sizeof( float );
+    gl::PboRef pbo;
+    if ( mFreePbos.empty() ) {
+        pbo = gl::Pbo::create( GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ );
+    }
+    else {
+        pbo = mFreePbos.back();
+        mFreePbos.pop_back();
+    }
+
+    {
+        gl::ScopedFramebuffer scp_fbo( mFbo );
+        gl::ScopedBuffer scp_pbo( pbo );
+        glReadPixels( 0, 0, mFbo->getWidth(), mFbo->getHeight(), GL_RGBA, GL_FLOAT, nullptr );
+    }
+    mPending.push_back( { pbo, gl::Sync::create() } );
+}
+
+void ScopeNode::poll()
+{
+    while ( ! mPending.empty() ) {
+        Readback & readback = mPending.front();
+        GLenum status = readback.sync->clientWaitSync();
+        if ( status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED ) break;
+
+        auto scope = make_shared< Scope >();
+        scope->type = mFormat.getType();
+        scope->width = mFbo->getWidth();
+        scope->height = mFbo->getHeight();
+        scope->channels = scope->type == ScopeType::VECTORSCOPE ? 1 : 4;
+        scope->counts.resize( (size_t)scope->channels * scope->width * scope->height );
+
+        size_t cells = (size_t)scope->width * scope->height;
+        auto data = (const float *)readback.pbo->mapBufferRange( 0, cells * 4 * sizeof( float ), GL_MAP_READ_BIT );
+        if ( data ) {
+            for ( int c = 0; c < scope->channels; ++c ) {
+                for ( size_t i = 0; i < cells; ++i ) {
+                    scope->counts[ c * cells + i ] = (uint32_t)data[ 4 * i + c ];
+                }
+            }
+        }
+        readback.pbo->unmap();
+
+        mFreePbos.push_back( readback.pbo );
+        mPending.pop_front();
+
+        if ( data ) out< 0 >().update( scope );
+    }
+}
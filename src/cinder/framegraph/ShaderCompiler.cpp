@@ -0,0 +1,128 @@
+#include "cinder/framegraph/ShaderCompiler.hpp"
+#include "cinder/framegraph/ProgramBinaryCache.hpp"
+#include "cinder/gl/gl.h"
+#include "cinder/Thread.h"
+#include "cinder/Log.h"
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+// ShaderCompiler
+
+ShaderCompiler & ShaderCompiler::instance()
+{
+    static ShaderCompiler compiler;
+    return compiler;
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+    {
+        lock_guard< mutex > lock( mMutex );
+        mStop = true;
+    }
+    mCondition.notify_all();
+    if ( mThread.joinable() ) mThread.join();
+}
+
+GlslProgFuture ShaderCompiler::compileAsync( const gl::GlslProg::Format & format )
+{
+    promise< gl::GlslProgRef > result;
+    GlslProgFuture future = result.get_future().share();
+
+    if ( ! mEnabled || ! start() ) {
+        try {
+            result.set_value( ProgramBinaryCache::instance().create( format ) );
+        }
+        catch ( ... ) {
+            result.set_exception( current_exception() );
+        }
+        return future;
+    }
+
+    auto shared = make_shared< promise< gl::GlslProgRef > >( std::move( result ) );
+    {
+        lock_guard< mutex > lock( mMutex );
+        mJobs.push_back( [shared, format] {
+            try {
+                auto shader = ProgramBinaryCache::instance().create( format );
+                // the program is only safe to use from the render context
+                // once the driver is done with it
+                glFinish();
+                shared->set_value( shader );
+            }
+            catch ( ... ) {
+                shared->set_exception( current_exception() );
+            }
+        } );
+    }
+    mCondition.notify_one();
+    return future;
+}
+
+bool ShaderCompiler::submit( function< void() > task )
+{
+    if ( ! mEnabled || ! start() ) return false;
+
+    {
+        lock_guard< mutex > lock( mMutex );
+        mJobs.push_back( std::move( task ) );
+    }
+    mCondition.notify_one();
+    return true;
+}
+
+bool ShaderCompiler::start()
+{
+    if ( mThread.joinable() ) return true;
+    if ( mFailed || ! gl::context() ) return false;
+
+    // the context has to be created on the thread whose context it shares
+    gl::ContextRef context;
+    try {
+        context = gl::Context::create( gl::context() );
+    }
+    catch ( const std::exception & e ) {
+        CI_LOG_EXCEPTION( "Compiling shaders synchronously, couldn't create a shared context", e );
+    }
+    if ( ! context ) {
+        mFailed = true;
+        return false;
+    }
+
+    // creating a context can make it current
+    gl::context()->makeCurrent();
+
+    mThread = thread( &ShaderCompiler::run, this, context );
+    return true;
+}
+
+void ShaderCompiler::run( gl::ContextRef context )
+{
+    ThreadSetup threadSetup;
+    context->makeCurrent();
+
+    while ( true ) {
+        function< void() > job;
+        {
+            unique_lock< mutex > lock( mMutex );
+            mCondition.wait( lock, [&] { return mStop || ! mJobs.empty(); } );
+            if ( mStop ) break;
+            job = std::move( mJobs.front() );
+            mJobs.pop_front();
+        }
+
+        try {
+            job();
+        }
+        catch ( const std::exception & e ) {
+            CI_LOG_EXCEPTION( "Background GL task failed", e );
+        }
+    }
+
+    // unfinished compiles fail with a broken promise
+    lock_guard< mutex > lock( mMutex );
+    mJobs.clear();
+}
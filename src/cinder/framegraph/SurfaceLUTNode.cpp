@@ -0,0 +1,326 @@
+#include "cinder/framegraph/SurfaceLUTNode.hpp"
+#include "cinder/framegraph/SurfacePool.hpp"
+#include "cinder/framegraph/ThreadPool.hpp"
+#include <chrono>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+#include <immintrin.h>
+#if defined( __GNUC__ ) || defined( __clang__ )
+#define FG_LUT_AVX2 1
+#define FG_TARGET_AVX2 __attribute__(( target( "avx2" ) ))
+#elif defined( __AVX2__ )
+#define FG_LUT_AVX2 1
+#define FG_TARGET_AVX2
+#endif
+#endif
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+
+//! Rows per task on the thread pool.
+const size_t ROW_GRAIN = 16;
+
+//! Everything a kernel needs to process a band of rows.
+struct Job {
+    const Surface32f *      src;
+    Surface32f *            dst;
+    const Lut3d *           lut3d;
+    const Lut1d *           lut1d;
+    const float *           planes3d;
+    const float *           planes1d;
+    Lut3d::Interpolation    interpolation;
+};
+
+vec3 lookup( const Job & job, vec3 c )
+{
+    if ( job.lut1d ) c = job.lut1d->lookup( c );
+    if ( job.lut3d ) c = job.lut3d->lookup( c, job.interpolation );
+    return c;
+}
+
+//! Processes pixels [x0, width) of row y with the scalar reference path.
+void processScalar( const Job & job, int32_t y, int32_t x0 )
+{
+    const Surface32f & src = *job.src;
+    Surface32f & dst = *job.dst;
+
+    const float * s = src.getData( ivec2( x0, y ) );
+    float * d = dst.getData( ivec2( x0, y ) );
+    uint8_t sInc = src.getPixelInc(), dInc = dst.getPixelInc();
+    bool alpha = src.hasAlpha() && dst.hasAlpha();
+
+    for ( int32_t x = x0; x < src.getWidth(); ++x, s += sInc, d += dInc ) {
+        vec3 c = lookup( job, vec3( s[ src.getRedOffset() ], s[ src.getGreenOffset() ], s[ src.getBlueOffset() ] ) );
+        d[ dst.getRedOffset() ] = c.r;
+        d[ dst.getGreenOffset() ] = c.g;
+        d[ dst.getBlueOffset() ] = c.b;
+        if ( alpha ) d[ dst.getAlphaOffset() ] = s[ src.getAlphaOffset() ];
+    }
+}
+
+#if defined( FG_LUT_AVX2 )
+
+bool hasAvx2()
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return __builtin_cpu_supports( "avx2" );
+#else
+    return true;
+#endif
+}
+
+//! Maps one channel of eight pixels to lattice coordinates in [0, n - 1].
+FG_TARGET_AVX2 inline __m256 toLattice( __m256 c, float min, float max, int n )
+{
+    __m256 x = _mm256_mul_ps( _mm256_sub_ps( c, _mm256_set1_ps( min ) ), _mm256_set1_ps( 1.f / ( max - min ) ) );
+    // max returns its second operand if either is NaN, so NaN maps to 0 like
+    // in Lut3d and never reaches the index conversion
+    x = _mm256_min_ps( _mm256_max_ps( x, _mm256_setzero_ps() ), _mm256_set1_ps( 1.f ) );
+    return _mm256_mul_ps( x, _mm256_set1_ps( (float)( n - 1 ) ) );
+}
+
+//! Splits lattice coordinates into a cell index in [0, n - 2] and a fraction.
+FG_TARGET_AVX2 inline __m256i splitLattice( __m256 x, int n, __m256 * f )
+{
+    __m256 i0 = _mm256_min_ps( _mm256_floor_ps( x ), _mm256_set1_ps( (float)( n - 2 ) ) );
+    *f = _mm256_sub_ps( x, i0 );
+    return _mm256_cvttps_epi32( i0 );
+}
+
+FG_TARGET_AVX2 inline __m256 lerp( __m256 a, __m256 b, __m256 t )
+{
+    return _mm256_add_ps( a, _mm256_mul_ps( t, _mm256_sub_ps( b, a ) ) );
+}
+
+FG_TARGET_AVX2 inline __m256i selectIndex( __m256 mask, __m256i a, __m256i b )
+{
+    return _mm256_blendv_epi8( b, a, _mm256_castps_si256( mask ) );
+}
+
+FG_TARGET_AVX2 void apply1d( const Job & job, __m256 * c )
+{
+    const Lut1d & lut = *job.lut1d;
+    int n = lut.getSize();
+    for ( int i = 0; i < 3; ++i ) {
+        const float * plane = job.planes1d + i * n;
+        __m256 f;
+        __m256i i0 = splitLattice( toLattice( c[ i ], lut.getDomainMin()[ i ], lut.getDomainMax()[ i ], n ), n, &f );
+        __m256 v0 = _mm256_i32gather_ps( plane, i0, 4 );
+        __m256 v1 = _mm256_i32gather_ps( plane, _mm256_add_epi32( i0, _mm256_set1_epi32( 1 ) ), 4 );
+        c[ i ] = lerp( v0, v1, f );
+    }
+}
+
+FG_TARGET_AVX2 void apply3d( const Job & job, __m256 * c )
+{
+    const Lut3d & lut = *job.lut3d;
+    int n = lut.getSize();
+    size_t planeSize = (size_t)n * n * n;
+
+    __m256 fr, fg, fb;
+    __m256i ir = splitLattice( toLattice( c[ 0 ], lut.getDomainMin().r, lut.getDomainMax().r, n ), n, &fr );
+    __m256i ig = splitLattice( toLattice( c[ 1 ], lut.getDomainMin().g, lut.getDomainMax().g, n ), n, &fg );
+    __m256i ib = splitLattice( toLattice( c[ 2 ], lut.getDomainMin().b, lut.getDomainMax().b, n ), n, &fb );
+
+    __m256i sr = _mm256_set1_epi32( 1 );
+    __m256i sg = _mm256_set1_epi32( n );
+    __m256i sb = _mm256_set1_epi32( n * n );
+    __m256i base = _mm256_add_epi32( ir, _mm256_add_epi32( _mm256_mullo_epi32( ig, sg ), _mm256_mullo_epi32( ib, sb ) ) );
+
+    if ( job.interpolation == Lut3d::Interpolation::TETRAHEDRAL ) {
+        // the tetrahedron is chosen by sorting the fractions, its corners are
+        // the origin, one step along the largest axis, one step back from the
+        // far corner along the smallest axis, and the far corner
+        __m256 rIsMax = _mm256_and_ps( _mm256_cmp_ps( fr, fg, _CMP_GE_OQ ), _mm256_cmp_ps( fr, fb, _CMP_GE_OQ ) );
+        __m256 gIsMax = _mm256_andnot_ps( rIsMax, _mm256_cmp_ps( fg, fb, _CMP_GE_OQ ) );
+        __m256 rIsMin = _mm256_and_ps( _mm256_cmp_ps( fr, fg, _CMP_LT_OQ ), _mm256_cmp_ps( fr, fb, _CMP_LT_OQ ) );
+        __m256 gIsMin = _mm256_andnot_ps( rIsMin, _mm256_cmp_ps( fg, fb, _CMP_LT_OQ ) );
+
+        __m256i sMax = selectIndex( rIsMax, sr, selectIndex( gIsMax, sg, sb ) );
+        __m256i sMin = selectIndex( rIsMin, sr, selectIndex( gIsMin, sg, sb ) );
+        __m256i sAll = _mm256_add_epi32( sr, _mm256_add_epi32( sg, sb ) );
+
+        __m256i i1 = _mm256_add_epi32( base, sMax );
+        __m256i i2 = _mm256_add_epi32( base, _mm256_sub_epi32( sAll, sMin ) );
+        __m256i i3 = _mm256_add_epi32( base, sAll );
+
+        __m256 fMax = _mm256_max_ps( fr, _mm256_max_ps( fg, fb ) );
+        __m256 fMin = _mm256_min_ps( fr, _mm256_min_ps( fg, fb ) );
+        __m256 fMid = _mm256_sub_ps( _mm256_add_ps( fr, _mm256_add_ps( fg, fb ) ), _mm256_add_ps( fMax, fMin ) );
+
+        __m256 w0 = _mm256_sub_ps( _mm256_set1_ps( 1.f ), fMax );
+        __m256 w1 = _mm256_sub_ps( fMax, fMid );
+        __m256 w2 = _mm256_sub_ps( fMid, fMin );
+        __m256 w3 = fMin;
+
+        for ( int i = 0; i < 3; ++i ) {
+            const float * plane = job.planes3d + i * planeSize;
+            __m256 v = _mm256_mul_ps( w0, _mm256_i32gather_ps( plane, base, 4 ) );
+            v = _mm256_add_ps( v, _mm256_mul_ps( w1, _mm256_i32gather_ps( plane, i1, 4 ) ) );
+            v = _mm256_add_ps( v, _mm256_mul_ps( w2, _mm256_i32gather_ps( plane, i2, 4 ) ) );
+            v = _mm256_add_ps( v, _mm256_mul_ps( w3, _mm256_i32gather_ps( plane, i3, 4 ) ) );
+            c[ i ] = v;
+        }
+    }
+    else {
+        __m256i i100 = _mm256_add_epi32( base, sr );
+        __m256i i010 = _mm256_add_epi32( base, sg );
+        __m256i i110 = _mm256_add_epi32( i010, sr );
+        __m256i i001 = _mm256_add_epi32( base, sb );
+        __m256i i101 = _mm256_add_epi32( i001, sr );
+        __m256i i011 = _mm256_add_epi32( i001, sg );
+        __m256i i111 = _mm256_add_epi32( i011, sr );
+
+        for ( int i = 0; i < 3; ++i ) {
+            const float * plane = job.planes3d + i * planeSize;
+            __m256 c00 = lerp( _mm256_i32gather_ps( plane, base, 4 ), _mm256_i32gather_ps( plane, i100, 4 ), fr );
+            __m256 c10 = lerp( _mm256_i32gather_ps( plane, i010, 4 ), _mm256_i32gather_ps( plane, i110, 4 ), fr );
+            __m256 c01 = lerp( _mm256_i32gather_ps( plane, i001, 4 ), _mm256_i32gather_ps( plane, i101, 4 ), fr );
+            __m256 c11 = lerp( _mm256_i32gather_ps( plane, i011, 4 ), _mm256_i32gather_ps( plane, i111, 4 ), fr );
+            c[ i ] = lerp( lerp( c00, c10, fg ), lerp( c01, c11, fg ), fb );
+        }
+    }
+}
+
+FG_TARGET_AVX2 void processAvx2( const Job & job, int32_t y )
+{
+    const Surface32f & src = *job.src;
+    Surface32f & dst = *job.dst;
+
+    const float * s = src.getData( ivec2( 0, y ) );
+    float * d = dst.getData( ivec2( 0, y ) );
+    uint8_t sInc = src.getPixelInc(), dInc = dst.getPixelInc();
+    uint8_t sOffsets[ 3 ] = { src.getRedOffset(), src.getGreenOffset(), src.getBlueOffset() };
+    uint8_t dOffsets[ 3 ] = { dst.getRedOffset(), dst.getGreenOffset(), dst.getBlueOffset() };
+    bool alpha = src.hasAlpha() && dst.hasAlpha();
+
+    __m256i lanes = _mm256_mullo_epi32( _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 ), _mm256_set1_epi32( sInc ) );
+    alignas( 32 ) float out[ 3 ][ 8 ];
+
+    int32_t width = src.getWidth();
+    int32_t x = 0;
+    for ( ; x + 8 <= width; x += 8, s += 8 * sInc ) {
+        __m256 c[ 3 ];
+        for ( int i = 0; i < 3; ++i ) c[ i ] = _mm256_i32gather_ps( s + sOffsets[ i ], lanes, 4 );
+
+        if ( job.lut1d ) apply1d( job, c );
+        if ( job.lut3d ) apply3d( job, c );
+
+        for ( int i = 0; i < 3; ++i ) _mm256_store_ps( out[ i ], c[ i ] );
+
+        for ( int j = 0; j < 8; ++j, d += dInc ) {
+            for ( int i = 0; i < 3; ++i ) d[ dOffsets[ i ] ] = out[ i ][ j ];
+            if ( alpha ) d[ dst.getAlphaOffset() ] = s[ j * sInc + src.getAlphaOffset() ];
+        }
+    }
+
+    if ( x < width ) processScalar( job, y, x );
+}
+
+#endif
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SurfaceLUTNode
+
+SurfaceLUTNode::SurfaceLUTNode( const Format & format ) :
+mFormat( format )
+{
+    in< 0 >().onReceive( [&]( const Surface32fRef & image ) {
+        update( image );
+    } );
+    in< 1 >().onReceive( [&]( const Surface32fRef & atlas ) {
+        updateAtlas( atlas );
+    } );
+    in< 2 >().onReceive( [&]( const Lut3dRef & lut ) {
+        setLUT( lut );
+    } );
+    in< 3 >().onReceive( [&]( const Lut1dRef & lut ) {
+        setLUT( lut );
+    } );
+}
+
+void SurfaceLUTNode::setLUT( const Lut3dRef & lut )
+{
+    if ( lut == mLut3d ) return;
+    mLut3d = lut;
+    mPlanes3d.clear();
+    if ( ! lut ) return;
+
+    size_t planeSize = lut->getData().size() / 3;
+    mPlanes3d.resize( lut->getData().size() );
+    for ( size_t i = 0; i < planeSize; ++i ) {
+        for ( size_t c = 0; c < 3; ++c ) mPlanes3d[ c * planeSize + i ] = lut->getData()[ 3 * i + c ];
+    }
+}
+
+void SurfaceLUTNode::setLUT( const Lut1dRef & lut )
+{
+    if ( lut == mLut1d ) return;
+    mLut1d = lut;
+    mPlanes1d.clear();
+    if ( ! lut ) return;
+
+    size_t size = lut->getSize();
+    mPlanes1d.resize( 3 * size );
+    for ( size_t i = 0; i < size; ++i ) {
+        for ( size_t c = 0; c < 3; ++c ) mPlanes1d[ c * size + i ] = lut->getData()[ 3 * i + c ];
+    }
+}
+
+void SurfaceLUTNode::updateAtlas( const Surface32fRef & atlas )
+{
+    if ( atlas == mAtlas ) return;
+    mAtlas = atlas;
+    setLUT( make_shared< Lut3d >( Lut3d::createFromAtlas( *atlas, mFormat.getAtlasSize() ) ) );
+}
+
+bool SurfaceLUTNode::isSimdActive() const
+{
+#if defined( FG_LUT_AVX2 )
+    return mFormat.isSimd() && hasAvx2();
+#else
+    return false;
+#endif
+}
+
+void SurfaceLUTNode::update( const Surface32fRef & image )
+{
+    if ( ! mLut3d && ! mLut1d ) {
+        out< 0 >().update( image );
+        return;
+    }
+
+    // reuse the previous output unless a downstream node is holding on to it
+    if ( ! mOutput || mOutput.use_count() > 1 || mOutput->getSize() != image->getSize() || mOutput->hasAlpha() != image->hasAlpha() ) {
+        mOutput = SurfacePool::instance().get( image->getWidth(), image->getHeight(), image->hasAlpha() );
+    }
+
+    Job job{ image.get(), mOutput.get(), mLut3d.get(), mLut1d.get(), mPlanes3d.data(), mPlanes1d.data(), mFormat.getInterpolation() };
+#if defined( FG_LUT_AVX2 )
+    bool simd = isSimdActive();
+#endif
+
+    auto start = chrono::steady_clock::now();
+
+    ThreadPool::instance().parallelFor( image->getHeight(), ROW_GRAIN, [&]( size_t begin, size_t end ) {
+        for ( size_t y = begin; y < end; ++y ) {
+#if defined( FG_LUT_AVX2 )
+            if ( simd ) {
+                processAvx2( job, (int32_t)y );
+                continue;
+            }
+#endif
+            processScalar( job, (int32_t)y, 0 );
+        }
+    } );
+
+    chrono::duration< double > elapsed = chrono::steady_clock::now() - start;
+    mMegapixelsPerSecond = image->getWidth() * image->getHeight() / std::max( elapsed.count(), 1e-9 ) / 1e6;
+
+    out< 0 >().update( mOutput );
+}
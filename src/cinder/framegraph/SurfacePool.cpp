@@ -0,0 +1,229 @@
+#include "cinder/framegraph/SurfacePool.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#if defined( __linux__ )
+#include <sys/mman.h>
+#endif
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+
+const size_t HUGE_PAGE_SIZE = size_t( 2 ) << 20;
+const size_t SMALL_CLASS_SIZE = size_t( 64 ) << 10;
+
+size_t roundUp( size_t bytes, size_t multiple )
+{
+    return ( bytes + multiple - 1 ) / multiple * multiple;
+}
+
+}
+
+//! Allocates the surfaces and their shared_ptr control blocks from the
+//! pool's wrapper lists. It keeps the pool alive until the control block
+//! itself has been freed.
+template< typename T >
+class SurfacePool::WrapperAllocator
+{
+public:
+    typedef T value_type;
+
+    explicit WrapperAllocator( const SurfacePoolRef & pool ) : mPool( pool ) {}
+    template< typename U >
+    WrapperAllocator( const WrapperAllocator< U > & other ) : mPool( other.mPool ) {}
+
+    T * allocate( size_t n ) { return static_cast< T * >( mPool->acquireWrapper( n * sizeof( T ) ) ); }
+    void deallocate( T * p, size_t n ) { mPool->releaseWrapper( p, n * sizeof( T ) ); }
+
+    template< typename U >
+    bool operator==( const WrapperAllocator< U > & other ) const { return mPool == other.mPool; }
+    template< typename U >
+    bool operator!=( const WrapperAllocator< U > & other ) const { return mPool != other.mPool; }
+
+private:
+    template< typename U > friend class WrapperAllocator;
+
+    SurfacePoolRef mPool;
+};
+
+//! A surface over a pooled block, returned to the pool on destruction.
+class SurfacePool::PooledSurface : public Surface32f
+{
+public:
+    PooledSurface( SurfacePool * pool, const Block & block, size_t sizeClass, int32_t width, int32_t height, ptrdiff_t rowBytes, bool alpha ) :
+            Surface32f( static_cast< float * >( block.data ), width, height, rowBytes, alpha ? SurfaceChannelOrder::RGBA : SurfaceChannelOrder::RGB ),
+            mPool( pool ),
+            mBlock( block ),
+            mSizeClass( sizeClass )
+    {
+    }
+
+    ~PooledSurface()
+    {
+        mPool->release( mBlock, mSizeClass );
+    }
+
+private:
+    // kept alive by the allocator in the same control block
+    SurfacePool *   mPool;
+    Block           mBlock;
+    size_t          mSizeClass;
+};
+
+SurfacePool & SurfacePool::instance()
+{
+    // surfaces still referenced at exit keep the pool alive themselves
+    static SurfacePoolRef sPool = create();
+    return *sPool;
+}
+
+SurfacePool::SurfacePool( const Format & format ) :
+        mFormat( format )
+{
+}
+
+SurfacePool::~SurfacePool()
+{
+    trim();
+    for ( auto & entry : mWrappers ) {
+        for ( void * wrapper : entry.second ) ::operator delete( wrapper );
+    }
+}
+
+size_t SurfacePool::getSizeClass( size_t bytes )
+{
+    // powers of two for small frames, then 64 KB steps up to the huge page
+    // size and whole huge pages beyond, wasting at most a page per frame
+    if ( bytes <= SMALL_CLASS_SIZE ) {
+        size_t size = 4096;
+        while ( size < bytes ) size <<= 1;
+        return size;
+    }
+    return roundUp( bytes, bytes < HUGE_PAGE_SIZE ? SMALL_CLASS_SIZE : HUGE_PAGE_SIZE );
+}
+
+Surface32fRef SurfacePool::get( int32_t width, int32_t height, bool alpha )
+{
+    ptrdiff_t rowBytes = width * ( alpha ? 4 : 3 ) * sizeof( float );
+    size_t sizeClass = getSizeClass( std::max< size_t >( rowBytes * height, 1 ) );
+    Block block = acquire( sizeClass );
+
+    try {
+        WrapperAllocator< PooledSurface > allocator( shared_from_this() );
+        return allocate_shared< PooledSurface >( allocator, this, block, sizeClass, width, height, rowBytes, alpha );
+    }
+    catch ( ... ) {
+        release( block, sizeClass );
+        throw;
+    }
+}
+
+SurfacePool::Block SurfacePool::acquire( size_t sizeClass )
+{
+    {
+        lock_guard< mutex > lock( mMutex );
+        auto it = mFree.find( sizeClass );
+        if ( it != mFree.end() && ! it->second.empty() ) {
+            Block block = it->second.back();
+            it->second.pop_back();
+            mStats.cachedBytes -= sizeClass;
+            ++mStats.reuses;
+            return block;
+        }
+        ++mStats.allocations;
+    }
+
+    // allocate outside the lock, so a page fault storm in one thread doesn't
+    // stall the others
+    Block block = allocateBlock( sizeClass );
+    if ( ! block.data ) throw bad_alloc();
+
+    if ( mFormat.getPrefault() ) {
+        volatile uint8_t * bytes = static_cast< uint8_t * >( block.data );
+        for ( size_t i = 0; i < sizeClass; i += 4096 ) bytes[ i ] = 0;
+    }
+    return block;
+}
+
+void SurfacePool::release( const Block & block, size_t sizeClass )
+{
+    {
+        lock_guard< mutex > lock( mMutex );
+        if ( mStats.cachedBytes + sizeClass <= mFormat.getMaxCachedBytes() ) {
+            mFree[ sizeClass ].push_back( block );
+            mStats.cachedBytes += sizeClass;
+            return;
+        }
+    }
+    freeBlock( block, sizeClass );
+}
+
+SurfacePool::Block SurfacePool::allocateBlock( size_t sizeClass )
+{
+#if defined( __linux__ )
+    if ( mFormat.getHugePages() && sizeClass >= HUGE_PAGE_SIZE ) {
+        void * data = mmap( nullptr, sizeClass, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if ( data != MAP_FAILED ) {
+#if defined( MADV_HUGEPAGE )
+            madvise( data, sizeClass, MADV_HUGEPAGE );
+#endif
+            return Block{ data, true };
+        }
+    }
+#endif
+    return Block{ std::malloc( sizeClass ), false };
+}
+
+void SurfacePool::freeBlock( const Block & block, size_t sizeClass )
+{
+#if defined( __linux__ )
+    if ( block.mapped ) {
+        munmap( block.data, sizeClass );
+        return;
+    }
+#endif
+    std::free( block.data );
+}
+
+void * SurfacePool::acquireWrapper( size_t bytes )
+{
+    {
+        lock_guard< mutex > lock( mMutex );
+        auto it = mWrappers.find( bytes );
+        if ( it != mWrappers.end() && ! it->second.empty() ) {
+            void * wrapper = it->second.back();
+            it->second.pop_back();
+            return wrapper;
+        }
+    }
+    return ::operator new( bytes );
+}
+
+void SurfacePool::releaseWrapper( void * wrapper, size_t bytes )
+{
+    lock_guard< mutex > lock( mMutex );
+    mWrappers[ bytes ].push_back( wrapper );
+}
+
+void SurfacePool::trim()
+{
+    map< size_t, vector< Block > > blocks;
+    {
+        lock_guard< mutex > lock( mMutex );
+        blocks.swap( mFree );
+        mStats.cachedBytes = 0;
+    }
+    for ( auto & entry : blocks ) {
+        for ( auto & block : entry.second ) freeBlock( block, entry.first );
+    }
+}
+
+SurfacePool::Stats SurfacePool::getStats() const
+{
+    lock_guard< mutex > lock( mMutex );
+    return mStats;
+}
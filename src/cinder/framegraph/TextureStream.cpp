@@ -0,0 +1,161 @@
+#include "cinder/framegraph/TextureStream.hpp"
+#include "cinder/gl/gl.h"
+#include "cinder/gl/scoped.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+
+size_t getChannels( GLenum format )
+{
+    return format == GL_RGB || format == GL_BGR ? 3 : 4;
+}
+
+size_t getChannelBytes( GLenum type )
+{
+    switch ( type ) {
+        case GL_UNSIGNED_BYTE: return 1;
+        case GL_HALF_FLOAT: return 2;
+        default: return 4;
+    }
+}
+
+GLint getInternalFormat( GLenum format, GLenum type )
+{
+    bool alpha = getChannels( format ) == 4;
+    switch ( type ) {
+        case GL_UNSIGNED_BYTE: return alpha ? GL_RGBA8 : GL_RGB8;
+        case GL_HALF_FLOAT: return alpha ? GL_RGBA16F : GL_RGB16F;
+        default: return alpha ? GL_RGBA32F : GL_RGB32F;
+    }
+}
+
+}
+
+TextureStream::TextureStream( size_t buffers ) :
+        mBuffers( std::max< size_t >( buffers, 1 ) )
+{
+}
+
+TextureStream::~TextureStream()
+{
+    release();
+}
+
+void TextureStream::release()
+{
+    for ( auto & b : mBuffers ) {
+        if ( b.fence ) glDeleteSync( b.fence );
+        if ( b.id ) {
+            if ( b.mapped ) {
+                gl::ScopedBuffer scp_buf( GL_PIXEL_UNPACK_BUFFER, b.id );
+                glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+            }
+            glDeleteBuffers( 1, &b.id );
+        }
+        b = Buffer();
+    }
+    mBufferSize = 0;
+}
+
+void TextureStream::allocate( size_t bytes )
+{
+    release();
+
+    mPersistent = false;
+#if defined( GL_MAP_PERSISTENT_BIT )
+    mPersistent = gl::isExtensionAvailable( "GL_ARB_buffer_storage" );
+#endif
+
+    for ( auto & b : mBuffers ) {
+        glGenBuffers( 1, &b.id );
+        gl::ScopedBuffer scp_buf( GL_PIXEL_UNPACK_BUFFER, b.id );
+#if defined( GL_MAP_PERSISTENT_BIT )
+        if ( mPersistent ) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage( GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, flags );
+            b.mapped = glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, bytes, flags );
+            continue;
+        }
+#endif
+        glBufferData( GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW );
+    }
+    mBufferSize = bytes;
+}
+
+const gl::Texture2dRef & TextureStream::upload( const void * data, const ivec2 & size, GLenum format, GLenum type, ptrdiff_t rowBytes )
+{
+    size_t packedRowBytes = size.x * getChannels( format ) * getChannelBytes( type );
+    size_t bytes = packedRowBytes * size.y;
+
+    if ( ! mTexture || mTexture->getSize() != size || mFormat != format || mType != type ) {
+        GLint internalFormat = getInternalFormat( format, type );
+        mTexture = gl::Texture2d::create( size.x, size.y, gl::Texture2d::Format().internalFormat( internalFormat ).dataType( type ) );
+        mTexture->setTopDown( true );
+        mFormat = format;
+        mType = type;
+    }
+    if ( bytes > mBufferSize ) allocate( bytes );
+
+    Buffer & b = mBuffers[ mNext ];
+    mNext = ( mNext + 1 ) % mBuffers.size();
+
+    // the GPU may still be reading this buffer from a few frames ago
+    if ( b.fence ) {
+        glClientWaitSync( b.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000 );
+        glDeleteSync( b.fence );
+        b.fence = nullptr;
+    }
+
+    gl::ScopedBuffer scp_buf( GL_PIXEL_UNPACK_BUFFER, b.id );
+    uint8_t * dst = (uint8_t *)( mPersistent ? b.mapped : glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT ) );
+    if ( ! dst ) return mTexture;
+
+    // the only copy: packed rows straight into GL memory
+    const uint8_t * src = (const uint8_t *)data;
+    if ( (size_t)rowBytes == packedRowBytes ) {
+        memcpy( dst, src, bytes );
+    }
+    else {
+        for ( int y = 0; y < size.y; ++y ) memcpy( dst + y * packedRowBytes, src + y * rowBytes, packedRowBytes );
+    }
+    if ( ! mPersistent ) glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+
+    {
+        gl::ScopedTextureBind scp_tex( mTexture, 0 );
+        glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+        glTexSubImage2D( mTexture->getTarget(), 0, 0, 0, size.x, size.y, format, type, nullptr );
+        glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+    }
+    b.fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+
+    return mTexture;
+}
+
+template< typename T >
+gl::Texture2dRef TextureStream::uploadSurface( const SurfaceT< T > & surface, GLenum type )
+{
+    GLenum format;
+    switch ( surface.getChannelOrder().getCode() ) {
+        case SurfaceChannelOrder::RGBA: format = GL_RGBA; break;
+        case SurfaceChannelOrder::BGRA: format = GL_BGRA; break;
+        case SurfaceChannelOrder::RGB: format = GL_RGB; break;
+        case SurfaceChannelOrder::BGR: format = GL_BGR; break;
+        default: return nullptr;
+    }
+    return upload( surface.getData(), surface.getSize(), format, type, surface.getRowBytes() );
+}
+
+gl::Texture2dRef TextureStream::upload( const Surface8u & surface )
+{
+    return uploadSurface( surface, GL_UNSIGNED_BYTE );
+}
+
+gl::Texture2dRef TextureStream::upload( const Surface32f & surface )
+{
+    return uploadSurface( surface, GL_FLOAT );
+}
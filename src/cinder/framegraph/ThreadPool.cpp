@@ -0,0 +1,174 @@
+#include "cinder/framegraph/ThreadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+using namespace cinder;
+using namespace frame_graph;
+using namespace std;
+
+ThreadPool & ThreadPool::instance()
+{
+    static ThreadPool sPool( std::max( 1u, thread::hardware_concurrency() ) );
+    return sPool;
+}
+
+ThreadPool::ThreadPool( size_t numThreads )
+{
+    for ( size_t i = 0; i < numThreads; ++i ) {
+        mWorkers.emplace_back( &ThreadPool::run, this );
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard< mutex > lock( mMutex );
+        mStop = true;
+    }
+    mCV.notify_all();
+
+    for ( auto & worker : mWorkers ) {
+        if ( worker.joinable() ) worker.join();
+    }
+}
+
+future< void > ThreadPool::submit( function< void() > task )
+{
+    packaged_task< void() > packaged( move( task ) );
+    auto f = packaged.get_future();
+    {
+        lock_guard< mutex > lock( mMutex );
+        mTasks.push_back( move( packaged ) );
+    }
+    mCV.notify_one();
+    return f;
+}
+
+struct ThreadPool::Job {
+    Range               range;
+    size_t              n;
+    size_t              grain;
+    size_t              numChunks;
+    atomic< size_t >    next{ 0 };
+    atomic< bool >      failed{ false };
+    //! Helpers still to start, guarded by the pool's mutex. The job stays
+    //! linked into the pool's list while this is nonzero.
+    size_t              helpersWanted;
+    Job *               nextJob = nullptr;
+    //! Helpers running, guarded by lock.
+    size_t              active = 0;
+    exception_ptr       error;
+    mutex               lock;
+    condition_variable  cv;
+};
+
+void ThreadPool::dispatch( size_t n, size_t grain, const Range & range )
+{
+    if ( n == 0 ) return;
+    grain = std::max< size_t >( grain, 1 );
+    size_t numChunks = ( n + grain - 1 ) / grain;
+
+    if ( numChunks == 1 || mWorkers.empty() ) {
+        range.call( range.context, 0, n );
+        return;
+    }
+
+    Job job;
+    job.range = range;
+    job.n = n;
+    job.grain = grain;
+    job.numChunks = numChunks;
+    size_t numHelpers = std::min( numChunks - 1, mWorkers.size() );
+    job.helpersWanted = numHelpers;
+
+    {
+        lock_guard< mutex > lock( mMutex );
+        if ( mJobsTail ) mJobsTail->nextJob = &job;
+        else mJobs = &job;
+        mJobsTail = &job;
+    }
+    for ( size_t i = 0; i < numHelpers; ++i ) mCV.notify_one();
+
+    work( job );
+
+    // Every chunk has been claimed, so helpers that haven't started yet have
+    // nothing left to do. Withdraw the job, after which only the helpers
+    // already running can touch it, and wait for them before it goes out
+    // of scope.
+    {
+        lock_guard< mutex > lock( mMutex );
+        if ( job.helpersWanted > 0 ) {
+            Job * prev = nullptr;
+            for ( Job * j = mJobs; j != &job; j = j->nextJob ) prev = j;
+            ( prev ? prev->nextJob : mJobs ) = job.nextJob;
+            if ( mJobsTail == &job ) mJobsTail = prev;
+        }
+    }
+
+    unique_lock< mutex > lock( job.lock );
+    job.cv.wait( lock, [&] { return job.active == 0; } );
+
+    // the first exception thrown by fn, once no chunk is running any more
+    if ( job.error ) rethrow_exception( job.error );
+}
+
+void ThreadPool::work( Job & job )
+{
+    for ( ;; ) {
+        size_t chunk = job.next++;
+        if ( chunk >= job.numChunks ) break;
+        if ( job.failed ) continue;
+
+        size_t begin = chunk * job.grain;
+        try {
+            job.range.call( job.range.context, begin, std::min( job.n, begin + job.grain ) );
+        }
+        catch ( ... ) {
+            lock_guard< mutex > lock( job.lock );
+            if ( ! job.error ) job.error = current_exception();
+            job.failed = true;
+        }
+    }
+}
+
+void ThreadPool::run()
+{
+    for ( ;; ) {
+        Job * job = nullptr;
+        packaged_task< void() > task;
+        {
+            unique_lock< mutex > lock( mMutex );
+            mCV.wait( lock, [&] { return mStop || mJobs || ! mTasks.empty(); } );
+            if ( mJobs ) {
+                // helping a parallelFor comes first, its caller is waiting
+                job = mJobs;
+                {
+                    lock_guard< mutex > jobLock( job->lock );
+                    ++job->active;
+                }
+                if ( --job->helpersWanted == 0 ) {
+                    mJobs = job->nextJob;
+                    if ( ! mJobs ) mJobsTail = nullptr;
+                }
+            }
+            else if ( ! mTasks.empty() ) {
+                task = move( mTasks.front() );
+                mTasks.pop_front();
+            }
+            else return;
+        }
+
+        if ( job ) {
+            work( *job );
+
+            // the caller may return as soon as active drops to zero, so the
+            // job isn't touched after unlocking
+            lock_guard< mutex > jobLock( job->lock );
+            if ( --job->active == 0 ) job->cv.notify_all();
+        }
+        else {
+            task();
+        }
+    }
+}
@@ -0,0 +1,163 @@
+#include "cinder/framegraph/Tiling.hpp"
+#include "cinder/framegraph/DeferredUpdates.hpp"
+#include "cinder/framegraph/SurfacePool.hpp"
+#include "cinder/framegraph/ThreadPool.hpp"
+#include <algorithm>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+namespace {
+    const size_t ROW_GRAIN = 32;
+
+    //! Copies \a size pixels of \a src from \a srcOrigin, clamping reads to
+    //! its edges, into \a dst at \a dstOrigin. Goes through the channel
+    //! offsets of both surfaces, so any channel order is copied correctly;
+    //! a missing source alpha is filled with 1.
+    void copyClamped( const Surface32f & src, const ivec2 & srcOrigin, Surface32f & dst, const ivec2 & dstOrigin, const ivec2 & size )
+    {
+        int srcInc = src.getPixelInc();
+        int dstInc = dst.getPixelInc();
+        int sr = src.getRedOffset(), sg = src.getGreenOffset(), sb = src.getBlueOffset();
+        int sa = src.hasAlpha() ? src.getAlphaOffset() : -1;
+        int dr = dst.getRedOffset(), dg = dst.getGreenOffset(), db = dst.getBlueOffset();
+        int da = dst.hasAlpha() ? dst.getAlphaOffset() : -1;
+        int maxX = src.getWidth() - 1;
+        int maxY = src.getHeight() - 1;
+
+        ThreadPool::instance().parallelFor( size.y, ROW_GRAIN, [&]( size_t begin, size_t end ) {
+            for ( size_t y = begin; y < end; ++y ) {
+                int sy = std::min( std::max( srcOrigin.y + (int)y, 0 ), maxY );
+                const float * s = src.getData( ivec2( 0, sy ) );
+                float * d = dst.getData( dstOrigin + ivec2( 0, (int)y ) );
+                for ( int x = 0; x < size.x; ++x, d += dstInc ) {
+                    const float * p = s + srcInc * std::min( std::max( srcOrigin.x + x, 0 ), maxX );
+                    d[ dr ] = p[ sr ];
+                    d[ dg ] = p[ sg ];
+                    d[ db ] = p[ sb ];
+                    if ( da >= 0 ) d[ da ] = sa >= 0 ? p[ sa ] : 1.f;
+                }
+            }
+        } );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TileINode
+
+TileINode::TileINode( const Surface32fRef & image, const Format & format ) :
+mImage( image ),
+mFormat( format )
+{
+}
+
+void TileINode::setImage( const Surface32fRef & image )
+{
+    mImage = image;
+}
+
+vector< Tile > TileINode::getTiles() const
+{
+    vector< Tile > tiles;
+    if ( ! mImage ) return tiles;
+
+    int size = std::max( 1, mFormat.getTileSize() );
+    ivec2 imageSize = mImage->getSize();
+
+    for ( int y = 0; y < imageSize.y; y += size ) {
+        for ( int x = 0; x < imageSize.x; x += size ) {
+            Tile tile;
+            tile.bounds = Area( x, y, std::min( x + size, imageSize.x ), std::min( y + size, imageSize.y ) );
+            tile.offset = ivec2( mFormat.getHalo() );
+            tile.imageSize = imageSize;
+            tiles.push_back( tile );
+        }
+    }
+
+    for ( size_t i = 0; i < tiles.size(); ++i ) {
+        tiles[ i ].index = i;
+        tiles[ i ].count = tiles.size();
+    }
+    return tiles;
+}
+
+void TileINode::update()
+{
+    for ( const auto & tile : getTiles() ) {
+        update( tile );
+    }
+}
+
+void TileINode::update( const Tile & tile )
+{
+    if ( ! mImage ) return;
+
+    int halo = mFormat.getHalo();
+    int size = mFormat.getTileSize() + 2 * halo;
+
+    if ( ! mTileSurface || mTileSurface->getWidth() != size ) {
+        mTileSurface = SurfacePool::instance().get( size, size, true );
+        mTileTexture = nullptr;
+    }
+
+    // copy the tile and its halo, clamping to the image edge
+    Surface32f & dst = *mTileSurface;
+    copyClamped( *mImage, tile.bounds.getUL() - tile.offset, dst, ivec2( 0 ), ivec2( size ) );
+
+    if ( ! mTileTexture ) {
+        mTileTexture = gl::Texture2d::create( dst, gl::Texture2d::Format()
+            .internalFormat( mFormat.getInternalFormat() )
+            .minFilter( GL_LINEAR )
+            .magFilter( GL_LINEAR )
+            .wrap( GL_CLAMP_TO_EDGE ) );
+    }
+    else {
+        mTileTexture->update( dst );
+    }
+
+    out< 1 >().update( tile );
+    out< 0 >().update( mTileTexture );
+
+    // the next tile overwrites the texture, so stages that defer their
+    // render, like ColorGradeNode, have to render this one now rather than
+    // once for all tiles when the batch ends
+    auto & deferred = DeferredUpdates::instance();
+    if ( deferred.isDeferring() ) deferred.flush();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TileONode
+
+TileONode::TileONode()
+{
+    in< 0 >().onReceive( [&]( const gl::Texture2dRef & tex ) {
+        update( tex );
+    } );
+    in< 1 >().onReceive( [&]( const Tile & tile ) {
+        mTile = tile;
+        if ( tile.index == 0 ) mComplete = false;
+    } );
+}
+
+void TileONode::update( const gl::Texture2dRef & texture )
+{
+    if ( ! texture || mTile.count == 0 ) return;
+
+    Surface32f rendered( texture->createSource() );
+    Area area( mTile.offset, mTile.offset + mTile.bounds.getSize() );
+
+    if ( mTileFn ) {
+        Surface32fRef tile = SurfacePool::instance().get( area.getWidth(), area.getHeight(), true );
+        copyClamped( rendered, area.getUL(), *tile, ivec2( 0 ), area.getSize() );
+        mTileFn( *tile, mTile.bounds );
+    }
+    else {
+        if ( ! mSurface || mSurface->getSize() != mTile.imageSize ) {
+            mSurface = SurfacePool::instance().get( mTile.imageSize.x, mTile.imageSize.y, true );
+        }
+        copyClamped( rendered, area.getUL(), *mSurface, mTile.bounds.getUL(), area.getSize() );
+    }
+
+    mComplete = mTile.index + 1 == mTile.count;
+}
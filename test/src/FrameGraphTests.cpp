@@ -0,0 +1,537 @@
+#include "cinder/FrameGraph.hpp"
+#include "cinder/framegraph/ColorGradeNode.hpp"
+#include "cinder/framegraph/DeferredUpdates.hpp"
+#include "cinder/framegraph/Filters.hpp"
+#include "cinder/framegraph/Graph.hpp"
+#include "cinder/framegraph/Headless.hpp"
+#include "cinder/framegraph/LUTNode.hpp"
+#include "cinder/framegraph/Regression.hpp"
+#include "cinder/framegraph/Scopes.hpp"
+#include "cinder/framegraph/ShaderCompiler.hpp"
+#include "cinder/framegraph/SurfaceLUTNode.hpp"
+#include "cinder/framegraph/Tiling.hpp"
+#include "cinder/Log.h"
+#include "libnodes/ValueNode.h"
+#if defined( FRAMEGRAPH_TEST_OCIO )
+#include "cinder/framegraph/OCIO.hpp"
+#endif
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+// Renders fixed inputs through the render stages and checks them against
+// the goldens in test/goldens, and their timings against test/timings.json,
+// and checks 3D LUTs on the GPU against the CPU reference. The goldens and
+// timings were rendered on Mesa llvmpipe; other renderers round a little
+// differently, within the default tolerance.
+// Regions of interest are checked to shade exactly their own rows, and the
+// CPU LUT paths to map NaN and infinite pixels into the LUT's domain.
+// Tiled renders through a deferred stage are checked to render every tile.
+// The CPU filters and scopes are checked to give BGRA surfaces the results
+// of RGBA ones.
+// Truncated and corrupt binary graph files are checked to fail to load.
+// Each case has its own source, so its timing is its stage alone.
+//
+//     FrameGraphTests [--goldens <dir>] [--update-goldens] [--baseline <file>] [--timings <file>]
+
+namespace {
+
+const ivec2 SIZE( 64, 32 );
+
+//! A gradient in every channel, the same on every run.
+Surface8u createInput()
+{
+    Surface8u surface( SIZE.x, SIZE.y, true );
+    auto it = surface.getIter();
+    while ( it.line() ) {
+        while ( it.pixel() ) {
+            ivec2 p = it.getPos();
+            it.r() = (uint8_t)( p.x * 4 );
+            it.g() = (uint8_t)( p.y * 8 );
+            it.b() = (uint8_t)( 255 - p.x * 4 );
+            it.a() = 255;
+        }
+    }
+    return surface;
+}
+
+const string VERT = R"EOF(
+#version 150
+
+uniform mat4    ciModelViewProjection;
+uniform mat4    uTexture0Mtx;
+in vec4         ciPosition;
+in vec2         ciTexCoord0;
+out vec2        uv;
+
+void main( void ) {
+    gl_Position = ciModelViewProjection * ciPosition;
+    vec4 texCoord = uTexture0Mtx * vec4( ciTexCoord0, 0., 1. );
+    uv = texCoord.st / texCoord.q;
+}
+)EOF";
+
+const string FRAG_SWIZZLE = R"EOF(
+#version 150
+
+uniform sampler2D   uTexture0;
+in vec2             uv;
+out vec4            oColor;
+
+void main( void ) {
+    vec4 c = texture( uTexture0, uv );
+    oColor = vec4( c.brg, c.a );
+}
+)EOF";
+
+const string FRAG_FILL = R"EOF(
+#version 150
+
+uniform sampler2D   uTexture0;
+uniform vec4        uFill;
+out vec4            oColor;
+
+void main( void ) {
+    oColor = uFill;
+}
+)EOF";
+
+//! Reproduced exactly by either interpolation, so its golden is exact.
+vec3 affine( const vec3 & c )
+{
+    return vec3( 0.25f + 0.5f * c.r, 0.125f + 0.25f * c.r + 0.5f * c.g, 1.f - c.b );
+}
+
+//! Curved and with products of channels, so trilinear and tetrahedral
+//! interpolation differ between lattice points, by up to 0.75 of an 8 bit
+//! step on a 9 point lattice.
+vec3 curved( const vec3 & c )
+{
+    return vec3( std::pow( c.r, 0.8f ) * ( 0.5f + 0.5f * c.g ),
+                 c.g * c.g * ( 3.f - 2.f * c.g ) * ( 0.5f + 0.5f * c.b ),
+                 c.b * ( 0.5f + 0.5f * c.r ) );
+}
+
+Lut3d createLut( int size, vec3 ( *fn )( const vec3 & ) )
+{
+    Lut3d lut( size );
+    float scale = 1.f / ( size - 1 );
+    for ( int b = 0; b < size; ++b ) {
+        for ( int g = 0; g < size; ++g ) {
+            for ( int r = 0; r < size; ++r ) lut.set( r, g, b, fn( vec3( r, g, b ) * scale ) );
+        }
+    }
+    return lut;
+}
+
+//! Checks LUTNode's GPU output against Lut3d's CPU lookup for the same
+//! interpolation, tightly enough that the other interpolation fails. Both
+//! sample a float lattice with float weights, apart from hardware filters
+//! that quantize trilinear weights to 8 bits, which costs a tenth of an 8 bit
+//! step on this LUT.
+bool checkLutAccuracy( const Surface8u & input )
+{
+    const int lutSize = 9;
+    Lut3d lut = createLut( lutSize, curved );
+
+    bool passed = true;
+    for ( auto interpolation : { Lut3d::Interpolation::TRILINEAR, Lut3d::Interpolation::TETRAHEDRAL } ) {
+        bool tetrahedral = interpolation == Lut3d::Interpolation::TETRAHEDRAL;
+        float tolerance = tetrahedral ? 1e-4f : 0.25f / 255.f;
+
+        Surface32f reference( input );
+        lut.apply( reference, interpolation );
+
+        TextureINode src( input );
+        LUTNode node( ivec2( 0 ), LUTNode::Format().texture3d().size( lutSize ).interpolation( interpolation ).internalFormat( GL_RGB32F ) );
+        TextureONode out;
+        node.setOutputFormat( RenderFormat::RGBA32F );
+        node.setLUT( lut );
+        src >> node >> out;
+        src.update();
+
+        string name = tetrahedral ? "lut_accuracy_tetrahedral" : "lut_accuracy_trilinear";
+        if ( ! out.getTexture() ) {
+            CI_LOG_E( name << ": rendered nothing" );
+            passed = false;
+            continue;
+        }
+
+        Surface32f result( out.getTexture()->createSource() );
+        ImageDiff diff = compareImages( result, reference, tolerance );
+        if ( diff.sizeMismatch || diff.numFailing > 0 ) {
+            CI_LOG_E( name << ": " << diff.numFailing << " pixels over " << tolerance << ", max error " << diff.maxError );
+            passed = false;
+        }
+        else {
+            CI_LOG_I( name << ": passed, max error " << diff.maxError );
+        }
+    }
+    return passed;
+}
+
+//! Fills the whole output, then only a region of interest below the top
+//! and above the centre, and checks that exactly the region's rows changed.
+bool checkRegionOfInterest( const Surface8u & input )
+{
+    TextureINode src( input );
+    TextureShaderIONode<> fill( gl::GlslProg::Format().vertex( VERT ).fragment( FRAG_FILL ), ivec2( 0 ) );
+    TextureONode out;
+    src >> fill >> out;
+
+    fill.setUniform( "uFill", vec4( 0.f, 0.f, 0.f, 1.f ) );
+    src.update();
+
+    // rows 8 to 15 of 32
+    fill.setRegionOfInterest( Rectf( 0.f, 0.25f, 1.f, 0.5f ) );
+    fill.setUniform( "uFill", vec4( 1.f ) );
+    src.update();
+
+    if ( ! out.getTexture() ) {
+        CI_LOG_E( "region_of_interest: rendered nothing" );
+        return false;
+    }
+
+    Surface8u result( out.getTexture()->createSource() );
+    for ( int32_t y = 0; y < result.getHeight(); ++y ) {
+        bool inside = y >= SIZE.y / 4 && y < SIZE.y / 2;
+        for ( int32_t x = 0; x < result.getWidth(); ++x ) {
+            ColorA8u c = result.getPixel( ivec2( x, y ) );
+            if ( ( c.r == 255 ) != inside || ( c.r != 0 && c.r != 255 ) ) {
+                CI_LOG_E( "region_of_interest: row " << y << ( inside ? " was not written" : " was written" ) );
+                return false;
+            }
+        }
+    }
+    CI_LOG_I( "region_of_interest: passed" );
+    return true;
+}
+
+//! Keeps the last Surface32f it receives.
+class SurfaceCaptureONode : public Node< Inlets< Surface32fRef >, Outlets<> >
+{
+public:
+    SurfaceCaptureONode()
+    {
+        in< 0 >().onReceive( [&]( const Surface32fRef & surface ) { mSurface = surface; } );
+    }
+
+    const Surface32fRef & getSurface() const { return mSurface; }
+
+private:
+    Surface32fRef   mSurface;
+};
+
+//! Runs NaN and infinite pixels through SurfaceLUTNode's scalar and vector
+//! paths. NaN looks up the bottom of the domain and infinities its ends, as
+//! finite values beyond them do.
+bool checkNonFinite()
+{
+    const float nan = numeric_limits< float >::quiet_NaN();
+    const float inf = numeric_limits< float >::infinity();
+    const vec3 values[] = {
+        vec3( nan, 0.5f, 0.5f ), vec3( 0.5f, nan, 0.5f ), vec3( 0.5f, 0.5f, nan ), vec3( nan ),
+        vec3( inf, 0.5f, -inf ), vec3( -inf, inf, 0.5f ), vec3( inf ), vec3( -inf ),
+        vec3( nan, inf, -inf ), vec3( 2.f, -1.f, 0.25f ), vec3( 0.f ), vec3( 1.f )
+    };
+    const int count = sizeof( values ) / sizeof( values[ 0 ] );
+
+    // wider than a vector, so some pixels take the scalar tail
+    auto image = make_shared< Surface32f >( count + 8 + 3, 1, true );
+    for ( int32_t x = 0; x < image->getWidth(); ++x ) {
+        vec3 v = values[ x % count ];
+        image->setPixel( ivec2( x, 0 ), ColorAf( v.r, v.g, v.b, 1.f ) );
+    }
+
+    auto lut = make_shared< Lut3d >( createLut( 17, affine ) );
+    bool passed = true;
+    for ( auto interpolation : { Lut3d::Interpolation::TRILINEAR, Lut3d::Interpolation::TETRAHEDRAL } ) {
+        for ( bool simd : { false, true } ) {
+            SurfaceINode src( image );
+            SurfaceLUTNode node( SurfaceLUTNode::Format().interpolation( interpolation ).simd( simd ) );
+            SurfaceCaptureONode out;
+            node.setLUT( lut );
+            src >> node >> out;
+            src.update();
+
+            for ( int32_t x = 0; x < image->getWidth() && out.getSurface(); ++x ) {
+                vec3 v = values[ x % count ];
+                vec3 inDomain( v.r == v.r ? v.r : 0.f, v.g == v.g ? v.g : 0.f, v.b == v.b ? v.b : 0.f );
+                vec3 expected = lut->lookup( glm::clamp( inDomain, vec3( 0.f ), vec3( 1.f ) ), interpolation );
+                ColorAf c = out.getSurface()->getPixel( ivec2( x, 0 ) );
+                float error = std::max( std::abs( c.r - expected.r ), std::max( std::abs( c.g - expected.g ), std::abs( c.b - expected.b ) ) );
+                if ( ! ( error <= 1e-5f ) ) {
+                    CI_LOG_E( "non_finite: pixel " << x << " is " << c.r << ", " << c.g << ", " << c.b << " instead of "
+                              << expected.r << ", " << expected.g << ", " << expected.b << ( simd && node.isSimdActive() ? " (AVX2)" : " (scalar)" ) );
+                    passed = false;
+                    break;
+                }
+            }
+            if ( ! out.getSurface() ) {
+                CI_LOG_E( "non_finite: nothing was output" );
+                passed = false;
+            }
+        }
+    }
+    if ( passed ) CI_LOG_I( "non_finite: passed" );
+    return passed;
+}
+
+//! Tiles the input through ColorGradeNode, which defers its renders, inside
+//! a batch, and checks that every tile was graded.
+bool checkTiledDeferred( const Surface8u & input )
+{
+    auto image = make_shared< Surface32f >( input );
+    TileINode tiles( image, TileINode::Format().tileSize( 16 ).internalFormat( GL_RGBA32F ) );
+    ColorGradeNode grader;
+    TileONode sink;
+    nodes::ValueNodef exposure{ -1.f };
+    grader.setOutputFormat( RenderFormat::RGBA32F );
+    exposure >> grader.in< ColorGradeNode::exposure >();
+    tiles >> grader >> sink;
+    tiles.out< 1 >() >> sink.in< 1 >();
+
+    {
+        ScopedDeferredUpdates batch;
+        exposure.update();
+        tiles.update();
+    }
+
+    if ( ! sink.isComplete() || ! sink.getSurface() ) {
+        CI_LOG_E( "tiled_deferred: the last tile never arrived" );
+        return false;
+    }
+
+    Surface32f expected = image->clone();
+    for ( int32_t y = 0; y < expected.getHeight(); ++y ) {
+        for ( int32_t x = 0; x < expected.getWidth(); ++x ) {
+            ColorAf c = expected.getPixel( ivec2( x, y ) );
+            expected.setPixel( ivec2( x, y ), ColorAf( c.r * 0.5f, c.g * 0.5f, c.b * 0.5f, c.a ) );
+        }
+    }
+
+    ImageDiff diff = compareImages( *sink.getSurface(), expected, 1e-3f );
+    if ( diff.sizeMismatch || diff.numFailing > 0 ) {
+        CI_LOG_E( "tiled_deferred: " << diff.numFailing << " pixels not graded, max error " << diff.maxError );
+        return false;
+    }
+    CI_LOG_I( "tiled_deferred: passed" );
+    return true;
+}
+
+//! Copies \a input into a float surface with \a order, pixel by pixel so
+//! the channels land at that order's offsets.
+Surface32f createOrdered( const Surface8u & input, const SurfaceChannelOrder & order )
+{
+    Surface32f surface( input.getWidth(), input.getHeight(), true, order );
+    for ( int32_t y = 0; y < input.getHeight(); ++y ) {
+        for ( int32_t x = 0; x < input.getWidth(); ++x ) {
+            ColorA8u c = input.getPixel( ivec2( x, y ) );
+            surface.setPixel( ivec2( x, y ), ColorAf( c.r / 255.f, c.g / 255.f, c.b / 255.f, c.a / 255.f ) );
+        }
+    }
+    return surface;
+}
+
+//! Runs the CPU filters and scopes on RGBA and BGRA copies of the input,
+//! which must come out the same.
+bool checkChannelOrder( const Surface8u & input )
+{
+    Surface32f rgba = createOrdered( input, SurfaceChannelOrder::RGBA );
+    Surface32f bgra = createOrdered( input, SurfaceChannelOrder::BGRA );
+    bool passed = true;
+
+    for ( auto type : { ScopeType::HISTOGRAM, ScopeType::WAVEFORM, ScopeType::VECTORSCOPE } ) {
+        ScopeNode::Format format( type );
+        if ( ScopeNode::analyze( rgba, format )->counts != ScopeNode::analyze( bgra, format )->counts ) {
+            CI_LOG_E( "channel_order: scope " << (int)type << " of BGRA differs from RGBA" );
+            passed = false;
+        }
+    }
+
+    ImageDiff diff = compareImages( downsampleSurface( rgba ), downsampleSurface( bgra ), 1e-6f );
+    if ( diff.sizeMismatch || diff.numFailing > 0 ) {
+        CI_LOG_E( "channel_order: downsampling BGRA differs from RGBA by up to " << diff.maxError );
+        passed = false;
+    }
+
+    thresholdSurface( rgba, 0.5f );
+    thresholdSurface( bgra, 0.5f );
+    diff = compareImages( rgba, bgra, 1e-6f );
+    if ( diff.sizeMismatch || diff.numFailing > 0 ) {
+        CI_LOG_E( "channel_order: thresholding BGRA differs from RGBA by up to " << diff.maxError );
+        passed = false;
+    }
+
+    if ( passed ) CI_LOG_I( "channel_order: passed" );
+    return passed;
+}
+
+//! Loads every truncation of a binary graph file, one claiming far more
+//! nodes than it holds and one nesting its parameters thousands deep. Each
+//! must throw GraphExc rather than read past the end, allocate for the
+//! claimed count or overflow the stack.
+bool checkTruncatedGraph()
+{
+    GraphDesc desc;
+    desc.nodes.resize( 2 );
+    desc.nodes[ 0 ].id = "grade";
+    desc.nodes[ 0 ].type = "ColorGradeNode";
+    desc.nodes[ 0 ].params = JsonTree::makeObject( "params" )
+        .addChild( JsonTree( "exposure", 0.5 ) )
+        .addChild( JsonTree::makeArray( "lift" ).addChild( JsonTree( "", 0.1 ) ).addChild( JsonTree( "", 0.2 ) ) );
+    desc.nodes[ 1 ].id = "out";
+    desc.nodes[ 1 ].type = "TextureONode";
+    desc.nodes[ 1 ].active = true;
+    desc.connections.push_back( { 0, 0, 1, 0 } );
+
+    ostringstream out;
+    desc.writeBinary( out );
+    const string file = out.str();
+
+    auto loads = []( const string & bytes ) {
+        istringstream in( bytes );
+        try {
+            GraphDesc::readBinary( in );
+            return true;
+        }
+        catch ( const GraphExc & ) {
+            return false;
+        }
+    };
+
+    bool passed = true;
+    if ( ! loads( file ) ) {
+        CI_LOG_E( "truncated_graph: the whole file didn't load" );
+        passed = false;
+    }
+    for ( size_t size = 0; size < file.size(); ++size ) {
+        if ( loads( file.substr( 0, size ) ) ) {
+            CI_LOG_E( "truncated_graph: loaded the first " << size << " of " << file.size() << " bytes" );
+            passed = false;
+            break;
+        }
+    }
+
+    string huge = file;
+    const uint32_t count = 0xffffffff;
+    memcpy( &huge[ 4 ], &count, sizeof( count ) );
+    if ( loads( huge ) ) {
+        CI_LOG_E( "truncated_graph: loaded a file claiming " << count << " nodes" );
+        passed = false;
+    }
+
+    // one node with empty strings, then objects of one child each
+    string deep( file, 0, 4 );
+    const uint32_t one = 1, empty = 0;
+    deep.append( reinterpret_cast< const char * >( &one ), 4 );
+    deep.append( reinterpret_cast< const char * >( &empty ), 4 );
+    deep.append( reinterpret_cast< const char * >( &empty ), 4 );
+    deep.push_back( 0 );
+    for ( int i = 0; i < 100000; ++i ) {
+        deep.push_back( 0 );
+        deep.append( reinterpret_cast< const char * >( &empty ), 4 );
+        deep.append( reinterpret_cast< const char * >( &one ), 4 );
+    }
+    if ( loads( deep ) ) {
+        CI_LOG_E( "truncated_graph: loaded parameters nested 100000 deep" );
+        passed = false;
+    }
+
+    if ( passed ) CI_LOG_I( "truncated_graph: passed" );
+    return passed;
+}
+
+}
+
+int main( int argc, char * argv[] )
+{
+    fs::path goldens = FRAMEGRAPH_TEST_GOLDENS;
+    fs::path baseline = FRAMEGRAPH_TEST_BASELINE;
+    fs::path timings;
+    bool updateGoldens = false;
+    for ( int i = 1; i < argc; ++i ) {
+        if ( strcmp( argv[ i ], "--goldens" ) == 0 && i + 1 < argc )        goldens = argv[ ++i ];
+        else if ( strcmp( argv[ i ], "--baseline" ) == 0 && i + 1 < argc )  baseline = argv[ ++i ];
+        else if ( strcmp( argv[ i ], "--timings" ) == 0 && i + 1 < argc )   timings = argv[ ++i ];
+        else if ( strcmp( argv[ i ], "--update-goldens" ) == 0 )            updateGoldens = true;
+        else {
+            cerr << "usage: " << argv[ 0 ] << " [--goldens <dir>] [--update-goldens] [--baseline <file>] [--timings <file>]" << endl;
+            return 2;
+        }
+    }
+
+    HeadlessContextRef context;
+    try {
+        context = HeadlessContext::create();
+    }
+    catch ( const HeadlessContextExc & e ) {
+        CI_LOG_EXCEPTION( "Unable to create a headless context", e );
+        return 1;
+    }
+    CI_LOG_I( "Rendering with " << context->getRenderer() );
+
+    Surface8u input = createInput();
+
+    // compiled on the test's context rather than a shared one
+    ShaderCompiler::instance().setEnabled( false );
+
+    TextureShaderIONode<> swizzle( gl::GlslProg::Format().vertex( VERT ).fragment( FRAG_SWIZZLE ), ivec2( 0 ) );
+    TextureINode swizzleSrc( input );
+    TextureONode swizzleOut;
+    swizzleSrc >> swizzle >> swizzleOut;
+
+    const int lutSize = 17;
+    LUTNode lut( ivec2( 0 ), LUTNode::Format().texture3d().size( lutSize ).internalFormat( GL_RGB32F ) );
+    TextureINode lutSrc( input );
+    TextureONode lutOut;
+    lut.setLUT( createLut( lutSize, affine ) );
+    lutSrc >> lut >> lutOut;
+
+    ColorGradeNode grader;
+    TextureINode graderSrc( input );
+    TextureONode graderOut;
+    nodes::ValueNodef exposure{ -1.f };
+    nodes::ValueNodef contrast{ -0.5f };
+    exposure >> grader.in< ColorGradeNode::exposure >();
+    contrast >> grader.in< ColorGradeNode::contrast >();
+    graderSrc >> grader >> graderOut;
+    exposure.update();
+    contrast.update();
+
+    // the cases take a fraction of a millisecond, which jitters on shared
+    // CI machines, so only gross slowdowns fail
+    RegressionSuite suite( RegressionSuite::Format().goldens( goldens ).failures( fs::current_path() ).updateGoldens( updateGoldens )
+                                   .baseline( baseline, 4.f ).warmup( 1 ).iterations( 10 ) );
+    suite.add( "quad_swizzle", [&] { swizzleSrc.update(); return swizzleOut.getTexture(); } );
+    suite.add( "lut3d_affine", [&] { lutSrc.update(); return lutOut.getTexture(); } );
+    suite.add( "color_grade", [&] { graderSrc.update(); return graderOut.getTexture(); } );
+
+#if defined( FRAMEGRAPH_TEST_OCIO )
+    ocio::Config config( FRAMEGRAPH_TEST_OCIO_CONFIG );
+    ocio::ProcessGPUIONode display( config );
+    TextureINode displaySrc( input );
+    TextureONode displayOut;
+    displaySrc >> display >> displayOut;
+    suite.add( "ocio_display", [&] { displaySrc.update(); return displayOut.getTexture(); } );
+#endif
+
+    bool passed = suite.run();
+    if ( ! timings.empty() ) suite.writeTimings( timings );
+
+    passed = checkLutAccuracy( input ) && passed;
+    passed = checkRegionOfInterest( input ) && passed;
+    passed = checkNonFinite() && passed;
+    passed = checkTiledDeferred( input ) && passed;
+    passed = checkChannelOrder( input ) && passed;
+    passed = checkTruncatedGraph() && passed;
+
+    cout << ( passed ? "PASSED" : "FAILED" ) << endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+#include "cinder/framegraph/SurfaceLUTNode.hpp"
+#include "cinder/framegraph/ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace ci;
+using namespace frame_graph;
+using namespace std;
+
+// Measures SurfaceLUTNode's throughput in megapixels per second, for each
+// interpolation with and without a 1D shaper, on the scalar and the AVX2
+// paths. Not part of ctest, timings depend on the machine.
+//
+//     SurfaceLUTBenchmark [--size <width> <height>] [--lut <points>] [--frames <n>]
+
+namespace {
+
+Surface32fRef createNoise( int32_t width, int32_t height )
+{
+    auto surface = make_shared< Surface32f >( width, height, true );
+    mt19937 rng( 1 );
+    uniform_real_distribution< float > dist( 0.f, 1.f );
+    for ( int32_t y = 0; y < height; ++y ) {
+        float * p = surface->getData( ivec2( 0, y ) );
+        for ( int32_t x = 0; x < width * 4; ++x ) p[ x ] = dist( rng );
+    }
+    return surface;
+}
+
+Lut3dRef createLut3d( int size )
+{
+    auto lut = make_shared< Lut3d >( Lut3d::createIdentity( size ) );
+    for ( float & v : lut->getData() ) v = v * v * ( 3.f - 2.f * v );
+    return lut;
+}
+
+Lut1dRef createLut1d( int size )
+{
+    auto lut = make_shared< Lut1d >( size );
+    for ( int i = 0; i < size; ++i ) {
+        float v = std::pow( (float)i / ( size - 1 ), 1.f / 2.2f );
+        lut->set( i, vec3( v ) );
+    }
+    return lut;
+}
+
+//! The median throughput of \a frames runs, after one to warm up.
+double measure( SurfaceLUTNode & node, const Surface32fRef & image, int frames )
+{
+    node.update( image );
+    vector< double > rates;
+    for ( int i = 0; i < frames; ++i ) {
+        node.update( image );
+        rates.push_back( node.getMegapixelsPerSecond() );
+    }
+    sort( rates.begin(), rates.end() );
+    return rates[ rates.size() / 2 ];
+}
+
+}
+
+int main( int argc, char * argv[] )
+{
+    ivec2 size( 1920, 1080 );
+    int lutSize = 33;
+    int frames = 20;
+    for ( int i = 1; i < argc; ++i ) {
+        if ( strcmp( argv[ i ], "--size" ) == 0 && i + 2 < argc ) {
+            size.x = atoi( argv[ ++i ] );
+            size.y = atoi( argv[ ++i ] );
+        }
+        else if ( strcmp( argv[ i ], "--lut" ) == 0 && i + 1 < argc )       lutSize = atoi( argv[ ++i ] );
+        else if ( strcmp( argv[ i ], "--frames" ) == 0 && i + 1 < argc )    frames = atoi( argv[ ++i ] );
+        else {
+            cerr << "usage: " << argv[ 0 ] << " [--size <width> <height>] [--lut <points>] [--frames <n>]" << endl;
+            return 2;
+        }
+    }
+    if ( size.x <= 0 || size.y <= 0 || lutSize < 2 || frames < 1 ) {
+        cerr << "invalid arguments" << endl;
+        return 2;
+    }
+
+    auto image = createNoise( size.x, size.y );
+    auto lut3d = createLut3d( lutSize );
+    auto lut1d = createLut1d( 1024 );
+
+    cout << size.x << "x" << size.y << ", " << lutSize << " point LUT, " << ThreadPool::instance().getNumThreads() << " threads, median of " << frames << " frames" << endl;
+    cout << left << setw( 14 ) << "interpolation" << setw( 8 ) << "shaper" << setw( 8 ) << "path" << "MP/s" << endl;
+
+    for ( auto interpolation : { Lut3d::Interpolation::TRILINEAR, Lut3d::Interpolation::TETRAHEDRAL } ) {
+        for ( bool shaper : { false, true } ) {
+            for ( bool simd : { false, true } ) {
+                SurfaceLUTNode node( SurfaceLUTNode::Format().interpolation( interpolation ).simd( simd ) );
+                if ( simd && ! node.isSimdActive() ) continue;
+
+                node.setLUT( lut3d );
+                if ( shaper ) node.setLUT( lut1d );
+
+                double rate = measure( node, image, frames );
+                cout << left << setw( 14 ) << ( interpolation == Lut3d::Interpolation::TETRAHEDRAL ? "tetrahedral" : "trilinear" )
+                     << setw( 8 ) << ( shaper ? "1D" : "-" ) << setw( 8 ) << ( simd ? "AVX2" : "scalar" )
+                     << fixed << setprecision( 1 ) << rate << endl;
+            }
+        }
+    }
+    return 0;
+}